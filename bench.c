@@ -0,0 +1,435 @@
+//性能测试：在生成的JSON语料上测量解析、生成、校验和压缩的吞吐量，以及 lept_compact 前后的遍历速度和驻留内存、快照的打开耗时
+//用法：bench [-n 名称] [-o 结果文件] [-b 基准结果文件] [--train]
+//  -o 把结果保存到文件，-b 读取基准结果并输出加速比，--train 只跑少量迭代，用于PGO收集profile
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "leptjson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+//每项测试至少运行的时间，秒
+#define BENCH_MIN_SECONDS 0.5
+//测量驻留内存时保留的语料份数
+#define BENCH_RSS_COPIES 16
+
+//可增长的文本缓冲区，用于生成语料
+typedef struct
+{
+	char* s;
+	size_t len, cap;
+}bench_buffer;
+
+static void bench_put(bench_buffer* b, const char* s, size_t len)
+{
+	if (b->len + len + 1 > b->cap)
+	{
+		while (b->len + len + 1 > b->cap)
+			b->cap = b->cap == 0 ? 4096 : b->cap * 2;
+		b->s = (char*)realloc(b->s, b->cap);
+	}
+	memcpy(b->s + b->len, s, len);
+	b->len += len;
+	b->s[b->len] = '\0';
+}
+
+static void bench_puts(bench_buffer* b, const char* s)
+{
+	bench_put(b, s, strlen(s));
+}
+
+//固定种子的线性同余随机数，保证每次生成的语料相同
+static unsigned bench_seed = 12345;
+static unsigned bench_rand(void)
+{
+	bench_seed = bench_seed * 1103515245u + 12345u;
+	return (bench_seed >> 8) & 0xFFFFFF;
+}
+
+//数字为主：类似地理数据的坐标数组
+static void bench_gen_numbers(bench_buffer* b)
+{
+	char buf[64];
+	int i;
+	bench_puts(b, "{\"type\":\"Polygon\",\"coordinates\":[");
+	for (i = 0; i < 60000; i++)
+	{
+		sprintf(buf, "%s[%.15g,%.15g]", i ? "," : "", -180.0 + bench_rand() * (360.0 / 0xFFFFFF), -90.0 + bench_rand() * (180.0 / 0xFFFFFF));
+		bench_puts(b, buf);
+	}
+	bench_puts(b, "]}");
+}
+
+//字符串为主：类似消息流的对象数组，包含转义和非ASCII字符
+static void bench_gen_strings(bench_buffer* b)
+{
+	static const char* words[] = { "json", "lepton", "parser", "\\\"quoted\\\"", "line\\nbreak", "\xE4\xB8\xAD\xE6\x96\x87", "emoji \\uD83D\\uDE00", "tab\\tbed", "plain", "text" };
+	char buf[64];
+	int i, j, n;
+	bench_puts(b, "[");
+	for (i = 0; i < 8000; i++)
+	{
+		sprintf(buf, "%s{\"id\":%u,\"user\":\"user_%u\",\"text\":\"", i ? "," : "", bench_rand(), bench_rand() % 1000);
+		bench_puts(b, buf);
+		for (j = 0, n = 5 + bench_rand() % 20; j < n; j++)
+		{
+			if (j)
+				bench_puts(b, " ");
+			bench_puts(b, words[bench_rand() % (sizeof(words) / sizeof(words[0]))]);
+		}
+		bench_puts(b, "\",\"lang\":\"zh\",\"retweeted\":false,\"reply_to\":null}");
+	}
+	bench_puts(b, "]");
+}
+
+//结构为主：多层嵌套的配置对象，带有空白和缩进
+static void bench_gen_nested(bench_buffer* b, int depth)
+{
+	char buf[64];
+	int i, n = depth > 0 ? 6 : 4;
+	bench_puts(b, "{\n");
+	for (i = 0; i < n; i++)
+	{
+		sprintf(buf, "%s  \"key%d_%u\": ", i ? ",\n" : "", i, bench_rand() % 100);
+		bench_puts(b, buf);
+		if (depth > 0 && i < 4)
+			bench_gen_nested(b, depth - 1);
+		else switch (bench_rand() % 4)
+		{
+		case 0: sprintf(buf, "%u", bench_rand()); bench_puts(b, buf); break;
+		case 1: bench_puts(b, "true"); break;
+		case 2: bench_puts(b, "[1, 2.5, \"x\", null]"); break;
+		default: bench_puts(b, "\"value\""); break;
+		}
+	}
+	bench_puts(b, "\n}");
+}
+
+//丢弃流式输出
+static void bench_discard(void* user, const char* data, size_t len)
+{
+	*(size_t*)user += len;
+	(void)data;
+}
+
+//遍历整棵树，读取每个数字、字符串和key，对应查表和导出配置的访问方式
+static double bench_traverse(const lept_value* v)
+{
+	double sum = 0.0;
+	const double* d;
+	size_t i, n;
+	switch (lept_get_type(v))
+	{
+	case LEPT_NUMBER:
+		return lept_get_number(v);
+	case LEPT_STRING:
+		return (double)(unsigned char)lept_get_string(v)[0] + (double)lept_get_string_length(v);
+	case LEPT_ARRAY:
+		if ((d = lept_get_array_doubles(v, &n)) != NULL)	//紧凑数字数组直接读 double[]
+		{
+			for (i = 0; i < n; i++)
+				sum += d[i];
+			return sum;
+		}
+		for (i = 0; i < lept_get_array_size(v); i++)
+			sum += bench_traverse(lept_get_array_element(v, i));
+		return sum;
+	case LEPT_OBJECT:
+		for (i = 0; i < lept_get_object_size(v); i++)
+			sum += (double)(unsigned char)lept_get_object_key(v, i)[0] + bench_traverse(lept_get_object_value(v, i));
+		return sum;
+	default:
+		return 1.0;
+	}
+}
+
+//防止遍历的结果被优化掉
+static volatile double bench_sink;
+
+//lept_diff 比较的另一棵树：语料的副本，只改了最后一个叶子
+static const lept_value* bench_diff_target;
+
+static void bench_touch_last(lept_value* v)
+{
+	while (lept_get_type(v) == LEPT_ARRAY || lept_get_type(v) == LEPT_OBJECT)
+		v = lept_get_type(v) == LEPT_ARRAY ? lept_get_array_element(v, lept_get_array_size(v) - 1)
+			: lept_get_object_value(v, lept_get_object_size(v) - 1);
+	lept_set_number(v, lept_get_type(v) == LEPT_NUMBER ? lept_get_number(v) + 1 : 0.0);
+}
+
+enum { BENCH_PARSE, BENCH_STRINGIFY, BENCH_CANONICAL, BENCH_VALIDATE, BENCH_MINIFY, BENCH_LAZY, BENCH_PASSTHRU,
+	BENCH_TRAVERSE, BENCH_TRAVERSE_DFS, BENCH_TRAVERSE_BFS, BENCH_DIFF, BENCH_PACK, BENCH_TRAVERSE_PACK, BENCH_OP_COUNT };
+static const char* bench_op_names[BENCH_OP_COUNT] = { "parse", "stringify", "canonical", "validate", "minify", "lazy", "passthru",
+	"traverse", "trav_dfs", "trav_bfs", "diff", "pack", "trav_pack" };
+
+//执行一次测试，返回处理的字节数
+static size_t bench_run_once(int op, const char* json, size_t len, const lept_value* v)
+{
+	lept_value temp;
+	lept_writer w;
+	size_t out = 0;
+	switch (op)
+	{
+	case BENCH_PARSE:
+		lept_init(&temp);
+		if (lept_parse(&temp, json) != LEPT_PARSE_OK)
+			abort();
+		lept_free(&temp);
+		break;
+	case BENCH_STRINGIFY:
+		free(lept_stringify(v, &out));
+		break;
+	case BENCH_CANONICAL:
+		free(lept_stringify_canonical(v, &out));
+		break;
+	case BENCH_VALIDATE:
+		if (lept_validate(json, len, NULL) != LEPT_PARSE_OK)
+			abort();
+		break;
+	case BENCH_MINIFY:
+		w.write = bench_discard;
+		w.user = &out;
+		if (lept_minify(json, len, &w) != LEPT_PARSE_OK)
+			abort();
+		break;
+	case BENCH_LAZY:		//延迟解码的解析
+	case BENCH_PASSTHRU:	//延迟解码的解析加原样输出，对应转发不读取的场景
+	case BENCH_PACK:		//数字数组存为 double[] 的解析
+		lept_init(&temp);
+		if (lept_parse_ex(&temp, json, op == BENCH_PACK ? LEPT_FLAG_PACK_NUMBERS : LEPT_FLAG_LAZY) != LEPT_PARSE_OK)
+			abort();
+		if (op == BENCH_PASSTHRU)
+			free(lept_stringify(&temp, &out));
+		lept_free(&temp);
+		break;
+	case BENCH_TRAVERSE:		//解析得到的树，以下两项是同一棵树 lept_compact 之后，最后一项是 LEPT_FLAG_PACK_NUMBERS 解析的树
+	case BENCH_TRAVERSE_DFS:
+	case BENCH_TRAVERSE_BFS:
+	case BENCH_TRAVERSE_PACK:
+		bench_sink = bench_traverse(v);
+		break;
+	case BENCH_DIFF:		//几乎相同的两棵树，只应产生一个操作
+		lept_init(&temp);
+		lept_diff(v, bench_diff_target, &temp);
+		if (lept_get_array_size(&temp) != 1)
+			abort();
+		lept_free(&temp);
+		break;
+	}
+	return len;
+}
+
+#ifdef __linux__
+//当前进程的驻留内存，KB
+static long bench_rss_kb(void)
+{
+	long size = 0, resident = 0;
+	FILE* fp = fopen("/proc/self/statm", "r");
+	if (fp == NULL)
+		return 0;
+	if (fscanf(fp, "%ld %ld", &size, &resident) != 2)
+		resident = 0;
+	fclose(fp);
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+//在子进程中保留count份语料的节点树，返回驻留内存的增量（KB），失败时返回-1。
+//flags传给 lept_parse_ex；order为-1时保持解析的结果，否则每份解析后立即按该顺序 lept_compact
+static long bench_rss(const char* json, int count, int flags, int order)
+{
+	int fd[2], i;
+	long kb = -1;
+	pid_t pid;
+	if (pipe(fd) != 0)
+		return -1;
+	if ((pid = fork()) == 0)
+	{
+		lept_value* trees = (lept_value*)malloc(count * sizeof(lept_value));
+		long before = bench_rss_kb();
+		for (i = 0; i < count; i++)
+		{
+			lept_init(&trees[i]);
+			if (lept_parse_ex(&trees[i], json, flags) != LEPT_PARSE_OK)
+				_exit(1);
+			if (order >= 0)
+				lept_compact(&trees[i], order);
+		}
+		kb = bench_rss_kb() - before;
+		if (write(fd[1], &kb, sizeof(kb)) != sizeof(kb))
+			_exit(1);
+		_exit(0);
+	}
+	close(fd[1]);
+	if (pid < 0 || read(fd[0], &kb, sizeof(kb)) != sizeof(kb))
+		kb = -1;
+	close(fd[0]);
+	if (pid > 0)
+		waitpid(pid, NULL, 0);
+	return kb;
+}
+#endif
+
+//快照的启动耗时：打开（映射并读取根节点）与解析同一份语料相比，返回平均每次打开的微秒数，失败时返回-1
+static double bench_snapshot(const lept_value* v, const char* path, double* parse_ms, double min_seconds)
+{
+	lept_snapshot* snap;
+	lept_value temp;
+	clock_t start;
+	long count = 0;
+	char* json;
+	if (lept_snapshot_write(v, path) != LEPT_SNAPSHOT_OK)
+		return -1.0;
+	json = lept_stringify(v, NULL);
+	start = clock();
+	lept_init(&temp);
+	lept_parse(&temp, json);
+	*parse_ms = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+	lept_free(&temp);
+	free(json);
+	start = clock();
+	do
+	{
+		if (lept_snapshot_open(&snap, path) != LEPT_SNAPSHOT_OK)
+			return -1.0;
+		bench_sink = (double)lept_snap_get_type(lept_snapshot_root(snap));
+		lept_snapshot_close(snap);
+		count++;
+	} while ((double)(clock() - start) / CLOCKS_PER_SEC < min_seconds);
+	remove(path);
+	return (double)(clock() - start) * 1e6 / CLOCKS_PER_SEC / count;
+}
+
+//重复运行直到超过最短时间，返回MB/s
+static double bench_run(int op, const char* json, size_t len, const lept_value* v, double min_seconds)
+{
+	clock_t start = clock(), elapsed;
+	double bytes = 0;
+	do
+	{
+		bytes += (double)bench_run_once(op, json, len, v);
+		elapsed = clock() - start;
+	} while ((double)elapsed / CLOCKS_PER_SEC < min_seconds);
+	return bytes / (1024.0 * 1024.0) / ((double)elapsed / CLOCKS_PER_SEC);
+}
+
+//在基准结果文件中查找同一项测试的吞吐量，找不到时返回0
+static double bench_lookup(const char* path, const char* corpus, const char* op)
+{
+	char c[64], o[64];
+	double mbs;
+	FILE* fp;
+	if (path == NULL || (fp = fopen(path, "r")) == NULL)
+		return 0.0;
+	while (fscanf(fp, "%63s %63s %lf", c, o, &mbs) == 3)
+		if (strcmp(c, corpus) == 0 && strcmp(o, op) == 0)
+		{
+			fclose(fp);
+			return mbs;
+		}
+	fclose(fp);
+	return 0.0;
+}
+
+int main(int argc, char* argv[])
+{
+	static const char* corpus_names[] = { "numbers", "strings", "nested" };
+	const char* name = "default", * save = NULL, * baseline = NULL;
+	double min_seconds = BENCH_MIN_SECONDS, mbs, base;
+	bench_buffer corpus[3];
+	lept_value v, dfs, bfs, modified, packed;
+	const lept_value* tree;
+	FILE* out = NULL;
+	int i, op;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) name = argv[++i];
+		else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) save = argv[++i];
+		else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) baseline = argv[++i];
+		else if (strcmp(argv[i], "--train") == 0) min_seconds = 0.0;
+		else
+		{
+			fprintf(stderr, "usage: %s [-n name] [-o result] [-b baseline] [--train]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	memset(corpus, 0, sizeof(corpus));
+	bench_gen_numbers(&corpus[0]);
+	bench_gen_strings(&corpus[1]);
+	bench_puts(&corpus[2], "[");
+	for (i = 0; i < 12; i++)
+	{
+		if (i)
+			bench_puts(&corpus[2], ",\n");
+		bench_gen_nested(&corpus[2], 5);
+	}
+	bench_puts(&corpus[2], "]");
+
+	if (save && (out = fopen(save, "w")) == NULL)
+	{
+		fprintf(stderr, "cannot write %s\n", save);
+		return 1;
+	}
+	for (i = 0; i < 3; i++)
+	{
+		lept_init(&v);
+		if (lept_parse(&v, corpus[i].s) != LEPT_PARSE_OK)
+		{
+			fprintf(stderr, "corpus %s does not parse\n", corpus_names[i]);
+			return 1;
+		}
+		lept_init(&dfs);
+		lept_copy(&dfs, &v);
+		lept_compact(&dfs, LEPT_ORDER_DEPTH_FIRST);
+		lept_init(&bfs);
+		lept_copy(&bfs, &v);
+		lept_compact(&bfs, LEPT_ORDER_BREADTH_FIRST);
+		lept_init(&modified);
+		lept_copy(&modified, &v);
+		bench_touch_last(&modified);
+		bench_diff_target = &modified;
+		lept_init(&packed);
+		lept_parse_ex(&packed, corpus[i].s, LEPT_FLAG_PACK_NUMBERS);
+		for (op = 0; op < BENCH_OP_COUNT; op++)
+		{
+			tree = op == BENCH_TRAVERSE_DFS ? &dfs : op == BENCH_TRAVERSE_BFS ? &bfs : op == BENCH_TRAVERSE_PACK ? &packed : &v;
+			mbs = bench_run(op, corpus[i].s, corpus[i].len, tree, min_seconds);
+			if (min_seconds == 0.0)
+				continue;
+			printf("%-12s %-8s %-10s %9.1f MB/s", name, corpus_names[i], bench_op_names[op], mbs);
+			if ((base = bench_lookup(baseline, corpus_names[i], bench_op_names[op])) > 0.0)
+				printf("  x%.2f", mbs / base);
+			printf("\n");
+			if (out)
+				fprintf(out, "%s %s %.3f\n", corpus_names[i], bench_op_names[op], mbs);
+		}
+#ifdef __linux__
+		//驻留内存只输出不保存，与编译选项无关
+		if (min_seconds > 0.0)
+			printf("%-12s %-8s rss x%d     parsed %ld KB, dfs %ld KB, bfs %ld KB, packed %ld KB\n", name, corpus_names[i], BENCH_RSS_COPIES,
+				bench_rss(corpus[i].s, BENCH_RSS_COPIES, 0, -1), bench_rss(corpus[i].s, BENCH_RSS_COPIES, 0, LEPT_ORDER_DEPTH_FIRST),
+				bench_rss(corpus[i].s, BENCH_RSS_COPIES, 0, LEPT_ORDER_BREADTH_FIRST),
+				bench_rss(corpus[i].s, BENCH_RSS_COPIES, LEPT_FLAG_PACK_NUMBERS, -1));
+#endif
+		if (min_seconds > 0.0)
+		{
+			double parse_ms = 0.0, open_us = bench_snapshot(&v, "bench_snapshot.bin", &parse_ms, min_seconds);
+			printf("%-12s %-8s snapshot   open %.1f us, parse %.1f ms\n", name, corpus_names[i], open_us, parse_ms);
+		}
+		lept_free(&packed);
+		lept_free(&modified);
+		lept_free(&bfs);
+		lept_free(&dfs);
+		lept_free(&v);
+		free(corpus[i].s);
+	}
+	if (out)
+		fclose(out);
+	return 0;
+}
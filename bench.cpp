@@ -0,0 +1,102 @@
+//C++封装的性能测试：遍历同一棵树，比较 leptjson.hpp 与直接调用C接口的耗时
+#include "leptjson.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+//每项测试重复的次数
+static const int BENCH_REPEAT = 50;
+
+template <typename F>
+static double bench_ns(F&& f, std::size_t n, double& result)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < BENCH_REPEAT; i++)
+		result += f();
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / BENCH_REPEAT / n;
+}
+
+static void bench_report(const char* name, double ns, double base)
+{
+	std::printf("%-24s %7.3f ns/element  x%.2f\n", name, ns, base / ns);
+}
+
+int main()
+{
+	const std::size_t n = 1000000;
+	std::string json = "[";
+	for (std::size_t i = 0; i < n; i++)
+	{
+		if (i)
+			json += ',';
+		json += (i & 1) ? "\"value_" + std::to_string(i) + "\"" : std::to_string(i * 0.5);
+	}
+	json += ']';
+
+	lept::value v;
+	if (v.parse(json.c_str()) != LEPT_PARSE_OK)
+		return 1;
+	const lept_value* c = v.c_ptr();
+	double sink = 0, base;
+
+	//数字：C接口逐个取元素 vs range-for
+	base = bench_ns([&] {
+		double sum = 0;
+		for (std::size_t i = 0, size = lept_get_array_size(c); i < size; i++)
+		{
+			const lept_value* e = lept_get_array_element(c, i);
+			if (lept_get_type(e) == LEPT_NUMBER)
+				sum += lept_get_number(e);
+		}
+		return sum;
+	}, n, sink);
+	bench_report("C numbers", base, base);
+	bench_report("C++ numbers", bench_ns([&] {
+		double sum = 0;
+		for (const lept::value& e : v)
+			if (e.is_number())
+				sum += e.get_number();
+		return sum;
+	}, n, sink), base);
+
+	//字符串：strlen vs 长度接口 vs string_view
+	base = bench_ns([&] {
+		std::size_t len = 0;
+		for (std::size_t i = 0, size = lept_get_array_size(c); i < size; i++)
+		{
+			const lept_value* e = lept_get_array_element(c, i);
+			if (lept_get_type(e) == LEPT_STRING)
+				len += std::strlen(lept_get_string(e));
+		}
+		return (double)len;
+	}, n, sink);
+	bench_report("C strings (strlen)", base, base);
+	bench_report("C strings (length)", bench_ns([&] {
+		std::size_t len = 0;
+		for (std::size_t i = 0, size = lept_get_array_size(c); i < size; i++)
+		{
+			const lept_value* e = lept_get_array_element(c, i);
+			if (lept_get_type(e) == LEPT_STRING)
+				len += lept_get_string_length(e);
+		}
+		return (double)len;
+	}, n, sink), base);
+	bench_report("C++ strings", bench_ns([&] {
+		std::size_t len = 0;
+		for (const lept::value& e : v)
+			if (e.is_string())
+				len += e.get_string().size();
+		return (double)len;
+	}, n, sink), base);
+
+	//移动整棵树：O(1)，与树的大小无关
+	base = bench_ns([&] {
+		lept::value moved(std::move(v));
+		v = std::move(moved);
+		return 0.0;
+	}, 1, sink);
+	std::printf("%-24s %7.3f ns\n", "C++ move (whole tree)", base);
+	return sink == 0.0;
+}
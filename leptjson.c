@@ -1,6 +1,11 @@
 ﻿//高版本的VS不让使用较低版本的函数，定义该宏可以忽视警告
 #define _CRT_SECURE_NO_WARNINGS			
 
+//统计计时使用clock_gettime
+#if defined(LEPT_ENABLE_STATS) && !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199309L
+#endif
+
 //用以检测Windows上的code是否有内存泄漏
 #ifdef _WINDOWS
 #define _CRTDBG_MAP_ALLOC
@@ -15,16 +20,117 @@
 #include <string.h>		// memcpy() 
 #include <stdio.h>		// sprintf() 
 
+//支持SSE2时，字符串扫描一次检查16个字节；定义LEPT_NO_SIMD可关闭
+#if !defined(LEPT_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define LEPT_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+static int lept_ctz(unsigned x) { unsigned long i; _BitScanForward(&i, x); return (int)i; }
+#else
+#define lept_ctz(x) __builtin_ctz(x)
+#endif
+#endif
+
+//原子操作，用于只读文档的引用计数和文档槽的自旋锁
+#ifdef _MSC_VER
+#include <intrin.h>
+#define lept_atomic_inc(p)			_InterlockedIncrement(p)
+#define lept_atomic_dec(p)			_InterlockedDecrement(p)
+#define lept_atomic_load(p)			_InterlockedOr(p, 0)
+#define lept_atomic_lock(p)			_InterlockedExchange(p, 1)
+#define lept_atomic_unlock(p)		_InterlockedExchange(p, 0)
+#else
+#define lept_atomic_inc(p)			__atomic_add_fetch(p, 1, __ATOMIC_RELAXED)
+#define lept_atomic_dec(p)			__atomic_sub_fetch(p, 1, __ATOMIC_ACQ_REL)
+#define lept_atomic_load(p)			__atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define lept_atomic_lock(p)			__atomic_exchange_n(p, 1, __ATOMIC_ACQUIRE)
+#define lept_atomic_unlock(p)		__atomic_store_n(p, 0, __ATOMIC_RELEASE)
+#endif
+
+//解析统计：每个线程一份计数，关闭时所有LEPT_STAT_*宏展开为空
+#ifdef LEPT_ENABLE_STATS
+#ifdef _WIN32
+#include <windows.h>
+#define LEPT_THREAD_LOCAL __declspec(thread)
+#else
+#include <time.h>
+#define LEPT_THREAD_LOCAL __thread
+#endif
+
+static LEPT_THREAD_LOCAL lept_stats lept_stats_tls;
+static LEPT_THREAD_LOCAL int lept_stats_phase = -1;		//当前阶段，-1表示不在任何阶段
+static LEPT_THREAD_LOCAL uint64_t lept_stats_since;		//进入当前阶段的时刻
+
+static uint64_t lept_stats_now(void)
+{
+#ifdef _WIN32
+	static LARGE_INTEGER freq;
+	LARGE_INTEGER t;
+	if (freq.QuadPart == 0)
+		QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&t);
+	return (uint64_t)(t.QuadPart / freq.QuadPart * 1000000000 + t.QuadPart % freq.QuadPart * 1000000000 / freq.QuadPart);
+#else
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec * 1000000000 + (uint64_t)t.tv_nsec;
+#endif
+}
+
+//切换到phase，把上一阶段经过的时间计入上一阶段，返回上一阶段以便恢复
+static int lept_stats_enter(int phase)
+{
+	uint64_t now = lept_stats_now();
+	int prev = lept_stats_phase;
+	if (prev >= 0)
+		lept_stats_tls.phase_ns[prev] += now - lept_stats_since;
+	lept_stats_since = now;
+	lept_stats_phase = phase;
+	return prev;
+}
+
+#define LEPT_STAT_ADD(field, n)		(lept_stats_tls.field += (n))
+#define LEPT_STAT_MAX(field, n)		do { if (lept_stats_tls.field < (n)) lept_stats_tls.field = (n); } while(0)
+#define LEPT_STAT_PHASE_DECL		int lept_stats_prev
+#define LEPT_STAT_ENTER(phase)		(lept_stats_prev = lept_stats_enter(phase))
+#define LEPT_STAT_LEAVE()			lept_stats_enter(lept_stats_prev)
+#else
+#define LEPT_STAT_ADD(field, n)		((void)0)
+#define LEPT_STAT_MAX(field, n)		((void)0)
+#define LEPT_STAT_PHASE_DECL
+#define LEPT_STAT_ENTER(phase)		((void)0)
+#define LEPT_STAT_LEAVE()			((void)0)
+#endif
+
 //解析JSON的字符串时，初始给栈分配的内存空间
 #ifndef LEPT_PARSE_STACK_INIT_SIZE
 #define LEPT_PARSE_STACK_INIT_SIZE 256
 #endif 
 
+//LEPT_FLAG_LARGE_STRINGS：原文不短于该字节数的字符串直接解码到节点的字符串中
+#ifndef LEPT_LARGE_STRING_SIZE
+#define LEPT_LARGE_STRING_SIZE 4096
+#endif
+
+//比较对象是否相等时，成员个数超过该值就为其中一个对象建立临时的哈希索引
+#ifndef LEPT_EQUAL_HASH_THRESHOLD
+#define LEPT_EQUAL_HASH_THRESHOLD 16
+#endif
+#if LEPT_EQUAL_HASH_THRESHOLD > 64
+#error "LEPT_EQUAL_HASH_THRESHOLD must not exceed 64: the linear comparison marks matched members in a uint64_t"
+#endif
+
 //生成JSON时，初始给栈分配的内存空间
 #ifndef LEPT_PARSE_STRINGIFY_INT_SIZE
 #define LEPT_PARSE_STRINGIFY_INT_SIZE 256
 #endif
 
+//lept_stringify_cached只缓存输出不小于该字节数的数组/对象，较小的子树重新生成比维护缓存更便宜
+#ifndef LEPT_STRINGIFY_CACHE_MIN_SIZE
+#define LEPT_STRINGIFY_CACHE_MIN_SIZE 256
+#endif
+
 //JSON字符串当前字符和字符ch相同时，访问当前字符的下一个字符
 #define EXPECT(c, ch)       do { assert(*c->json == (ch)); c->json++; } while(0)
 //判断ch是否位于0~9数字范围内
@@ -42,6 +148,8 @@ typedef struct
 	const char* json;		//存储json字符串的当前位置
 	char* stack;			//栈内存空间
 	size_t size, top;		//size:栈的空间大小  top：栈顶	初始栈空间大小为0，栈顶为0
+	int flags;				//解析选项 LEPT_FLAG_*
+	const char* end;		//json的末尾，仅在需要跳过子树或 LEPT_FLAG_LAZY 时使用
 }lept_context;
 
 //栈内分配size大小的空间，准备存储数据，并修改栈顶
@@ -57,10 +165,14 @@ static void* lept_context_push(lept_context* c, size_t size)
 			c->size = LEPT_PARSE_STACK_INIT_SIZE;	
 		while (c->top + size >= c->size)
 			c->size += c->size >> 1;	//扩充栈内存  c->size * 1.5 
+		LEPT_STAT_ADD(stack_regrows, c->stack != NULL);
+		LEPT_STAT_ADD(realloc_calls, 1);
+		LEPT_STAT_ADD(realloc_bytes, c->size);
 		c->stack = (char*)realloc(c->stack, c->size);	//重新分配空间，并将旧空间的元素拷贝到新空间
 	}
 	ret = c->stack + c->top;	//要入栈元素指向的内存空间
 	c->top += size;		//更新栈顶
+	LEPT_STAT_MAX(stack_high_water, c->top);
 	return ret;
 }
 
@@ -75,12 +187,17 @@ static void* lept_context_pop(lept_context* c, size_t size)
 static void lept_parse_whitespace(lept_context* c)
 {
 	const char* p = c->json;
+	LEPT_STAT_PHASE_DECL;
+	if (*p != ' ' && *p != '\t' && *p != '\n' && *p != '\r')		//大多数情况下没有空白，不计时
+		return;
+	LEPT_STAT_ENTER(LEPT_PHASE_WHITESPACE);
 	//空格符（space U+0020）、制表符（tab U+0009）、换行符（LF U+000A）、回车符（CR U+000D）所组成。
 	while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
 	{
 		p++;
 	}
 	c->json = p;
+	LEPT_STAT_LEAVE();
 }
 
 //解析 NULL/TRUE/FALSE 三种字面值
@@ -105,9 +222,24 @@ static int lept_parse_literal(lept_context* c, lept_value* v, const char* litera
 //int = "0" / digit1 - 9 * digit
 //frac = "." 1 * digit
 //exp = ("e" / "E")["-" / "+"] 1 * digit
+static int lept_validate_number(const char** pp, const char* end);
+
 static int lept_parse_number(lept_context* c, lept_value* v)
 {
 	const char* p = c->json;
+	int ret;
+	if (c->flags & LEPT_FLAG_LAZY)
+	{
+		//只校验语法和范围，记录源文本，strtod推迟到首次读取
+		if ((ret = lept_validate_number(&p, c->end)) != LEPT_PARSE_OK)
+			return ret;
+		v->u.nr.raw = c->json;
+		v->u.nr.rawlen = p - c->json;
+		v->type = LEPT_NUMBER;
+		v->lazy = LEPT_LAZY_PENDING;
+		c->json = p;
+		return LEPT_PARSE_OK;
+	}
 	if (*p == '-') p++;
 	if (*p == '0') p++;
 	else
@@ -186,6 +318,38 @@ static void lept_encode_utf8(lept_context* c, unsigned u)
 	}
 }
 
+//校验str处（首字节不小于0x80）的一个UTF-8多字节序列（RFC 3629），返回它的字节数，不合法时返回0：
+//拒绝过长编码、代理项（U+D800~U+DFFF）和超过U+10FFFF的码点。end为NULL时文本以'\0'结尾，遇到'\0'即不合法
+static size_t lept_utf8_sequence(const char* str, const char* end)
+{
+	const unsigned char* s = (const unsigned char*)str;
+	unsigned char lo = 0x80, hi = 0xBF;	//第二个字节的合法范围
+	size_t n, i;
+	if (*s >= 0xC2 && *s <= 0xDF) n = 1;
+	else if (*s >= 0xE0 && *s <= 0xEF)
+	{
+		n = 2;
+		if (*s == 0xE0) lo = 0xA0;			//过长编码
+		else if (*s == 0xED) hi = 0x9F;		//代理项
+	}
+	else if (*s >= 0xF0 && *s <= 0xF4)
+	{
+		n = 3;
+		if (*s == 0xF0) lo = 0x90;			//过长编码
+		else if (*s == 0xF4) hi = 0x8F;		//超过U+10FFFF
+	}
+	else
+		return 0;	//0x80~0xC1 不能作为首字节，0xF5~0xFF 不会出现在UTF-8中
+	if ((end != NULL && (size_t)(end - str) <= n) || s[1] < lo || s[1] > hi)
+		return 0;
+	for (i = 2; i <= n; i++)
+		if ((s[i] & 0xC0) != 0x80)
+			return 0;
+	return n + 1;
+}
+
+static const char* lept_scan_string_utf8(const char* p, const char* end);
+
 //解析失败，要把先前压入栈的元素弹出，所以只需修改栈顶指针
 #define STRING_ERROR(ret) do{c->top = head; return ret;} while(0)
 
@@ -194,7 +358,7 @@ static int lept_parse_string_raw(lept_context* c, char** str, size_t* len)
 {
 	size_t head = c->top;	//备份栈顶
 	unsigned u, u2;
-	const char* p;
+	const char* p, * q;
 	EXPECT(c, '\"');	//指明要解析的是字符串
 	p = c->json;
 	for (;;) {
@@ -203,6 +367,9 @@ static int lept_parse_string_raw(lept_context* c, char** str, size_t* len)
 		case '\"':		//要么是空字符，要么本次字符串解析完成
 			*len = c->top - head;	//获取字符串的长度
 			*str = lept_context_pop(c, *len);	//字符串压栈后，返回其入栈的首元素的地址
+			//转义总是比解码后的字符长，所以原文与结果等长当且仅当没有转义
+			LEPT_STAT_ADD(strings_escaped, (size_t)(p - 1 - c->json) != *len);
+			LEPT_STAT_ADD(strings_plain, (size_t)(p - 1 - c->json) == *len);
 			c->json = p;
 			return LEPT_PARSE_OK;
 		case '\\':		//转义字符
@@ -242,23 +409,102 @@ static int lept_parse_string_raw(lept_context* c, char** str, size_t* len)
 		default:
 			if ((unsigned char)ch < 0x20)
 				STRING_ERROR(LEPT_PARSE_INVALID_STRING_CHAR);
-			PUTC(c, ch);
+			//连续的普通字符整段拷贝到栈中，需要时在同一遍扫描中校验UTF-8
+			q = p - 1;
+			if (!(c->flags & LEPT_FLAG_VALIDATE_UTF8))
+				for (; (unsigned char)*p >= 0x20 && *p != '\"' && *p != '\\'; p++);
+			else if ((p = lept_scan_string_utf8(q, c->end)) == NULL)
+				STRING_ERROR(LEPT_PARSE_INVALID_UTF8);
+			PUTS(c, q, p - q);
 		}
 	}
 }
 
+static int lept_validate_string(const char** pp, const char* end, int utf8);
+static const char* lept_skip_string_fast(const char* p, const char* end);
+
+//大字符串：解码结果不会比原文长（\uXXXX最多产生3个字节，代理对12个字节产生4个），
+//按原文长度分配节点的字符串，把它作为临时的解析栈，解码过程中不会扩充，解码完直接交给节点
+static int lept_parse_large_string(lept_context* c, lept_value* v, size_t rawlen)
+{
+	lept_context d = *c;
+	char* s;
+	size_t len;
+	int ret;
+#ifdef LEPT_ENABLE_STATS
+	uint64_t high_water = lept_stats_tls.stack_high_water;
+#endif
+	d.stack = (char*)malloc(rawlen + 1);
+	d.size = rawlen + 1;
+	d.top = 0;
+	LEPT_STAT_ADD(malloc_calls, 1);
+	LEPT_STAT_ADD(malloc_bytes, rawlen + 1);
+	ret = lept_parse_string_raw(&d, &s, &len);
+#ifdef LEPT_ENABLE_STATS
+	lept_stats_tls.stack_high_water = high_water;	//d的栈是节点的字符串，不计入解析栈的最高水位
+#endif
+	if (ret != LEPT_PARSE_OK)
+	{
+		free(d.stack);
+		return ret;
+	}
+	assert(d.size == rawlen + 1 && s == d.stack);
+	s[len] = '\0';
+	lept_free(v);
+	v->u.s.s = s;
+	v->u.s.len = len;
+	v->type = LEPT_STRING;
+	c->json = d.json;
+	return LEPT_PARSE_OK;
+}
+
 //解析字符串并把栈中的字符串拷贝到节点中
 static int lept_parse_string(lept_context* c, lept_value* v)
 {
 	int ret;
 	char* s;
 	size_t len;
+	const char* p = c->json;
+	const char* q;
+	if (c->flags & LEPT_FLAG_LAZY)
+	{
+		//只校验，记录含引号的源文本，转义推迟到首次读取时解码。转义序列都是ASCII，校验原文的UTF-8即可
+		if ((ret = lept_validate_string(&p, c->end, (c->flags & LEPT_FLAG_VALIDATE_UTF8) != 0)) != LEPT_PARSE_OK)
+			return ret;
+		v->u.s.s = (char*)c->json;		//只读，解码前不会通过它写入或释放
+		v->u.s.len = p - c->json;
+		v->type = LEPT_STRING;
+		v->lazy = LEPT_LAZY_PENDING;
+		c->json = p;
+		return LEPT_PARSE_OK;
+	}
+	//用选择性解析跳过字符串的同一个扫描找到结尾引号，字符串未结束时交给正常解析报告错误
+	if ((c->flags & LEPT_FLAG_LARGE_STRINGS) && (q = lept_skip_string_fast(p + 1, c->end)) != NULL
+		&& (len = (size_t)(q - p - 2)) >= LEPT_LARGE_STRING_SIZE)
+		return lept_parse_large_string(c, v, len);
 	if ((ret = lept_parse_string_raw(c, &s, &len)) == LEPT_PARSE_OK)	//解析字符串到栈中
 		lept_set_string(v, s, len);		//给节点设置解析好的字符串	
 	return ret;
 }
 
 static int lept_parse_value(lept_context* c, lept_value* v);
+static double* lept_set_packed(lept_value* v, size_t size);
+
+//LEPT_FLAG_PACK_NUMBERS：栈顶的size个元素都是已解码的数字时，存为 double[] 并弹出
+static int lept_parse_packed(lept_context* c, lept_value* v, size_t size)
+{
+	size_t i;
+	const lept_value* e = (const lept_value*)(c->stack + c->top - size * sizeof(lept_value));
+	double* d;
+	for (i = 0; i < size; i++)
+		if (e[i].type != LEPT_NUMBER || e[i].lazy != LEPT_LAZY_NONE)	//保留源文本的数字不能丢掉原文
+			return 0;
+	d = lept_set_packed(v, size);
+	for (i = 0; i < size; i++)
+		d[i] = e[i].u.n;
+	lept_context_pop(c, size * sizeof(lept_value));
+	return 1;
+}
 
 //解析数组
 static int lept_parse_array(lept_context* c, lept_value* v)
@@ -270,9 +516,7 @@ static int lept_parse_array(lept_context* c, lept_value* v)
 	if (*c->json == ']')	//解析的是一个空数组
 	{
 		c->json++;
-		v->type = LEPT_ARRAY;
-		v->u.a.size = 0;
-		v->u.a.e = NULL;
+		lept_set_array(v, 0);
 		return LEPT_PARSE_OK;
 	}
 	for (;;)
@@ -293,11 +537,12 @@ static int lept_parse_array(lept_context* c, lept_value* v)
 		else if (*c->json == ']')	//解析完成
 		{
 			c->json++;
-			v->type = LEPT_ARRAY;
-			v->u.a.size = size;
-			size *= sizeof(lept_value);
+			if ((c->flags & LEPT_FLAG_PACK_NUMBERS) && lept_parse_packed(c, v, size))
+				return LEPT_PARSE_OK;
+			lept_set_array(v, size);	//容量恰好等于元素个数
 			//栈只是临时的，需要把解析后得到的元素拷贝到定义好的节点的内存空间，再释放栈内存
-			memcpy(v->u.a.e = (lept_value*)malloc(size), lept_context_pop(c, size), size);
+			memcpy(v->u.a.e, lept_context_pop(c, size * sizeof(lept_value)), size * sizeof(lept_value));
+			v->u.a.size = size;
 			return LEPT_PARSE_OK;
 		}
 		else
@@ -318,14 +563,13 @@ static int lept_parse_object(lept_context* c, lept_value* v)
 	size_t i, size;
 	lept_member m;	//临时变量，存储解析好的对象成员
 	int ret;
+	LEPT_STAT_PHASE_DECL;
 	EXPECT(c, '{');		//指明要解析的是对象
 	lept_parse_whitespace(c);
 	if (*c->json == '}')	//对象成员为空
 	{
 		c->json++;
-		v->type = LEPT_OBJECT;
-		v->u.o.m = 0;
-		v->u.o.size = 0;
+		lept_set_object(v, 0);
 		return LEPT_PARSE_OK;
 	}
 	m.k = NULL;
@@ -339,9 +583,14 @@ static int lept_parse_object(lept_context* c, lept_value* v)
 			ret = LEPT_PARSE_MISS_KEY;		//成员缺少key值
 			break;
 		}
-		if ((ret = lept_parse_string_raw(c, &str, &m.klen)) != LEPT_PARSE_OK)	//字符串解析失败
+		LEPT_STAT_ENTER(LEPT_PHASE_STRING);
+		ret = lept_parse_string_raw(c, &str, &m.klen);
+		LEPT_STAT_LEAVE();
+		if (ret != LEPT_PARSE_OK)	//字符串解析失败
 			break;
 		memcpy(m.k = (char*)malloc(m.klen + 1), str, m.klen);
+		LEPT_STAT_ADD(malloc_calls, 1);
+		LEPT_STAT_ADD(malloc_bytes, m.klen + 1);
 		m.k[m.klen] = '\0';		//给字符串补上空字符'\0' 
 		lept_parse_whitespace(c);
 		if (*c->json != ':')	
@@ -366,9 +615,9 @@ static int lept_parse_object(lept_context* c, lept_value* v)
 		{
 			size_t s = sizeof(lept_member) * size;
 			c->json++;
-			v->type = LEPT_OBJECT;
+			lept_set_object(v, size);
+			memcpy(v->u.o.m, lept_context_pop(c, s), s);		//将栈中所有解析好的成员拷贝到节点中
 			v->u.o.size = size;
-			memcpy(v->u.o.m = (lept_member*)malloc(s), lept_context_pop(c, s), s);		//将栈中所有解析好的成员拷贝到节点中
 			return LEPT_PARSE_OK;
 		}
 		else
@@ -392,17 +641,22 @@ static int lept_parse_object(lept_context* c, lept_value* v)
 
 static int lept_parse_value(lept_context* c, lept_value* v)
 {
+	int ret;
+	LEPT_STAT_PHASE_DECL;
 	switch (*c->json)
 	{
-	case 't':	return lept_parse_literal(c, v, "true", LEPT_TRUE);
-	case 'f':	return lept_parse_literal(c, v, "false", LEPT_FALSE);
-	case 'n':	return lept_parse_literal(c, v, "null", LEPT_NULL);
-	default:	return lept_parse_number(c, v);
-	case '"':	return lept_parse_string(c, v);
-	case '[':	return lept_parse_array(c, v);
-	case '{':	return lept_parse_object(c, v);
+	case 't':	ret = lept_parse_literal(c, v, "true", LEPT_TRUE); break;
+	case 'f':	ret = lept_parse_literal(c, v, "false", LEPT_FALSE); break;
+	case 'n':	ret = lept_parse_literal(c, v, "null", LEPT_NULL); break;
+	default:	LEPT_STAT_ENTER(LEPT_PHASE_NUMBER); ret = lept_parse_number(c, v); LEPT_STAT_LEAVE(); break;
+	case '"':	LEPT_STAT_ENTER(LEPT_PHASE_STRING); ret = lept_parse_string(c, v); LEPT_STAT_LEAVE(); break;
+	case '[':	LEPT_STAT_ENTER(LEPT_PHASE_CONTAINER); ret = lept_parse_array(c, v); LEPT_STAT_LEAVE(); break;
+	case '{':	LEPT_STAT_ENTER(LEPT_PHASE_CONTAINER); ret = lept_parse_object(c, v); LEPT_STAT_LEAVE(); break;
 	case '\0':	return LEPT_PARSE_EXPECT_VALUE;		//JSON 只含有空白
 	}
+	if (ret == LEPT_PARSE_OK)
+		LEPT_STAT_ADD(nodes[v->type], 1);
+	return ret;
 }
 
 //JSON-text = ws value ws
@@ -412,13 +666,21 @@ static int lept_parse_value(lept_context* c, lept_value* v)
 //false = "false"
 //true = "true"
 int lept_parse(lept_value* v, const char* json)
+{
+	return lept_parse_ex(v, json, 0);
+}
+
+//带解析选项的lept_parse
+int lept_parse_ex(lept_value* v, const char* json, int flags)
 {
 	lept_context c;		//备份json，并使用栈保存json解析后的内容
 	int ret;
 	assert(v != NULL);
 	c.json = json;
+	c.end = (flags & (LEPT_FLAG_LAZY | LEPT_FLAG_LARGE_STRINGS)) ? json + strlen(json) : NULL;	//大字符串用 lept_skip_string_fast 找结尾引号
 	c.stack = NULL;
 	c.size = c.top = 0;
+	c.flags = flags;
 	lept_init(v);
 	lept_parse_whitespace(&c);
 	if ((ret = lept_parse_value(&c, v)) == LEPT_PARSE_OK)
@@ -426,217 +688,2380 @@ int lept_parse(lept_value* v, const char* json)
 		lept_parse_whitespace(&c);
 		if (*c.json != '\0')	//解析一个值之后，在空白之后还有其他字符
 		{
-			v->type = LEPT_NULL;
+			lept_free(v);	//释放已解析的节点，避免内存泄漏
 			ret = LEPT_PARSE_ROOT_NOT_SINGULAR;
 		}
 	}
+	LEPT_STAT_ADD(bytes_parsed, c.json - json);
 	//不管解析的是不是字符串，最后c.top = 0，因为数据都被弹出了，而且下次可复用栈
 	assert(c.top == 0);
 	free(c.stack);
 	return ret;
 }
 
-//字符串化，生成字符串并压入栈
-//最后没有往栈中压入空字符'\0'的原因：解析的字符串只是JSON的一个节点，若加入了空字符，则表示JSON到此结束
-//'\0'表示JSON字符串的结束
-static void lept_stringify_string(lept_context* c, const char* s, size_t len)
+//解码后的 LEPT_FLAG_LAZY 字符串的源文本，放在解码结果之前，只有 LEPT_LAZY_DECODED 的字符串才有
+typedef struct
 {
-	static const char hex_digits[] = { '0','1','2','3','4','5','6','7','8','9','A','B','C','D','E','F' };
-	size_t i, size;
-	char* head, * p;
-	assert(s != NULL);
-	//往栈中压入字符时，一开始和最后都要压入双引号字符"
-	p = head = lept_context_push(c, size = len * 6 + 2);	// "\u00xx..."
-	*p++ = '"';
-	for (i = 0; i < len; i++)
-	{
-		unsigned char ch = (unsigned char)s[i];
-		switch (ch)
-		{
-		//转义字符
-		case '\"': *p++ = '\\'; *p++ = '\"'; break;
-		case '\\': *p++ = '\\'; *p++ = '\\'; break;
-		case '\b': *p++ = '\\'; *p++ = 'b'; break;
-		case '\f': *p++ = '\\'; *p++ = 'f'; break;
-		case '\n': *p++ = '\\'; *p++ = 'n'; break;
-		case '\r': *p++ = '\\'; *p++ = 'r'; break;
-		case '\t': *p++ = '\\'; *p++ = 't'; break;
-		default:
-			if (ch < 0x20)
-			{
-				//以\u00xx表示
-				*p++ = '\\'; *p++ = 'u'; *p++ = '0'; *p++ = '0';
-				*p++ = hex_digits[ch >> 4];
-				*p++ = hex_digits[ch & 15];
-			}
-			else
-			{
-				*p++ = s[i];
-			}
-		}
-	}
-	*p++ = '"';
-	c->top -= size - (p - head);	//调整栈顶指针
-}
+	const char* raw;
+	size_t rawlen;
+}lept_lazy_source;
 
-//生成JSON
-static void lept_stringify_value(lept_context* c, const lept_value* v)
+#define LEPT_LAZY_SOURCE_OF(v)	((lept_lazy_source*)(v)->u.s.s - 1)
+
+//解码 LEPT_FLAG_LAZY 记录的数字/字符串，源文本保留以便原样输出。
+//读取接口对const节点也会调用：只是补上与源文本等价的解码结果，节点的值不变
+static void lept_decode_lazy(lept_value* v)
 {
-	size_t i;
-	switch (v->type)
+	lept_context c;
+	lept_lazy_source* src;
+	char* s;
+	size_t len;
+	int ret;
+	assert(v->lazy == LEPT_LAZY_PENDING);
+	if (v->type == LEPT_NUMBER)
+		v->u.nr.n = strtod(v->u.nr.raw, NULL);		//解析时已校验过语法和范围
+	else
 	{
-	case LEPT_NULL:		PUTS(c, "null", 4); break;
-	case LEPT_FALSE:	PUTS(c, "false", 5); break;
-	case LEPT_TRUE:		PUTS(c, "true", 4); break;
-	//把浮点数转换成文本，"%.17g" 是足够把双精度浮点转换成可还原的文本。
-	case LEPT_NUMBER:	c->top -= 32 - sprintf(lept_context_push(c, 32), "%.17g", v->u.n); break;	
-	case LEPT_STRING:	lept_stringify_string(c, v->u.s.s, v->u.s.len); break;
-	case LEPT_ARRAY:	
-		PUTC(c, '[');
-		for (i = 0; i < v->u.a.size; i++)
-		{
-			if (i > 0)
-				PUTC(c, ',');
-			lept_stringify_value(c, &v->u.a.e[i]);	//生成数组中的元素
-		}
-		PUTC(c, ']');
-		break;
-	case LEPT_OBJECT:
-		PUTC(c, '{');
-		for (i = 0; i < v->u.o.size; i++)
-		{
-			if (i > 0)
-				PUTC(c, ',');
-			lept_stringify_string(c, v->u.o.m[i].k, v->u.o.m[i].klen);	//生成对象中成员的key
-			PUTC(c, ':');
-			lept_stringify_value(c, &v->u.o.m[i].v);		//生成对象中成员的value
-		}
-		PUTC(c, '}');
-		break;
-	default: assert(0 && "invalid type");
+		c.json = v->u.s.s;
+		c.end = NULL;
+		c.stack = NULL;
+		c.size = c.top = 0;
+		c.flags = 0;
+		ret = lept_parse_string_raw(&c, &s, &len);
+		assert(ret == LEPT_PARSE_OK);
+		(void)ret;
+		src = (lept_lazy_source*)malloc(sizeof(lept_lazy_source) + len + 1);
+		LEPT_STAT_ADD(malloc_calls, 1);
+		LEPT_STAT_ADD(malloc_bytes, sizeof(lept_lazy_source) + len + 1);
+		src->raw = v->u.s.s;
+		src->rawlen = v->u.s.len;
+		v->u.s.s = (char*)(src + 1);
+		if (len > 0)
+			memcpy(v->u.s.s, s, len);
+		v->u.s.s[len] = '\0';
+		v->u.s.len = len;
+		free(c.stack);
 	}
+	v->lazy = LEPT_LAZY_DECODED;
 }
 
-//将节点树字符串化生成JSON文本
-char* lept_stringify(const lept_value* v, size_t* length)
+//访问数字/字符串的值之前调用
+#define LEPT_DECODE(v)		do { if ((v)->lazy == LEPT_LAZY_PENDING) lept_decode_lazy((lept_value*)(v)); } while(0)
+
+//只读地取数组的第i个元素：紧凑数组不展开，把数字放进tmp再返回tmp
+static const lept_value* lept_array_at(const lept_value* v, size_t i, lept_value* tmp)
 {
-	lept_context c;
-	assert(v != NULL);
-	c.stack = (char*)malloc(c.size = LEPT_PARSE_STACK_INIT_SIZE);	//分配栈内存，用以存储生成的JSON
-	c.top = 0;
-	lept_stringify_value(&c, v);
-	if (length)
-		*length = c.top;	//记录生成的JSON长度
-	PUTC(&c, '\0');
-	return c.stack;
+	if (!v->packed)
+		return &v->u.a.e[i];
+	lept_init(tmp);
+	tmp->type = LEPT_NUMBER;
+	tmp->u.n = v->u.pa.d[i];
+	return tmp;
 }
 
-//释放节点所占的内存
-void lept_free(lept_value* v)
+//解码整棵树并丢弃源文本
+void lept_materialize(lept_value* v)
 {
 	size_t i;
 	assert(v != NULL);
 	switch (v->type)
 	{
-	case LEPT_STRING:	//释放字符串
-		free(v->u.s.s);
-		break;
 	case LEPT_ARRAY:
+		lept_unpack_array(v);	//读取元素会展开紧凑数组，冻结前先展开
 		for (i = 0; i < v->u.a.size; i++)
-			lept_free(&v->u.a.e[i]);	//递归释放数组各个元素所指向的内存空间
-		free(v->u.a.e);		//最后释放数组指针
+			lept_materialize(&v->u.a.e[i]);
 		break;
 	case LEPT_OBJECT:
 		for (i = 0; i < v->u.o.size; i++)
-		{
-			free(v->u.o.m[i].k);	//释放对象中成员的key值
-			lept_free(&v->u.o.m[i].v);		//递归释放对象中成员的value值
-		}
-		free(v->u.o.m);		//最后释放对象成员指针
+			lept_materialize(&v->u.o.m[i].v);
 		break;
 	default:
+		LEPT_DECODE(v);
+		if (v->type == LEPT_STRING && v->lazy == LEPT_LAZY_DECODED)	//把解码结果移到分配的开头，成为普通字符串
+		{
+			char* s = (char*)LEPT_LAZY_SOURCE_OF(v);
+			memmove(s, v->u.s.s, v->u.s.len + 1);
+			v->u.s.s = s;
+		}
+		v->lazy = LEPT_LAZY_NONE;
 		break;
 	}
-	v->type = LEPT_NULL;
 }
 
-//获取节点类型
-lept_type lept_get_type(const lept_value* v)
-{
-	assert(v != NULL);
-	return v->type;
-}
+//流式压缩/美化输出时使用的固定缓冲区大小
+#ifndef LEPT_WRITER_BUFFER_SIZE
+#define LEPT_WRITER_BUFFER_SIZE 4096
+#endif
 
-//获取节点的bool类型，TRUE or FALASE
-int lept_get_boolean(const lept_value* v)
-{
-	assert(v != NULL && (v->type == LEPT_TRUE || v->type == LEPT_FALSE));
-	return v->type == LEPT_TRUE;
-}
+//只校验不建树时，允许的最大嵌套层数，每层只占1位，不分配堆内存
+#ifndef LEPT_VALIDATE_MAX_DEPTH
+#define LEPT_VALIDATE_MAX_DEPTH 1024
+#endif
 
-//给节点类型设置bool类型，TRUE or FALSE
-void lept_set_boolean(lept_value* v, int b)
-{
-	lept_free(v);
-	v->type = b ? LEPT_TRUE : LEPT_FALSE;
-}
+//校验时读取当前字符，越过末尾视为空字符，与lept_parse遇到'\0'的行为一致
+#define PEEK(p, end)        ((p) < (end) ? *(p) : '\0')
 
-//获取节点的数字
-double lept_get_number(const lept_value* v)
+static const char* lept_validate_whitespace(const char* p, const char* end)
 {
-	assert(v != NULL && v->type == LEPT_NUMBER);
-	return v->u.n;
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+		p++;
+	return p;
 }
 
-//给节点设置数字和相应类型
-void lept_set_number(lept_value* v, double n)
+//校验4位十六进制数字，与lept_parse_hex4相同但不越过末尾
+static const char* lept_validate_hex4(const char* p, const char* end, unsigned* u)
 {
-	lept_free(v);
-	v->u.n = n;
-	v->type = LEPT_NUMBER;
+	int i;
+	*u = 0;
+	for (i = 0; i < 4; i++)
+	{
+		char ch = PEEK(p, end);
+		p++;
+		*u <<= 4;
+		if (ch >= '0' && ch <= '9') *u |= ch - '0';
+		else if (ch >= 'A' && ch <= 'F') *u |= ch - ('A' - 10);
+		else if (ch >= 'a' && ch <= 'f') *u |= ch - ('a' - 10);
+		else return NULL;
+	}
+	return p;
 }
 
-//获取节点的字符串
-const char* lept_get_string(const lept_value* v)
+//跳过不需要特殊处理的字符：返回第一个 '"'、'\\' 或小于0x20 的字符的位置，utf8为真时也停在非ASCII字节上。
+//非ASCII字节的检查是同一次载入的最高位，不增加扫描的遍数。end为NULL时文本以'\0'结尾，只能逐字节检查
+static const char* lept_scan_string_plain(const char* p, const char* end, int utf8)
 {
-	assert(v != NULL && v->type == LEPT_STRING);
-	return v->u.s.s;
+#ifdef LEPT_SSE2
+	const __m128i quote = _mm_set1_epi8('"'), backslash = _mm_set1_epi8('\\'), ctrl = _mm_set1_epi8(0x1F);
+	while (end != NULL && end - p >= 16)	//一次检查16个字节
+	{
+		__m128i x = _mm_loadu_si128((const __m128i*)p);
+		__m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, backslash)),
+			_mm_cmpeq_epi8(_mm_min_epu8(x, ctrl), x));		//x <= 0x1F
+		int mask = _mm_movemask_epi8(m) | (utf8 ? _mm_movemask_epi8(x) : 0);
+		if (mask != 0)
+			return p + lept_ctz(mask);
+		p += 16;
+	}
+#endif
+	while ((end == NULL || p < end) && *p != '"' && *p != '\\' && (unsigned char)*p >= 0x20 && !(utf8 && (unsigned char)*p >= 0x80))
+		p++;
+	return p;
 }
 
-//获取节点的字符串的长度
-size_t lept_get_string_length(const lept_value* v)
+//跳过普通字符并校验其中的UTF-8多字节序列，返回第一个 '"'、'\\' 或小于0x20 的字符的位置，UTF-8不合法时返回NULL
+static const char* lept_scan_string_utf8(const char* p, const char* end)
 {
-	assert(v != NULL && v->type == LEPT_STRING);
-	return v->u.s.len;
+	size_t n;
+	for (;;)
+	{
+		p = lept_scan_string_plain(p, end, 1);
+		if ((end != NULL && p == end) || (unsigned char)*p < 0x80)
+			return p;
+		if ((n = lept_utf8_sequence(p, end)) == 0)
+			return NULL;
+		p += n;
+	}
 }
 
-//给节点设置字符串
-void lept_set_string(lept_value* v, const char* s, size_t len)
+//校验字符串，语法和错误码与lept_parse_string_raw相同，但不解码也不入栈。utf8为真时同一遍扫描中校验UTF-8
+static int lept_validate_string(const char** pp, const char* end, int utf8)
 {
-	assert(v != NULL && (s != NULL || len == 0));
-	lept_free(v);
-	v->u.s.s = (char*)malloc(len + 1);
-	memcpy(v->u.s.s, s, len);
-	v->u.s.s[len] = '\0';
-	v->u.s.len = len;
-	v->type = LEPT_STRING;
+	const char* p = *pp + 1;	//跳过开头的双引号
+	unsigned u, u2;
+	for (;;)
+	{
+		char ch;
+		size_t n;
+		p = lept_scan_string_plain(p, end, utf8);
+		*pp = p;	//出错时报告的位置
+		ch = PEEK(p, end);
+		p++;
+		switch (ch)
+		{
+		case '\"':
+			*pp = p;
+			return LEPT_PARSE_OK;
+		case '\\':
+			ch = PEEK(p, end);
+			p++;
+			switch (ch)
+			{
+			case '\"': case '\\': case '/': case 'b':
+			case 'f':  case 'n':  case 'r': case 't':
+				break;
+			case 'u':
+				if (!(p = lept_validate_hex4(p, end, &u)))
+					return LEPT_PARSE_INVALID_UNICODE_HEX;
+				if (u >= 0xD800 && u <= 0xDBFF)
+				{
+					if (PEEK(p, end) != '\\')
+						return LEPT_PARSE_INVALID_UNICODE_SURROGATE;
+					p++;
+					if (PEEK(p, end) != 'u')
+						return LEPT_PARSE_INVALID_UNICODE_SURROGATE;
+					p++;
+					if (!(p = lept_validate_hex4(p, end, &u2)))
+						return LEPT_PARSE_INVALID_UNICODE_HEX;
+					if (u2 < 0xDC00 || u2 > 0xDFFF)
+						return LEPT_PARSE_INVALID_UNICODE_SURROGATE;
+				}
+				break;
+			default:
+				return LEPT_PARSE_INVALID_STRING_ESCAPE;
+			}
+			break;
+		case '\0':
+			return LEPT_PARSE_MISS_QUOTATION_MARK;
+		default:	//lept_scan_string_plain只会停在小于0x20的字符，或者utf8时的非ASCII字节上
+			if ((unsigned char)ch < 0x80)
+				return LEPT_PARSE_INVALID_STRING_CHAR;
+			if ((n = lept_utf8_sequence(p - 1, end)) == 0)
+				return LEPT_PARSE_INVALID_UTF8;
+			p += n - 1;
+			break;
+		}
+	}
 }
 
-//获取数组的元素个数
-size_t lept_get_array_size(const lept_value* v)
+//判断数字是否会让strtod溢出（语法已校验过）。先按数量级粗判，只有数量级恰为10^308时，
+//才把有效数字拷贝到栈上的缓冲区调用strtod，与lept_parse_number的判定保持一致。
+//位数按实际个数统计；指数只在超过文本长度加上余量后饱和，此时数量级的正负已经确定
+static int lept_validate_number_range(const char* p, const char* end)
 {
-	assert(v != NULL && v->type == LEPT_ARRAY);
+	char buf[420];	//DBL_MAX附近的舍入边界约需310位有效数字，截断更多的位不影响结果
+	size_t n = 0;
+	long long lead = 0, zeros = 0, exp = 0, mag, cap = (long long)(end - p) + 1000;
+	int seen = 0, esign = 1;
+	double d;
+	if (*p == '-')
+		buf[n++] = *p++;
+	buf[n++] = '0';
+	buf[n++] = '.';
+	for (; p < end && ISDIGIT(*p); p++)		//整数部分
+	{
+		if (*p != '0' || seen)
+		{
+			seen = 1;
+			lead++;
+			if (n < sizeof(buf) - 16) buf[n++] = *p;
+		}
+	}
+	if (p < end && *p == '.')
+	{
+		for (p++; p < end && ISDIGIT(*p); p++)	//小数部分
+		{
+			if (*p != '0' || seen)
+			{
+				seen = 1;
+				if (n < sizeof(buf) - 16) buf[n++] = *p;
+			}
+			else
+				zeros++;	//小数点后、第一个有效数字前的0
+		}
+	}
+	if (!seen)	//数值为0
+		return LEPT_PARSE_OK;
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		p++;
+		if (p < end && (*p == '+' || *p == '-'))
+			esign = *p++ == '-' ? -1 : 1;
+		for (; p < end && ISDIGIT(*p); p++)
+			if (exp <= cap)
+				exp = exp * 10 + (*p - '0');
+	}
+	mag = (lead > 0 ? lead - 1 : -(zeros + 1)) + esign * exp;		//数值位于 [10^mag, 10^(mag+1))
+	if (mag < 308)
+		return LEPT_PARSE_OK;
+	if (mag > 308)
+		return LEPT_PARSE_NUMBER_TOO_BIG;
+	sprintf(buf + n, "e%d", (int)mag + 1);		//0.ddd...e309
+	errno = 0;
+	d = strtod(buf, NULL);
+	if (errno == ERANGE && (d == HUGE_VAL || d == -HUGE_VAL))
+		return LEPT_PARSE_NUMBER_TOO_BIG;
+	return LEPT_PARSE_OK;
+}
+
+//校验数字，语法与lept_parse_number相同
+static int lept_validate_number(const char** pp, const char* end)
+{
+	const char* p = *pp;
+	if (PEEK(p, end) == '-') p++;
+	if (PEEK(p, end) == '0') p++;
+	else
+	{
+		if (!ISDIGIT1TO9(PEEK(p, end))) return LEPT_PARSE_INVALID_VALUE;
+		for (p++; ISDIGIT(PEEK(p, end)); p++);
+	}
+	if (PEEK(p, end) == '.')
+	{
+		p++;
+		if (!ISDIGIT(PEEK(p, end))) return LEPT_PARSE_INVALID_VALUE;
+		for (p++; ISDIGIT(PEEK(p, end)); p++);
+	}
+	if (PEEK(p, end) == 'e' || PEEK(p, end) == 'E')
+	{
+		p++;
+		if (PEEK(p, end) == '+' || PEEK(p, end) == '-') p++;
+		if (!ISDIGIT(PEEK(p, end))) return LEPT_PARSE_INVALID_VALUE;
+		for (p++; ISDIGIT(PEEK(p, end)); p++);
+	}
+	if (lept_validate_number_range(*pp, p) != LEPT_PARSE_OK)
+		return LEPT_PARSE_NUMBER_TOO_BIG;
+	*pp = p;
+	return LEPT_PARSE_OK;
+}
+
+//校验字面值 null/true/false
+static int lept_validate_literal(const char** pp, const char* end, const char* literal)
+{
+	const char* p = *pp;
+	for (; *literal; literal++, p++)
+		if (PEEK(p, end) != *literal)
+			return LEPT_PARSE_INVALID_VALUE;
+	*pp = p;
+	return LEPT_PARSE_OK;
+}
+
+//流式输出的缓冲区，写满后才调用一次writer，内存占用固定
+typedef struct
+{
+	const lept_writer* w;
+	const char* indent;		//每层缩进的字符串，NULL表示紧凑输出
+	size_t top;
+	char buf[LEPT_WRITER_BUFFER_SIZE];
+}lept_output;
+
+static void lept_output_flush(lept_output* o)
+{
+	if (o->top > 0)
+		o->w->write(o->w->user, o->buf, o->top);
+	o->top = 0;
+}
+
+static void lept_output_put(lept_output* o, const char* s, size_t len)
+{
+	if (o->top + len > LEPT_WRITER_BUFFER_SIZE)
+	{
+		lept_output_flush(o);
+		if (len >= LEPT_WRITER_BUFFER_SIZE)		//超长的token直接交给writer
+		{
+			o->w->write(o->w->user, s, len);
+			return;
+		}
+	}
+	memcpy(o->buf + o->top, s, len);
+	o->top += len;
+}
+
+//美化输出时换行并缩进depth层
+static void lept_output_newline(lept_output* o, size_t depth)
+{
+	size_t i, n;
+	if (o->indent == NULL)
+		return;
+	n = strlen(o->indent);
+	lept_output_put(o, "\n", 1);
+	for (i = 0; i < depth; i++)
+		lept_output_put(o, o->indent, n);
+}
+
+//单遍扫描*pp处的一个JSON值（前导空白已跳过）：语法和错误码与lept_parse_value相同，不分配内存，也不递归。
+//嵌套的数组/对象用位栈记录（1为对象，0为数组），超过LEPT_VALIDATE_MAX_DEPTH层返回LEPT_PARSE_NESTING_TOO_DEEP。
+//out不为NULL时，把token原样（字符串保留原有转义，数字保留原文）写到输出，丢弃原有空白。
+//成功时*pp指向该值之后，失败时指向出错的位置
+static int lept_scan_value(const char** pp, const char* end, lept_output* out)
+{
+	unsigned char nest[(LEPT_VALIDATE_MAX_DEPTH + 7) / 8];
+	const char* p = *pp;
+	const char* token;
+	size_t depth = 0;
+	int ret = LEPT_PARSE_OK, key = 0, is_object;
+	for (;;)
+	{
+		if (key)	//对象成员：key ws ':' ws value
+		{
+			if (PEEK(p, end) != '"')
+			{
+				ret = LEPT_PARSE_MISS_KEY;
+				break;
+			}
+			token = p;
+			if ((ret = lept_validate_string(&p, end, 0)) != LEPT_PARSE_OK)
+				break;
+			if (out)
+				lept_output_put(out, token, (size_t)(p - token));
+			p = lept_validate_whitespace(p, end);
+			if (PEEK(p, end) != ':')
+			{
+				ret = LEPT_PARSE_MISS_COLON;
+				break;
+			}
+			if (out)
+				lept_output_put(out, ": ", out->indent ? 2 : 1);
+			p = lept_validate_whitespace(p + 1, end);
+			key = 0;
+		}
+		token = p;
+		switch (PEEK(p, end))
+		{
+		case 't':	ret = lept_validate_literal(&p, end, "true"); break;
+		case 'f':	ret = lept_validate_literal(&p, end, "false"); break;
+		case 'n':	ret = lept_validate_literal(&p, end, "null"); break;
+		default:	ret = lept_validate_number(&p, end); break;
+		case '"':	ret = lept_validate_string(&p, end, 0); break;
+		case '\0':	ret = LEPT_PARSE_EXPECT_VALUE; break;
+		case '[':
+		case '{':
+			if (depth == LEPT_VALIDATE_MAX_DEPTH)
+			{
+				ret = LEPT_PARSE_NESTING_TOO_DEEP;
+				break;
+			}
+			is_object = *p == '{';
+			if (is_object)
+				nest[depth / 8] |= (unsigned char)(1 << (depth % 8));
+			else
+				nest[depth / 8] &= (unsigned char)~(1 << (depth % 8));
+			depth++;
+			p = lept_validate_whitespace(p + 1, end);
+			if (PEEK(p, end) == (is_object ? '}' : ']'))	//空数组或空对象
+			{
+				p++;
+				depth--;
+				if (out)
+					lept_output_put(out, is_object ? "{}" : "[]", 2);
+				token = p;
+				break;
+			}
+			if (out)
+			{
+				lept_output_put(out, token, 1);
+				lept_output_newline(out, depth);
+			}
+			key = is_object;
+			continue;	//解析第一个元素或成员
+		}
+		if (ret != LEPT_PARSE_OK)
+			break;
+		if (out && token != p)
+			lept_output_put(out, token, (size_t)(p - token));
+		//一个值解析完成，处理所在容器的逗号或结束符，可能连续关闭多层
+		for (;;)
+		{
+			if (depth == 0)
+			{
+				*pp = p;
+				return LEPT_PARSE_OK;
+			}
+			p = lept_validate_whitespace(p, end);
+			is_object = (nest[(depth - 1) / 8] >> ((depth - 1) % 8)) & 1;
+			if (PEEK(p, end) == ',')
+			{
+				if (out)
+				{
+					lept_output_put(out, ",", 1);
+					lept_output_newline(out, depth);
+				}
+				p = lept_validate_whitespace(p + 1, end);
+				key = is_object;
+				break;
+			}
+			if (PEEK(p, end) == (is_object ? '}' : ']'))
+			{
+				p++;
+				depth--;
+				if (out)
+				{
+					lept_output_newline(out, depth);
+					lept_output_put(out, p - 1, 1);
+				}
+				continue;
+			}
+			ret = is_object ? LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET : LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+			break;
+		}
+		if (ret != LEPT_PARSE_OK)
+			break;
+	}
+	*pp = p;
+	return ret;
+}
+
+//扫描整个JSON文本：ws value ws
+static int lept_scan(const char* json, size_t len, size_t* err_offset, lept_output* out)
+{
+	const char* p = json;
+	const char* end = json + len;
+	int ret;
+	assert(json != NULL || len == 0);
+	p = lept_validate_whitespace(p, end);
+	if ((ret = lept_scan_value(&p, end, out)) == LEPT_PARSE_OK)
+	{
+		p = lept_validate_whitespace(p, end);
+		if (p != end)	//解析一个值之后，在空白之后还有其他字符
+			ret = LEPT_PARSE_ROOT_NOT_SINGULAR;
+	}
+	if (err_offset)
+		*err_offset = (size_t)(p - json);
+	return ret;
+}
+
+//只校验JSON文本而不建树
+int lept_validate(const char* json, size_t len, size_t* err_offset)
+{
+	return lept_scan(json, len, err_offset, NULL);
+}
+
+//单遍压缩JSON文本：去掉所有空白，token原样输出，不建树
+int lept_minify(const char* json, size_t len, const lept_writer* w)
+{
+	lept_output out;
+	int ret;
+	assert(w != NULL && w->write != NULL);
+	out.w = w;
+	out.indent = NULL;
+	out.top = 0;
+	ret = lept_scan(json, len, NULL, &out);
+	lept_output_flush(&out);
+	return ret;
+}
+
+//单遍美化JSON文本：每个元素/成员一行，按层级用indent缩进，token原样输出，不建树
+int lept_prettify(const char* json, size_t len, const char* indent, const lept_writer* w)
+{
+	lept_output out;
+	int ret;
+	assert(w != NULL && w->write != NULL && indent != NULL);
+	out.w = w;
+	out.indent = indent;
+	out.top = 0;
+	ret = lept_scan(json, len, NULL, &out);
+	lept_output_flush(&out);
+	return ret;
+}
+
+#ifdef LEPT_SSE2
+//统计16位掩码中1的个数
+static int lept_popcount16(unsigned x)
+{
+	x = x - ((x >> 1) & 0x5555);
+	x = (x & 0x3333) + ((x >> 2) & 0x3333);
+	x = (x + (x >> 4)) & 0x0F0F;
+	return (int)((x + (x >> 8)) & 0x1F);
+}
+#endif
+
+//快速跳过字符串的剩余部分（p在开头的双引号之后）：只找结束的双引号，不解码转义，也不检查字符。
+//返回结束双引号之后的位置，字符串未结束时返回NULL
+static const char* lept_skip_string_fast(const char* p, const char* end)
+{
+	for (;;)
+	{
+#ifdef LEPT_SSE2
+		const __m128i quote = _mm_set1_epi8('"'), backslash = _mm_set1_epi8('\\');
+		while (end - p >= 16)
+		{
+			__m128i x = _mm_loadu_si128((const __m128i*)p);
+			int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, backslash)));
+			if (mask != 0)
+			{
+				p += lept_ctz(mask);
+				break;
+			}
+			p += 16;
+		}
+#endif
+		while (p < end && *p != '"' && *p != '\\')
+			p++;
+		if (p >= end)
+			return NULL;
+		if (*p == '"')
+			return p + 1;
+		if ((p += 2) > end)		//反斜杠和被转义的字符
+			return NULL;
+	}
+}
+
+//快速跳过数组/对象的剩余部分（p在开头的括号之后），只跟踪字符串和括号的层数。
+//SSE2下每次检查16个字节：不含引号和反斜杠、且右括号数少于当前层数的块只需累加括号数，其余的块跳到第一个需要处理的字符。
+//返回结束括号之后的位置，未结束时返回NULL并用*in_string说明是否结束在字符串中
+static const char* lept_skip_container_fast(const char* p, const char* end, int* in_string)
+{
+	size_t depth = 1;
+	*in_string = 0;
+	for (;;)
+	{
+		char ch;
+#ifdef LEPT_SSE2
+		const __m128i quote = _mm_set1_epi8('"'), backslash = _mm_set1_epi8('\\');
+		const __m128i lsquare = _mm_set1_epi8('['), rsquare = _mm_set1_epi8(']');
+		const __m128i lcurly = _mm_set1_epi8('{'), rcurly = _mm_set1_epi8('}');
+		while (end - p >= 16)
+		{
+			__m128i x = _mm_loadu_si128((const __m128i*)p);
+			unsigned special = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, backslash)));
+			unsigned open = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x, lsquare), _mm_cmpeq_epi8(x, lcurly)));
+			unsigned close = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x, rsquare), _mm_cmpeq_epi8(x, rcurly)));
+			size_t closes = (size_t)lept_popcount16(close);
+			if (special == 0 && closes < depth)		//本块内层数不会归零
+			{
+				depth += (size_t)lept_popcount16(open) - closes;
+				p += 16;
+				continue;
+			}
+			p += lept_ctz(special | open | close);	//special或close非0，跳到第一个需要处理的字符
+			break;
+		}
+#endif
+		if (p >= end)
+			return NULL;
+		ch = *p++;
+		if (ch == '"')
+		{
+			if ((p = lept_skip_string_fast(p, end)) == NULL)
+			{
+				*in_string = 1;
+				return NULL;
+			}
+		}
+		else if (ch == '[' || ch == '{')
+			depth++;
+		else if ((ch == ']' || ch == '}') && --depth == 0)
+			return p;
+	}
+}
+
+//快速跳过一个值（*pp处，前导空白已跳过）：不解码转义、不转换数字，只识别字符串和括号的结构，
+//但仍能发现未结束的字符串、数组和对象，以及缺少的值。出错时*pp为出错的位置：未结束时为end，缺少值时不变
+static int lept_skip_value_fast(const char** pp, const char* end)
+{
+	const char* p = *pp;
+	int in_string;
+	switch (PEEK(p, end))
+	{
+	case '\0':
+		return LEPT_PARSE_EXPECT_VALUE;
+	case '"':
+		if ((p = lept_skip_string_fast(p + 1, end)) == NULL)
+		{
+			*pp = end;
+			return LEPT_PARSE_MISS_QUOTATION_MARK;
+		}
+		break;
+	case '[':
+	case '{':
+		if ((p = lept_skip_container_fast(p + 1, end, &in_string)) == NULL)
+		{
+			int ret = in_string ? LEPT_PARSE_MISS_QUOTATION_MARK :
+				**pp == '[' ? LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET : LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+			*pp = end;
+			return ret;
+		}
+		break;
+	default:	//数字和字面值：一直到分隔符为止
+		while (p < end && *p != ',' && *p != ']' && *p != '}' && *p != '\0' &&
+			*p != ' ' && *p != '\t' && *p != '\n' && *p != '\r')
+			p++;
+		if (p == *pp)
+			return LEPT_PARSE_INVALID_VALUE;
+		break;
+	}
+	*pp = p;
+	return LEPT_PARSE_OK;
+}
+
+//快速跳过json中的一个JSON值，consumed返回该值之后的位置（出错时为出错的位置，见lept_skip_value_fast）
+int lept_skip_value(const char* json, size_t len, size_t* consumed)
+{
+	const char* p = lept_validate_whitespace(json, json + len);
+	int ret;
+	assert(json != NULL || len == 0);
+	ret = lept_skip_value_fast(&p, json + len);
+	if (consumed)
+		*consumed = (size_t)(p - json);
+	return ret;
+}
+
+//选择性解析时跳过当前的值：默认只校验不建树，错误码与lept_parse_value相同；
+//开启LEPT_FLAG_FAST_SKIP时只跟踪结构，不校验
+static int lept_parse_skip(lept_context* c)
+{
+	const char* p = c->json;
+	int ret = (c->flags & LEPT_FLAG_FAST_SKIP) ? lept_skip_value_fast(&p, c->end) : lept_scan_value(&p, c->end, NULL);
+	if (ret == LEPT_PARSE_OK)
+		c->json = p;
+	return ret;
+}
+
+//JSON Pointer（RFC 6901）：cursor指向路径中剩余的部分（"/token..."），token与key相同时返回下一段的位置，否则返回NULL。
+//token中的 ~1 表示 '/'，~0 表示 '~'
+static const char* lept_pointer_match(const char* cursor, const char* key, size_t klen)
+{
+	size_t i = 0;
+	assert(*cursor == '/');
+	for (cursor++; *cursor != '\0' && *cursor != '/'; cursor++, i++)
+	{
+		char ch = *cursor;
+		if (ch == '~')
+		{
+			//与lept_pointer_token一致，只接受~0与~1，末尾的~也视为不匹配
+			if (cursor[1] == '0') ch = '~';
+			else if (cursor[1] == '1') ch = '/';
+			else return NULL;
+			cursor++;
+		}
+		if (i >= klen || key[i] != ch)
+			return NULL;
+	}
+	return i == klen ? cursor : NULL;
+}
+
+static int lept_parse_select_value(lept_context* c, lept_value* v, const char** cur, size_t n, int* selected);
+
+//选择性解析数组：未被选中的元素只校验并跳过，以null占位，保持下标不变
+static int lept_parse_select_array(lept_context* c, lept_value* v, const char** cur, size_t n)
+{
+	size_t i, m, size = 0;
+	const char** child;
+	char index[24];
+	int ret, selected;
+	EXPECT(c, '[');
+	lept_parse_whitespace(c);
+	if (*c->json == ']')
+	{
+		c->json++;
+		lept_set_array(v, 0);
+		return LEPT_PARSE_OK;
+	}
+	child = (const char**)malloc(n * sizeof(const char*));
+	for (;;)
+	{
+		lept_value e;
+		lept_init(&e);
+		sprintf(index, "%lu", (unsigned long)size);
+		for (i = m = 0; i < n; i++)		//找出下一段与下标匹配的路径
+			if ((child[m] = lept_pointer_match(cur[i], index, strlen(index))) != NULL)
+				m++;
+		if ((ret = m == 0 ? lept_parse_skip(c) : lept_parse_select_value(c, &e, child, m, &selected)) != LEPT_PARSE_OK)
+			break;
+		memcpy(lept_context_push(c, sizeof(lept_value)), &e, sizeof(lept_value));
+		size++;
+		lept_parse_whitespace(c);
+		if (*c->json == ',')
+		{
+			c->json++;
+			lept_parse_whitespace(c);
+		}
+		else if (*c->json == ']')
+		{
+			c->json++;
+			lept_set_array(v, size);
+			memcpy(v->u.a.e, lept_context_pop(c, size * sizeof(lept_value)), size * sizeof(lept_value));
+			v->u.a.size = size;
+			free(child);
+			return LEPT_PARSE_OK;
+		}
+		else
+		{
+			ret = LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+			break;
+		}
+	}
+	free(child);
+	for (i = 0; i < size; i++)
+		lept_free((lept_value*)lept_context_pop(c, sizeof(lept_value)));
+	return ret;
+}
+
+//选择性解析对象：未被选中的成员只校验并跳过，不出现在结果中
+static int lept_parse_select_object(lept_context* c, lept_value* v, const char** cur, size_t n)
+{
+	size_t i, m, size = 0;
+	const char** child;
+	lept_member mem;
+	int ret, selected = 0;
+	EXPECT(c, '{');
+	lept_parse_whitespace(c);
+	if (*c->json == '}')
+	{
+		c->json++;
+		lept_set_object(v, 0);
+		return LEPT_PARSE_OK;
+	}
+	child = (const char**)malloc(n * sizeof(const char*));
+	mem.k = NULL;
+	for (;;)
+	{
+		char* str;
+		lept_init(&mem.v);
+		if (*c->json != '"')
+		{
+			ret = LEPT_PARSE_MISS_KEY;
+			break;
+		}
+		if ((ret = lept_parse_string_raw(c, &str, &mem.klen)) != LEPT_PARSE_OK)
+			break;
+		for (i = m = 0; i < n; i++)		//找出下一段与key匹配的路径，此时str仍指向栈中的key
+			if ((child[m] = lept_pointer_match(cur[i], str, mem.klen)) != NULL)
+				m++;
+		if (m > 0)	//只有被选中的成员才复制key
+		{
+			mem.k = (char*)malloc(mem.klen + 1);
+			if (mem.klen > 0)	//空key时str可能为NULL
+				memcpy(mem.k, str, mem.klen);
+			mem.k[mem.klen] = '\0';
+		}
+		lept_parse_whitespace(c);
+		if (*c->json != ':')
+		{
+			ret = LEPT_PARSE_MISS_COLON;
+			break;
+		}
+		c->json++;
+		lept_parse_whitespace(c);
+		selected = 0;
+		if ((ret = m == 0 ? lept_parse_skip(c) : lept_parse_select_value(c, &mem.v, child, m, &selected)) != LEPT_PARSE_OK)
+			break;
+		if (selected)
+		{
+			memcpy(lept_context_push(c, sizeof(lept_member)), &mem, sizeof(lept_member));
+			size++;
+		}
+		else
+			free(mem.k);
+		mem.k = NULL;
+		lept_parse_whitespace(c);
+		if (*c->json == ',')
+		{
+			c->json++;
+			lept_parse_whitespace(c);
+		}
+		else if (*c->json == '}')
+		{
+			size_t s = sizeof(lept_member) * size;
+			c->json++;
+			lept_set_object(v, size);
+			if (size > 0)		//没有成员被选中时m为NULL
+				memcpy(v->u.o.m, lept_context_pop(c, s), s);
+			v->u.o.size = size;
+			free(child);
+			return LEPT_PARSE_OK;
+		}
+		else
+		{
+			ret = LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+			break;
+		}
+	}
+	free(child);
+	free(mem.k);
+	for (i = 0; i < size; i++)
+	{
+		lept_member* pm = (lept_member*)lept_context_pop(c, sizeof(lept_member));
+		free(pm->k);
+		lept_free(&pm->v);
+	}
+	v->type = LEPT_NULL;
+	return ret;
+}
+
+//cur中有路径已经走完时，整棵子树都需要，按普通方式解析；
+//否则只有数组和对象可能包含被选中的部分，标量直接跳过，selected置0
+static int lept_parse_select_value(lept_context* c, lept_value* v, const char** cur, size_t n, int* selected)
+{
+	size_t i;
+	*selected = 1;
+	for (i = 0; i < n; i++)
+		if (*cur[i] == '\0')
+			return lept_parse_value(c, v);
+	switch (*c->json)
+	{
+	case '[':	return lept_parse_select_array(c, v, cur, n);
+	case '{':	return lept_parse_select_object(c, v, cur, n);
+	default:
+		*selected = 0;
+		return lept_parse_skip(c);
+	}
+}
+
+//选择性解析：只为paths（JSON Pointer，如 "/a/b/0"，""表示整个文本）指向的子树以及通往它们的数组/对象建立节点，
+//其余部分只校验不建树。未选中的对象成员被省略，未选中的数组元素以null占位。错误码与lept_parse相同。
+//flags为 LEPT_FLAG_* 的组合，LEPT_FLAG_FAST_SKIP 时跳过的部分只检查结构
+int lept_parse_select(lept_value* v, const char* json, const char* const* paths, size_t count, int flags)
+{
+	lept_context c;
+	const char** cur;
+	size_t i, n = 0;
+	int ret, selected;
+	assert(v != NULL && json != NULL && (paths != NULL || count == 0));
+	c.json = json;
+	c.end = json + strlen(json);
+	c.stack = NULL;
+	c.size = c.top = 0;
+	c.flags = flags;
+	lept_init(v);
+	cur = (const char**)malloc((count > 0 ? count : 1) * sizeof(const char*));
+	for (i = 0; i < count; i++)
+		if (paths[i][0] == '\0' || paths[i][0] == '/')	//不以'/'开头的路径不是合法的JSON Pointer，忽略
+			cur[n++] = paths[i];
+	lept_parse_whitespace(&c);
+	if ((ret = lept_parse_select_value(&c, v, cur, n, &selected)) == LEPT_PARSE_OK)
+	{
+		lept_parse_whitespace(&c);
+		if (*c.json != '\0')
+			ret = LEPT_PARSE_ROOT_NOT_SINGULAR;
+	}
+	if (ret != LEPT_PARSE_OK)
+		lept_free(v);
+	free(cur);
+	assert(c.top == 0);
+	free(c.stack);
+	return ret;
+}
+
+//字符串化，生成字符串并压入栈
+//最后没有往栈中压入空字符'\0'的原因：解析的字符串只是JSON的一个节点，若加入了空字符，则表示JSON到此结束
+//'\0'表示JSON字符串的结束
+static const char lept_hex_upper[] = { '0','1','2','3','4','5','6','7','8','9','A','B','C','D','E','F' };
+static const char lept_hex_lower[] = { '0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f' };
+
+//hex_digits决定\u00xx中十六进制数字的大小写
+static void lept_stringify_string(lept_context* c, const char* s, size_t len, const char* hex_digits)
+{
+	size_t i, size;
+	char* head, * p;
+	assert(s != NULL);
+	//往栈中压入字符时，一开始和最后都要压入双引号字符"
+	p = head = lept_context_push(c, size = len * 6 + 2);	// "\u00xx..."
+	*p++ = '"';
+	for (i = 0; i < len; i++)
+	{
+		unsigned char ch = (unsigned char)s[i];
+		switch (ch)
+		{
+		//转义字符
+		case '\"': *p++ = '\\'; *p++ = '\"'; break;
+		case '\\': *p++ = '\\'; *p++ = '\\'; break;
+		case '\b': *p++ = '\\'; *p++ = 'b'; break;
+		case '\f': *p++ = '\\'; *p++ = 'f'; break;
+		case '\n': *p++ = '\\'; *p++ = 'n'; break;
+		case '\r': *p++ = '\\'; *p++ = 'r'; break;
+		case '\t': *p++ = '\\'; *p++ = 't'; break;
+		default:
+			if (ch < 0x20)
+			{
+				//以\u00xx表示
+				*p++ = '\\'; *p++ = 'u'; *p++ = '0'; *p++ = '0';
+				*p++ = hex_digits[ch >> 4];
+				*p++ = hex_digits[ch & 15];
+			}
+			else
+			{
+				*p++ = s[i];
+			}
+		}
+	}
+	*p++ = '"';
+	c->top -= size - (p - head);	//调整栈顶指针
+}
+
+//数组/对象缓存的输出，json不以'\0'结尾
+typedef struct
+{
+	size_t len;
+	char json[1];
+}lept_cache;
+
+//lept_stringify_value 的选项，使用已有的缓存，并为输出较大的数组/对象建立缓存
+#define LEPT_STRINGIFY_USE_CACHE	1
+
+//数组/对象的元素/成员数组（包括紧凑数组的 double[]）前面有一个指针大小的头部，存放缓存的指针。
+//缓存不占用每个节点的空间，随数组一起realloc和转移；容量为0、没有元素数组的数组/对象不缓存
+#define LEPT_BLOCK_HEADER	sizeof(lept_cache*)
+#define LEPT_BLOCK_OF(v)	((v)->type == LEPT_ARRAY ? (void*)(v)->u.a.e : (void*)(v)->u.o.m)
+#define LEPT_CACHE_OF(block)	((lept_cache**)(block) - 1)
+
+//分配size字节的元素/成员数组，size为0时返回NULL
+static void* lept_block_alloc(size_t size)
+{
+	char* p;
+	if (size == 0)
+		return NULL;
+	p = (char*)malloc(LEPT_BLOCK_HEADER + size);
+	LEPT_STAT_ADD(malloc_calls, 1);
+	LEPT_STAT_ADD(malloc_bytes, LEPT_BLOCK_HEADER + size);
+	*(lept_cache**)p = NULL;
+	return p + LEPT_BLOCK_HEADER;
+}
+
+//改变元素/成员数组的大小，缓存随之保留
+static void* lept_block_realloc(void* block, size_t size)
+{
+	char* p;
+	if (block == NULL)
+		return lept_block_alloc(size);
+	p = (char*)realloc(LEPT_CACHE_OF(block), LEPT_BLOCK_HEADER + size);
+	LEPT_STAT_ADD(realloc_calls, 1);
+	LEPT_STAT_ADD(realloc_bytes, LEPT_BLOCK_HEADER + size);
+	return p + LEPT_BLOCK_HEADER;
+}
+
+//释放元素/成员数组的缓存，owned为真时连同数组本身一起释放（压缩树的内部节点的数组属于整块内存）
+static void lept_block_free(void* block, int owned)
+{
+	if (block == NULL)
+		return;
+	free(*LEPT_CACHE_OF(block));
+	if (owned)
+		free(LEPT_CACHE_OF(block));
+	else
+		*LEPT_CACHE_OF(block) = NULL;
+}
+
+//生成JSON。LEPT_STRINGIFY_USE_CACHE 时数组/对象有缓存则直接复制缓存
+static void lept_stringify_value(lept_context* c, const lept_value* v)
+{
+	size_t i, head = c->top;
+	lept_cache** cache;
+	lept_value tmp;
+	if ((c->flags & LEPT_STRINGIFY_USE_CACHE) && (v->type == LEPT_ARRAY || v->type == LEPT_OBJECT) &&
+		LEPT_BLOCK_OF(v) != NULL && *(cache = LEPT_CACHE_OF(LEPT_BLOCK_OF(v))) != NULL)
+	{
+		PUTS(c, (*cache)->json, (*cache)->len);
+		return;
+	}
+	switch (v->type)
+	{
+	case LEPT_NULL:		PUTS(c, "null", 4); break;
+	case LEPT_FALSE:	PUTS(c, "false", 5); break;
+	case LEPT_TRUE:		PUTS(c, "true", 4); break;
+	//把浮点数转换成文本，"%.17g" 是足够把双精度浮点转换成可还原的文本。
+	case LEPT_NUMBER:
+		if (v->lazy)	//LEPT_FLAG_LAZY：原样输出源文本，保留全部精度
+		{
+			PUTS(c, v->u.nr.raw, v->u.nr.rawlen);
+		}
+		else
+			c->top -= 32 - sprintf(lept_context_push(c, 32), "%.17g", v->u.n);
+		break;
+	case LEPT_STRING:
+		if (v->lazy == LEPT_LAZY_PENDING)
+		{
+			PUTS(c, v->u.s.s, v->u.s.len);
+		}
+		else if (v->lazy)
+		{
+			PUTS(c, LEPT_LAZY_SOURCE_OF(v)->raw, LEPT_LAZY_SOURCE_OF(v)->rawlen);
+		}
+		else
+			lept_stringify_string(c, v->u.s.s, v->u.s.len, lept_hex_upper);
+		break;
+	case LEPT_ARRAY:	
+		PUTC(c, '[');
+		for (i = 0; i < v->u.a.size; i++)
+		{
+			if (i > 0)
+				PUTC(c, ',');
+			lept_stringify_value(c, lept_array_at(v, i, &tmp));	//生成数组中的元素
+		}
+		PUTC(c, ']');
+		break;
+	case LEPT_OBJECT:
+		PUTC(c, '{');
+		for (i = 0; i < v->u.o.size; i++)
+		{
+			if (i > 0)
+				PUTC(c, ',');
+			lept_stringify_string(c, v->u.o.m[i].k, v->u.o.m[i].klen, lept_hex_upper);	//生成对象中成员的key
+			PUTC(c, ':');
+			lept_stringify_value(c, &v->u.o.m[i].v);		//生成对象中成员的value
+		}
+		PUTC(c, '}');
+		break;
+	default: assert(0 && "invalid type");
+	}
+	//缓存只是输出的副本，不改变节点的值，所以const节点也可以填充缓存
+	if ((c->flags & LEPT_STRINGIFY_USE_CACHE) && (v->type == LEPT_ARRAY || v->type == LEPT_OBJECT) &&
+		LEPT_BLOCK_OF(v) != NULL && c->top - head >= LEPT_STRINGIFY_CACHE_MIN_SIZE)
+	{
+		cache = LEPT_CACHE_OF(LEPT_BLOCK_OF(v));
+		*cache = (lept_cache*)malloc(offsetof(lept_cache, json) + c->top - head);
+		(*cache)->len = c->top - head;
+		memcpy((*cache)->json, c->stack + head, c->top - head);
+	}
+}
+
+//按flags生成JSON文本
+static char* lept_stringify_with(const lept_value* v, size_t* length, int flags)
+{
+	lept_context c;
+	assert(v != NULL);
+	c.stack = (char*)malloc(c.size = LEPT_PARSE_STACK_INIT_SIZE);	//分配栈内存，用以存储生成的JSON
+	c.top = 0;
+	c.flags = flags;
+	lept_stringify_value(&c, v);
+	if (length)
+		*length = c.top;	//记录生成的JSON长度
+	PUTC(&c, '\0');
+	return c.stack;
+}
+
+//将节点树字符串化生成JSON文本。不读取缓存，所以通过元素指针修改深层节点后结果也是最新的
+char* lept_stringify(const lept_value* v, size_t* length)
+{
+	return lept_stringify_with(v, length, 0);
+}
+
+//字符串化并为输出较大的数组/对象建立缓存。修改后只有缓存被丢弃的路径需要重新生成，
+//其余子树直接复制，代价与修改的范围成正比。嵌套的缓存会重复保存子树的输出，以内存换时间
+char* lept_stringify_cached(lept_value* v, size_t* length)
+{
+	return lept_stringify_with(v, length, LEPT_STRINGIFY_USE_CACHE);
+}
+
+//丢弃数组/对象的缓存，其他类型不做任何事
+void lept_invalidate(lept_value* v)
+{
+	assert(v != NULL);
+	if (v->type == LEPT_ARRAY || v->type == LEPT_OBJECT)
+		lept_block_free(LEPT_BLOCK_OF(v), 0);
+}
+
+//规范化输出数字：与ECMAScript的Number.prototype.toString相同，取能还原该double的最短十进制表示（RFC 8785）
+static void lept_stringify_canonical_number(lept_context* c, double n)
+{
+	char buf[32], digits[20], *p, *head;
+	int prec, k = 0, e, i;
+	if (n == 0.0)	//包括-0
+	{
+		PUTC(c, '0');
+		return;
+	}
+	if (n > -9007199254740992.0 && n < 9007199254740992.0 && n == (double)(long long)n)
+	{
+		c->top -= 32 - sprintf(lept_context_push(c, 32), "%lld", (long long)n);	//整数快速路径
+		return;
+	}
+	for (prec = 1; prec < 17; prec++)	//找到能还原n的最短有效位数
+	{
+		sprintf(buf, "%.*e", prec - 1, n);
+		if (strtod(buf, NULL) == n)
+			break;
+	}
+	if (prec == 17)
+		sprintf(buf, "%.16e", n);
+	//buf形如 -d.ddde+xx，取出有效数字和指数
+	for (p = buf + (buf[0] == '-'); *p != 'e'; p++)
+		if (*p != '.')
+			digits[k++] = *p;
+	while (k > 1 && digits[k - 1] == '0')
+		k--;
+	e = atoi(p + 1) + 1;	//数值为 0.digits × 10^e
+	p = head = lept_context_push(c, 32);
+	if (n < 0)
+		*p++ = '-';
+	if (k <= e && e <= 21)			//整数：digits后补0
+	{
+		memcpy(p, digits, k);
+		p += k;
+		for (i = k; i < e; i++)
+			*p++ = '0';
+	}
+	else if (0 < e && e <= 21)		//小数点在digits中间
+	{
+		memcpy(p, digits, e);
+		p += e;
+		*p++ = '.';
+		memcpy(p, digits + e, k - e);
+		p += k - e;
+	}
+	else if (-6 < e && e <= 0)		//0.000ddd
+	{
+		*p++ = '0';
+		*p++ = '.';
+		for (i = e; i < 0; i++)
+			*p++ = '0';
+		memcpy(p, digits, k);
+		p += k;
+	}
+	else							//科学计数法 d.ddde±x
+	{
+		*p++ = digits[0];
+		if (k > 1)
+		{
+			*p++ = '.';
+			memcpy(p, digits + 1, k - 1);
+			p += k - 1;
+		}
+		p += sprintf(p, "e%c%d", e - 1 < 0 ? '-' : '+', e - 1 < 0 ? 1 - e : e - 1);
+	}
+	c->top -= 32 - (p - head);
+}
+
+//按key排序成员：比较UTF-16码元顺序（RFC 8785），与UTF-8字节序只在U+10000以上的码点与U+E000~U+FFFF之间不同。
+//key相同时按成员原有位置排序，保证输出确定
+static int lept_compare_member_key(const void* lhs, const void* rhs)
+{
+	const lept_member* a = *(const lept_member* const*)lhs;
+	const lept_member* b = *(const lept_member* const*)rhs;
+	size_t i, n = a->klen < b->klen ? a->klen : b->klen;
+	unsigned char x, y;
+	for (i = 0; i < n && a->k[i] == b->k[i]; i++);
+	if (i == n)
+	{
+		if (a->klen != b->klen)
+			return a->klen < b->klen ? -1 : 1;
+		return a < b ? -1 : (a > b);
+	}
+	x = (unsigned char)a->k[i];
+	y = (unsigned char)b->k[i];
+	//首字节F0~F4的码点在UTF-16中编码为代理项D800~DBFF，排在首字节EE、EF的码点之前
+	if (x >= 0xF0 && (y == 0xEE || y == 0xEF))
+		return -1;
+	if (y >= 0xF0 && (x == 0xEE || x == 0xEF))
+		return 1;
+	return x < y ? -1 : 1;
+}
+
+static void lept_stringify_canonical_value(lept_context* c, const lept_value* v)
+{
+	size_t i;
+	lept_value tmp;
+	LEPT_DECODE(v);
+	switch (v->type)
+	{
+	case LEPT_NUMBER:	lept_stringify_canonical_number(c, v->u.n); break;
+	case LEPT_STRING:	lept_stringify_string(c, v->u.s.s, v->u.s.len, lept_hex_lower); break;
+	case LEPT_ARRAY:
+		PUTC(c, '[');
+		for (i = 0; i < v->u.a.size; i++)
+		{
+			if (i > 0)
+				PUTC(c, ',');
+			lept_stringify_canonical_value(c, lept_array_at(v, i, &tmp));
+		}
+		PUTC(c, ']');
+		break;
+	case LEPT_OBJECT:
+	{
+		//只对成员指针排序，不复制key，也不改变原节点
+		const lept_member* local[16];
+		const lept_member** order = v->u.o.size <= 16 ? local : (const lept_member**)malloc(v->u.o.size * sizeof(lept_member*));
+		for (i = 0; i < v->u.o.size; i++)
+			order[i] = &v->u.o.m[i];
+		qsort(order, v->u.o.size, sizeof(lept_member*), lept_compare_member_key);
+		PUTC(c, '{');
+		for (i = 0; i < v->u.o.size; i++)
+		{
+			if (i > 0)
+				PUTC(c, ',');
+			lept_stringify_string(c, order[i]->k, order[i]->klen, lept_hex_lower);
+			PUTC(c, ':');
+			lept_stringify_canonical_value(c, &order[i]->v);
+		}
+		PUTC(c, '}');
+		if (order != local)
+			free((void*)order);
+		break;
+	}
+	default:	lept_stringify_value(c, v); break;	//null、true、false与普通输出相同
+	}
+}
+
+//规范化生成JSON（RFC 8785）：对象成员按key排序，数字取最短还原表示，字符串只做必要的转义，
+//语义相同的节点树总是生成相同的文本，可用作缓存key或签名
+char* lept_stringify_canonical(const lept_value* v, size_t* length)
+{
+	lept_context c;
+	assert(v != NULL);
+	c.stack = (char*)malloc(c.size = LEPT_PARSE_STRINGIFY_INT_SIZE);
+	c.top = 0;
+	c.flags = 0;
+	lept_stringify_canonical_value(&c, v);
+	if (length)
+		*length = c.top;
+	PUTC(&c, '\0');
+	return c.stack;
+}
+
+//MessagePack编码：把n字节的无符号整数以大端序写入栈
+static void lept_encode_uint(lept_context* c, unsigned char tag, uint64_t u, int n)
+{
+	unsigned char* p = (unsigned char*)lept_context_push(c, n + 1);
+	*p++ = tag;
+	while (n-- > 0)
+		*p++ = (unsigned char)(u >> (n * 8));
+}
+
+//写入字符串、数组、对象的类型和长度，长度越小头部越短。MessagePack的长度最多32位，超出时返回0
+static int lept_encode_header(lept_context* c, unsigned char fix, size_t fixmax, unsigned char tag8, unsigned char tag16, size_t len)
+{
+	if (len <= fixmax)
+		PUTC(c, (char)(fix | len));
+	else if (tag8 != 0 && len <= 0xFF)
+		lept_encode_uint(c, tag8, len, 1);
+	else if (len <= 0xFFFF)
+		lept_encode_uint(c, tag16, len, 2);
+	else if ((uint64_t)len <= 0xFFFFFFFFu)
+		lept_encode_uint(c, (unsigned char)(tag16 + 1), len, 4);
+	else
+		return 0;
+	return 1;
+}
+
+//数字：整数值用最短的int格式，其余用float64
+static void lept_encode_number(lept_context* c, double n)
+{
+	uint64_t u;
+	if (n >= -9223372036854775808.0 && n < 9223372036854775808.0 && n == (double)(int64_t)n && !(n == 0.0 && 1 / n < 0))
+	{
+		int64_t i = (int64_t)n;
+		if (i >= 0)
+		{
+			if (i <= 0x7F)               PUTC(c, (char)i);		//positive fixint
+			else if (i <= 0xFF)          lept_encode_uint(c, 0xCC, (uint64_t)i, 1);
+			else if (i <= 0xFFFF)        lept_encode_uint(c, 0xCD, (uint64_t)i, 2);
+			else if (i <= 0xFFFFFFFFLL)  lept_encode_uint(c, 0xCE, (uint64_t)i, 4);
+			else                         lept_encode_uint(c, 0xCF, (uint64_t)i, 8);
+		}
+		else
+		{
+			if (i >= -32)                PUTC(c, (char)(0xE0 | (i + 32)));	//negative fixint
+			else if (i >= -0x80)         lept_encode_uint(c, 0xD0, (uint64_t)i, 1);
+			else if (i >= -0x8000)       lept_encode_uint(c, 0xD1, (uint64_t)i, 2);
+			else if (i >= -0x80000000LL) lept_encode_uint(c, 0xD2, (uint64_t)i, 4);
+			else                         lept_encode_uint(c, 0xD3, (uint64_t)i, 8);
+		}
+		return;
+	}
+	memcpy(&u, &n, sizeof(u));
+	lept_encode_uint(c, 0xCB, u, 8);
+}
+
+//编码一个节点，有长度无法编码的字符串/数组/对象时返回0
+static int lept_encode_value(lept_context* c, const lept_value* v)
+{
+	size_t i;
+	lept_value tmp;
+	LEPT_DECODE(v);
+	switch (v->type)
+	{
+	case LEPT_NULL:		PUTC(c, (char)0xC0); break;
+	case LEPT_FALSE:	PUTC(c, (char)0xC2); break;
+	case LEPT_TRUE:		PUTC(c, (char)0xC3); break;
+	case LEPT_NUMBER:	lept_encode_number(c, v->u.n); break;
+	case LEPT_STRING:
+		if (!lept_encode_header(c, 0xA0, 31, 0xD9, 0xDA, v->u.s.len))
+			return 0;
+		if (v->u.s.len > 0)
+			PUTS(c, v->u.s.s, v->u.s.len);
+		break;
+	case LEPT_ARRAY:
+		if (!lept_encode_header(c, 0x90, 15, 0, 0xDC, v->u.a.size))
+			return 0;
+		for (i = 0; i < v->u.a.size; i++)
+			if (!lept_encode_value(c, lept_array_at(v, i, &tmp)))
+				return 0;
+		break;
+	case LEPT_OBJECT:
+		if (!lept_encode_header(c, 0x80, 15, 0, 0xDE, v->u.o.size))
+			return 0;
+		for (i = 0; i < v->u.o.size; i++)
+		{
+			if (!lept_encode_header(c, 0xA0, 31, 0xD9, 0xDA, v->u.o.m[i].klen))
+				return 0;
+			if (v->u.o.m[i].klen > 0)
+				PUTS(c, v->u.o.m[i].k, v->u.o.m[i].klen);
+			if (!lept_encode_value(c, &v->u.o.m[i].v))
+				return 0;
+		}
+		break;
+	default: assert(0 && "invalid type");
+	}
+	return 1;
+}
+
+//将节点树编码成MessagePack，字符串和容器都带长度前缀，解码时无需转义也能预先分配空间。
+//长度超过32位的字符串/数组/对象无法表示，返回NULL而不是写出截断的长度
+char* lept_encode_binary(const lept_value* v, size_t* length)
+{
+	lept_context c;
+	assert(v != NULL);
+	c.stack = (char*)malloc(c.size = LEPT_PARSE_STRINGIFY_INT_SIZE);
+	c.top = 0;
+	if (!lept_encode_value(&c, v))
+	{
+		free(c.stack);
+		return NULL;
+	}
+	if (length)
+		*length = c.top;
+	return c.stack;
+}
+
+//解码MessagePack时使用的上下文
+typedef struct
+{
+	const unsigned char* p;		//当前位置
+	const unsigned char* end;	//数据末尾
+	int depth;					//当前数组/对象的嵌套层数，与lept_validate一样不超过LEPT_VALIDATE_MAX_DEPTH
+}lept_binary_context;
+
+//读取n字节的大端序无符号整数
+static int lept_decode_uint(lept_binary_context* c, int n, uint64_t* u)
+{
+	if (c->end - c->p < n)
+		return LEPT_PARSE_INVALID_BINARY;
+	*u = 0;
+	while (n-- > 0)
+		*u = (*u << 8) | *c->p++;
+	return LEPT_PARSE_OK;
+}
+
+//读取字符串的长度，字符串允许str和bin两类格式
+static int lept_decode_string_length(lept_binary_context* c, unsigned char tag, size_t* len)
+{
+	uint64_t u;
+	int ret = LEPT_PARSE_OK;
+	if ((tag & 0xE0) == 0xA0)
+		u = tag & 0x1F;
+	else if (tag == 0xD9 || tag == 0xC4)
+		ret = lept_decode_uint(c, 1, &u);
+	else if (tag == 0xDA || tag == 0xC5)
+		ret = lept_decode_uint(c, 2, &u);
+	else if (tag == 0xDB || tag == 0xC6)
+		ret = lept_decode_uint(c, 4, &u);
+	else
+		return LEPT_PARSE_INVALID_BINARY;
+	if (ret != LEPT_PARSE_OK || u > (uint64_t)(c->end - c->p))	//长度超出剩余数据
+		return LEPT_PARSE_INVALID_BINARY;
+	*len = (size_t)u;
+	return LEPT_PARSE_OK;
+}
+
+static int lept_decode_value(lept_binary_context* c, lept_value* v)
+{
+	uint64_t u;
+	size_t i, n;
+	unsigned char tag;
+	int ret;
+	if (c->p == c->end)
+		return LEPT_PARSE_INVALID_BINARY;
+	tag = *c->p++;
+	if (tag <= 0x7F)	//positive fixint
+	{
+		lept_set_number(v, tag);
+		return LEPT_PARSE_OK;
+	}
+	if (tag >= 0xE0)	//negative fixint
+	{
+		lept_set_number(v, (int)tag - 0x100);
+		return LEPT_PARSE_OK;
+	}
+	if ((tag & 0xE0) == 0xA0 || (tag >= 0xD9 && tag <= 0xDB) || (tag >= 0xC4 && tag <= 0xC6))
+	{
+		if ((ret = lept_decode_string_length(c, tag, &n)) != LEPT_PARSE_OK)
+			return ret;
+		lept_set_string(v, (const char*)c->p, n);
+		c->p += n;
+		return LEPT_PARSE_OK;
+	}
+	if ((tag & 0xF0) == 0x90 || tag == 0xDC || tag == 0xDD)
+	{
+		if ((tag & 0xF0) == 0x90)
+			u = tag & 0x0F;
+		else if ((ret = lept_decode_uint(c, tag == 0xDC ? 2 : 4, &u)) != LEPT_PARSE_OK)
+			return ret;
+		if (u > (uint64_t)(c->end - c->p))	//每个元素至少占1字节，防止恶意的长度导致超大分配
+			return LEPT_PARSE_INVALID_BINARY;
+		if (c->depth == LEPT_VALIDATE_MAX_DEPTH)	//每层递归一次，嵌套过深的数据会耗尽栈
+			return LEPT_PARSE_NESTING_TOO_DEEP;
+		c->depth++;
+		lept_set_array(v, (size_t)u);	//长度已知，一次分配
+		for (i = 0; i < (size_t)u; i++)
+		{
+			lept_init(&v->u.a.e[i]);
+			v->u.a.size++;
+			if ((ret = lept_decode_value(c, &v->u.a.e[i])) != LEPT_PARSE_OK)
+				return ret;
+		}
+		c->depth--;
+		return LEPT_PARSE_OK;
+	}
+	if ((tag & 0xF0) == 0x80 || tag == 0xDE || tag == 0xDF)
+	{
+		if ((tag & 0xF0) == 0x80)
+			u = tag & 0x0F;
+		else if ((ret = lept_decode_uint(c, tag == 0xDE ? 2 : 4, &u)) != LEPT_PARSE_OK)
+			return ret;
+		if (u > (uint64_t)(c->end - c->p) / 2)	//每个成员至少占2字节
+			return LEPT_PARSE_INVALID_BINARY;
+		if (c->depth == LEPT_VALIDATE_MAX_DEPTH)
+			return LEPT_PARSE_NESTING_TOO_DEEP;
+		c->depth++;
+		lept_set_object(v, (size_t)u);
+		for (i = 0; i < (size_t)u; i++)
+		{
+			lept_member* m = &v->u.o.m[i];
+			if (c->p == c->end)
+				return LEPT_PARSE_INVALID_BINARY;
+			tag = *c->p++;
+			if ((ret = lept_decode_string_length(c, tag, &n)) != LEPT_PARSE_OK)	//key必须是字符串
+				return ret;
+			memcpy(m->k = (char*)malloc(n + 1), c->p, n);
+			m->k[n] = '\0';
+			m->klen = n;
+			c->p += n;
+			lept_init(&m->v);
+			v->u.o.size++;
+			if ((ret = lept_decode_value(c, &m->v)) != LEPT_PARSE_OK)
+				return ret;
+		}
+		c->depth--;
+		return LEPT_PARSE_OK;
+	}
+	switch (tag)
+	{
+	case 0xC0: lept_set_null(v); return LEPT_PARSE_OK;
+	case 0xC2: lept_set_boolean(v, 0); return LEPT_PARSE_OK;
+	case 0xC3: lept_set_boolean(v, 1); return LEPT_PARSE_OK;
+	case 0xCA:	//float32
+	{
+		uint32_t u32;
+		float f;
+		if ((ret = lept_decode_uint(c, 4, &u)) != LEPT_PARSE_OK)
+			return ret;
+		u32 = (uint32_t)u;
+		memcpy(&f, &u32, sizeof(f));
+		lept_set_number(v, f);
+		return LEPT_PARSE_OK;
+	}
+	case 0xCB:	//float64
+	{
+		double d;
+		if ((ret = lept_decode_uint(c, 8, &u)) != LEPT_PARSE_OK)
+			return ret;
+		memcpy(&d, &u, sizeof(d));
+		lept_set_number(v, d);
+		return LEPT_PARSE_OK;
+	}
+	case 0xCC: case 0xCD: case 0xCE: case 0xCF:	//uint 8/16/32/64
+		if ((ret = lept_decode_uint(c, 1 << (tag - 0xCC), &u)) != LEPT_PARSE_OK)
+			return ret;
+		lept_set_number(v, (double)u);
+		return LEPT_PARSE_OK;
+	case 0xD0: case 0xD1: case 0xD2: case 0xD3:	//int 8/16/32/64，需要符号扩展
+	{
+		int bits = 8 << (tag - 0xD0);
+		if ((ret = lept_decode_uint(c, bits / 8, &u)) != LEPT_PARSE_OK)
+			return ret;
+		if (bits < 64 && (u >> (bits - 1)))
+			u |= ~(uint64_t)0 << bits;
+		lept_set_number(v, (double)(int64_t)u);
+		return LEPT_PARSE_OK;
+	}
+	default:	//ext类型和保留字节0xC1不对应任何JSON类型
+		return LEPT_PARSE_INVALID_BINARY;
+	}
+}
+
+//解码MessagePack，失败时节点为NULL类型
+int lept_decode_binary(lept_value* v, const char* data, size_t length)
+{
+	lept_binary_context c;
+	int ret;
+	assert(v != NULL && (data != NULL || length == 0));
+	c.p = (const unsigned char*)data;
+	c.end = c.p + length;
+	c.depth = 0;
+	lept_init(v);
+	if ((ret = lept_decode_value(&c, v)) == LEPT_PARSE_OK && c.p != c.end)
+		ret = LEPT_PARSE_ROOT_NOT_SINGULAR;		//一个值之后还有多余的数据
+	if (ret != LEPT_PARSE_OK)
+		lept_free(v);
+	return ret;
+}
+
+//释放节点所占的内存
+void lept_free(lept_value* v)
+{
+	size_t i;
+	assert(v != NULL);
+	switch (v->type)
+	{
+	case LEPT_STRING:	//释放字符串，未解码的字符串指向源文本
+		if (v->compact == LEPT_COMPACT_NONE && v->lazy != LEPT_LAZY_PENDING)
+			free(v->lazy == LEPT_LAZY_DECODED ? (void*)LEPT_LAZY_SOURCE_OF(v) : (void*)v->u.s.s);
+		break;
+	case LEPT_ARRAY:
+		//压缩树中也可能有后来加入的普通节点，仍然逐个递归
+		for (i = 0; !v->packed && i < v->u.a.size; i++)
+			lept_free(&v->u.a.e[i]);	//递归释放数组各个元素所指向的内存空间
+		lept_block_free(v->u.a.e, v->compact != LEPT_COMPACT_INNER);	//最后释放数组指针，压缩树的根释放的是整块内存
+		break;
+	case LEPT_OBJECT:
+		for (i = 0; i < v->u.o.size; i++)
+		{
+			if (v->compact == LEPT_COMPACT_NONE)
+				free(v->u.o.m[i].k);	//释放对象中成员的key值
+			lept_free(&v->u.o.m[i].v);		//递归释放对象中成员的value值
+		}
+		lept_block_free(v->u.o.m, v->compact != LEPT_COMPACT_INNER);	//最后释放对象成员指针
+		break;
+	default:
+		break;
+	}
+	v->type = LEPT_NULL;
+	v->lazy = LEPT_LAZY_NONE;
+	v->compact = LEPT_COMPACT_NONE;
+	v->packed = 0;
+}
+
+//深度复制节点，每个数组/对象按元素个数一次性分配空间
+static void lept_copy_to(lept_value* dst, const lept_value* src)
+{
+	size_t i;
+	switch (src->type)
+	{
+	case LEPT_STRING:
+		LEPT_DECODE(src);
+		lept_set_string(dst, src->u.s.s, src->u.s.len);
+		break;
+	case LEPT_ARRAY:
+		if (src->packed)
+		{
+			if (src->u.pa.size > 0)
+				memcpy(lept_set_packed(dst, src->u.pa.size), src->u.pa.d, src->u.pa.size * sizeof(double));
+			else
+				lept_set_packed(dst, 0);
+			break;
+		}
+		lept_set_array(dst, src->u.a.size);
+		for (i = 0; i < src->u.a.size; i++)
+		{
+			lept_init(&dst->u.a.e[i]);
+			lept_copy_to(&dst->u.a.e[i], &src->u.a.e[i]);
+		}
+		dst->u.a.size = src->u.a.size;
+		break;
+	case LEPT_OBJECT:
+		lept_set_object(dst, src->u.o.size);
+		for (i = 0; i < src->u.o.size; i++)
+		{
+			lept_member* m = &dst->u.o.m[i];
+			memcpy(m->k = (char*)malloc(src->u.o.m[i].klen + 1), src->u.o.m[i].k, src->u.o.m[i].klen + 1);
+			m->klen = src->u.o.m[i].klen;
+			lept_init(&m->v);
+			lept_copy_to(&m->v, &src->u.o.m[i].v);
+		}
+		dst->u.o.size = src->u.o.size;
+		break;
+	default:	//null、bool、number不含堆内存，直接拷贝
+		LEPT_DECODE(src);
+		lept_free(dst);
+		memcpy(dst, src, sizeof(lept_value));
+		dst->lazy = LEPT_LAZY_NONE;		//副本不引用源文本
+		dst->compact = LEPT_COMPACT_NONE;
+		break;
+	}
+}
+
+//src可以是dst的子节点：先复制到临时节点，再释放dst
+void lept_copy(lept_value* dst, const lept_value* src)
+{
+	lept_value temp;
+	assert(src != NULL && dst != NULL && src != dst);
+	lept_init(&temp);
+	lept_copy_to(&temp, src);
+	lept_free(dst);
+	memcpy(dst, &temp, sizeof(lept_value));
+}
+
+//把压缩树中的节点连同子树复制回普通内存，原来的存储留给整块内存统一释放。
+//只复制这一层时，留在整块内存中的子节点会挂在普通节点下面，lept_move/lept_swap就无法判断能否直接转移。
+//对根节点调用时整块内存随之释放，等于复制整棵树
+static void lept_thaw(lept_value* v)
+{
+	lept_value temp;
+	lept_init(&temp);
+	lept_copy(&temp, v);
+	lept_free(v);
+	memcpy(v, &temp, sizeof(lept_value));
+}
+
+//移动节点，只转移所有权，不复制子树，O(1)。压缩树的内部节点不能单独拥有存储，只能复制
+void lept_move(lept_value* dst, lept_value* src)
+{
+	lept_value temp;
+	assert(dst != NULL && src != NULL && src != dst);
+	//src可以是dst的子节点：先把src取出并置为NULL，再释放dst
+	lept_init(&temp);
+	if (src->compact == LEPT_COMPACT_INNER)
+	{
+		lept_copy_to(&temp, src);
+		lept_free(src);
+	}
+	else
+		memcpy(&temp, src, sizeof(lept_value));
+	lept_init(src);
+	lept_free(dst);
+	memcpy(dst, &temp, sizeof(lept_value));
+}
+
+//交换两个节点，O(1)。压缩树的内部节点先复制回普通内存
+void lept_swap(lept_value* lhs, lept_value* rhs)
+{
+	assert(lhs != NULL && rhs != NULL);
+	if (lhs != rhs)
+	{
+		lept_value temp;
+		if (lhs->compact == LEPT_COMPACT_INNER)
+			lept_thaw(lhs);
+		if (rhs->compact == LEPT_COMPACT_INNER)
+			lept_thaw(rhs);
+		memcpy(&temp, lhs, sizeof(lept_value));
+		memcpy(lhs, rhs, sizeof(lept_value));
+		memcpy(rhs, &temp, sizeof(lept_value));
+	}
+}
+
+//lept_compact 中数组/对象的元素在整块内存中的对齐，不小于 lept_value/lept_member 中double、指针和size_t的对齐
+#define LEPT_COMPACT_ALIGN 8
+
+typedef struct
+{
+	lept_value* dst;
+	const lept_value* src;
+}lept_compact_item;
+
+typedef struct
+{
+	char* base;
+	size_t size, top;
+	int order;
+	lept_compact_item* queue;	//广度优先时等待放置元素/成员的数组/对象
+	size_t count, capacity;
+}lept_compactor;
+
+//计算节点的字符串/元素/成员（不含节点本身）在整块内存中最多占用的字节数，每个数组按最坏情况预留对齐的空间
+static size_t lept_compact_size(const lept_value* v)
+{
+	size_t i, size = 0;
+	switch (v->type)
+	{
+	case LEPT_STRING:
+		LEPT_DECODE(v);
+		return v->u.s.len + 1;
+	case LEPT_ARRAY:
+		if (v->u.a.size > 0)
+			size = LEPT_BLOCK_HEADER + v->u.a.size * (v->packed ? sizeof(double) : sizeof(lept_value)) + LEPT_COMPACT_ALIGN - 1;
+		for (i = 0; !v->packed && i < v->u.a.size; i++)
+			size += lept_compact_size(&v->u.a.e[i]);
+		return size;
+	case LEPT_OBJECT:
+		if (v->u.o.size > 0)
+			size = LEPT_BLOCK_HEADER + v->u.o.size * sizeof(lept_member) + LEPT_COMPACT_ALIGN - 1;
+		for (i = 0; i < v->u.o.size; i++)
+			size += v->u.o.m[i].klen + 1 + lept_compact_size(&v->u.o.m[i].v);
+		return size;
+	default:
+		return 0;
+	}
+}
+
+static void* lept_compact_alloc(lept_compactor* c, size_t size, size_t align)
+{
+	void* p;
+	c->top = (c->top + align - 1) & ~(align - 1);
+	p = c->base + c->top;
+	c->top += size;
+	assert(c->top <= c->size);
+	return p;
+}
+
+//在整块内存中放置元素/成员数组，前面同样留出缓存的头部
+static void* lept_compact_block(lept_compactor* c, size_t size)
+{
+	char* p = (char*)lept_compact_alloc(c, LEPT_BLOCK_HEADER + size, LEPT_COMPACT_ALIGN);
+	*(lept_cache**)p = NULL;
+	return p + LEPT_BLOCK_HEADER;
+}
+
+//复制节点本身，字符串紧跟着放入整块内存；数组/对象的元素/成员由 lept_compact_children 放置
+static void lept_compact_node(lept_compactor* c, lept_value* dst, const lept_value* src)
+{
+	LEPT_DECODE(src);
+	dst->type = src->type;
+	dst->lazy = LEPT_LAZY_NONE;
+	dst->compact = LEPT_COMPACT_INNER;
+	dst->packed = src->type == LEPT_ARRAY && src->packed;
+	switch (src->type)
+	{
+	case LEPT_STRING:
+		dst->u.s.s = (char*)lept_compact_alloc(c, src->u.s.len + 1, 1);
+		memcpy(dst->u.s.s, src->u.s.s, src->u.s.len + 1);
+		dst->u.s.len = src->u.s.len;
+		break;
+	case LEPT_ARRAY:
+		dst->u.a.e = NULL;
+		dst->u.a.size = dst->u.a.capacity = src->u.a.size;
+		break;
+	case LEPT_OBJECT:
+		dst->u.o.m = NULL;
+		dst->u.o.size = dst->u.o.capacity = src->u.o.size;
+		break;
+	default:
+		dst->u.n = src->u.n;
+		break;
+	}
+}
+
+static void lept_compact_children(lept_compactor* c, lept_value* dst, const lept_value* src);
+
+//深度优先时立即放置子树，广度优先时排到队尾
+static void lept_compact_descend(lept_compactor* c, lept_value* dst, const lept_value* src)
+{
+	if (src->type != LEPT_ARRAY && src->type != LEPT_OBJECT)
+		return;
+	if (c->order == LEPT_ORDER_DEPTH_FIRST)
+		lept_compact_children(c, dst, src);
+	else
+	{
+		if (c->count == c->capacity)
+		{
+			c->capacity = c->capacity == 0 ? 16 : c->capacity * 2;
+			c->queue = (lept_compact_item*)realloc(c->queue, c->capacity * sizeof(lept_compact_item));
+		}
+		c->queue[c->count].dst = dst;
+		c->queue[c->count++].src = src;
+	}
+}
+
+//放置数组/对象的元素/成员数组，随后是各个元素的字符串和成员的key，最后才是子数组/子对象
+static void lept_compact_children(lept_compactor* c, lept_value* dst, const lept_value* src)
+{
+	size_t i;
+	if (src->type == LEPT_ARRAY && src->packed && src->u.pa.size > 0)
+	{
+		dst->u.pa.d = (double*)lept_compact_block(c, src->u.pa.size * sizeof(double));
+		memcpy(dst->u.pa.d, src->u.pa.d, src->u.pa.size * sizeof(double));
+	}
+	else if (src->type == LEPT_ARRAY && src->u.a.size > 0)
+	{
+		dst->u.a.e = (lept_value*)lept_compact_block(c, src->u.a.size * sizeof(lept_value));
+		for (i = 0; i < src->u.a.size; i++)
+			lept_compact_node(c, &dst->u.a.e[i], &src->u.a.e[i]);
+		for (i = 0; i < src->u.a.size; i++)
+			lept_compact_descend(c, &dst->u.a.e[i], &src->u.a.e[i]);
+	}
+	else if (src->type == LEPT_OBJECT && src->u.o.size > 0)
+	{
+		dst->u.o.m = (lept_member*)lept_compact_block(c, src->u.o.size * sizeof(lept_member));
+		for (i = 0; i < src->u.o.size; i++)
+		{
+			lept_member* m = &dst->u.o.m[i];
+			m->k = (char*)lept_compact_alloc(c, src->u.o.m[i].klen + 1, 1);
+			memcpy(m->k, src->u.o.m[i].k, src->u.o.m[i].klen + 1);
+			m->klen = src->u.o.m[i].klen;
+			lept_compact_node(c, &m->v, &src->u.o.m[i].v);
+		}
+		for (i = 0; i < src->u.o.size; i++)
+			lept_compact_descend(c, &dst->u.o.m[i].v, &src->u.o.m[i].v);
+	}
+}
+
+//把整棵树复制到一次分配的内存中再释放原来的树，根的元素/成员数组位于整块内存的开头
+size_t lept_compact(lept_value* v, int order)
+{
+	lept_compactor c;
+	lept_value old;
+	size_t i;
+	assert(v != NULL && (order == LEPT_ORDER_DEPTH_FIRST || order == LEPT_ORDER_BREADTH_FIRST));
+	if (!(v->type == LEPT_ARRAY && v->u.a.size > 0) && !(v->type == LEPT_OBJECT && v->u.o.size > 0))
+		return 0;
+	c.size = lept_compact_size(v);
+	c.base = (char*)malloc(c.size);
+	LEPT_STAT_ADD(malloc_calls, 1);
+	LEPT_STAT_ADD(malloc_bytes, c.size);
+	c.top = 0;
+	c.order = order;
+	c.queue = NULL;
+	c.count = c.capacity = 0;
+	memcpy(&old, v, sizeof(lept_value));
+	lept_compact_node(&c, v, &old);
+	lept_compact_children(&c, v, &old);
+	for (i = 0; i < c.count; i++)		//广度优先，放置过程中队列会继续增长
+		lept_compact_children(&c, c.queue[i].dst, c.queue[i].src);
+	free(c.queue);
+	assert((char*)LEPT_CACHE_OF(LEPT_BLOCK_OF(v)) == c.base);
+	v->compact = LEPT_COMPACT_ROOT;
+	lept_free(&old);		//原来的树，可能本身也是压缩过的
+	return c.size;
+}
+
+//FNV-1a 哈希，用于字符串和key
+static uint64_t lept_hash_bytes(const char* s, size_t len)
+{
+	uint64_t h = 14695981039346656037ULL;
+	size_t i;
+	for (i = 0; i < len; i++)
+	{
+		h ^= (unsigned char)s[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+//混合函数（splitmix64 的终结步骤），使组合后的哈希位分布均匀
+static uint64_t lept_hash_mix(uint64_t h)
+{
+	h ^= h >> 30; h *= 0xBF58476D1CE4E5B9ULL;
+	h ^= h >> 27; h *= 0x94D049BB133111EBULL;
+	h ^= h >> 31;
+	return h;
+}
+
+//lept_diff 为每个数组/对象记录的子树哈希，按先序排列
+typedef struct
+{
+	uint64_t hash;
+	size_t count;		//该子树中数组/对象的个数，包括自身，用于跳到下一个兄弟
+}lept_hash_entry;
+
+typedef struct
+{
+	lept_hash_entry* e;
+	size_t size, capacity;
+}lept_hash_table;
+
+//计算节点的结构哈希：数组按顺序组合，对象把各成员的哈希相加，与成员顺序无关。
+//table不为NULL时按先序记下每个数组/对象的哈希，整棵树只计算一遍
+static uint64_t lept_hash_node(const lept_value* v, lept_hash_table* table)
+{
+	uint64_t h;
+	size_t i, self = 0;
+	lept_value tmp;
+	LEPT_DECODE(v);
+	if (table && (v->type == LEPT_ARRAY || v->type == LEPT_OBJECT))
+	{
+		if (table->size == table->capacity)
+		{
+			table->capacity = table->capacity == 0 ? 64 : table->capacity * 2;
+			table->e = (lept_hash_entry*)realloc(table->e, table->capacity * sizeof(lept_hash_entry));
+		}
+		self = table->size++;
+	}
+	switch (v->type)
+	{
+	case LEPT_NUMBER:
+	{
+		double n = v->u.n == 0.0 ? 0.0 : v->u.n;	//-0 与 0 相等，哈希也要相同
+		memcpy(&h, &n, sizeof(h));
+		h ^= LEPT_NUMBER;
+		break;
+	}
+	case LEPT_STRING:
+		h = lept_hash_bytes(v->u.s.s, v->u.s.len) ^ LEPT_STRING;
+		break;
+	case LEPT_ARRAY:
+		h = LEPT_ARRAY + v->u.a.size;
+		for (i = 0; i < v->u.a.size; i++)
+			h = lept_hash_mix(h) ^ lept_hash_node(lept_array_at(v, i, &tmp), table);
+		break;
+	case LEPT_OBJECT:
+		h = LEPT_OBJECT + v->u.o.size;
+		for (i = 0; i < v->u.o.size; i++)
+			h += lept_hash_mix(lept_hash_bytes(v->u.o.m[i].k, v->u.o.m[i].klen) ^ lept_hash_mix(lept_hash_node(&v->u.o.m[i].v, table)));
+		break;
+	default:
+		h = v->type;
+		break;
+	}
+	h = lept_hash_mix(h);
+	if (table && (v->type == LEPT_ARRAY || v->type == LEPT_OBJECT))
+	{
+		table->e[self].hash = h;
+		table->e[self].count = table->size - self;
+	}
+	return h;
+}
+
+uint64_t lept_hash(const lept_value* v)
+{
+	assert(v != NULL);
+	return lept_hash_node(v, NULL);
+}
+
+//为对象的key建立开放寻址哈希表，存放成员下标+1，0表示空槽；mask返回表长减1
+static size_t* lept_key_table(const lept_value* v, size_t* mask)
+{
+	size_t i, n = v->u.o.size, * slots;
+	*mask = 1;
+	while (*mask < n * 2)
+		*mask <<= 1;
+	slots = (size_t*)calloc((*mask)--, sizeof(size_t));
+	for (i = 0; i < n; i++)
+	{
+		size_t j = (size_t)lept_hash_bytes(v->u.o.m[i].k, v->u.o.m[i].klen) & *mask;
+		while (slots[j] != 0)
+			j = (j + 1) & *mask;
+		slots[j] = i + 1;
+	}
+	return slots;
+}
+
+//在 lept_key_table 建立的表中查找key，返回成员下标
+static size_t lept_key_table_find(const lept_value* v, const size_t* slots, size_t mask, const char* key, size_t klen)
+{
+	size_t j = (size_t)lept_hash_bytes(key, klen) & mask;
+	for (; slots[j] != 0; j = (j + 1) & mask)
+	{
+		const lept_member* m = &v->u.o.m[slots[j] - 1];
+		if (m->klen == klen && memcmp(m->k, key, klen) == 0)
+			return slots[j] - 1;
+	}
+	return LEPT_KEY_NOT_EXIST;
+}
+
+//比较两个成员较多的对象：为rhs的key建立开放寻址哈希表，lhs的每个成员查表比较，O(n)。
+//匹配上的槽位标记为已用（不清零，否则会截断探测序列），重复的key各自匹配一个不同的成员
+static int lept_is_equal_object_hashed(const lept_value* lhs, const lept_value* rhs)
+{
+	size_t i, j, mask, * slots = lept_key_table(rhs, &mask);
+	int ret = 1;
+	for (i = 0; i < lhs->u.o.size && ret; i++)
+	{
+		const lept_member* m = &lhs->u.o.m[i];
+		for (ret = 0, j = (size_t)lept_hash_bytes(m->k, m->klen) & mask; slots[j] != 0; j = (j + 1) & mask)
+		{
+			const lept_member* r;
+			if (slots[j] == LEPT_KEY_NOT_EXIST)		//已匹配
+				continue;
+			r = &rhs->u.o.m[slots[j] - 1];
+			if (r->klen == m->klen && memcmp(r->k, m->k, m->klen) == 0 && lept_is_equal(&m->v, &r->v))
+			{
+				slots[j] = LEPT_KEY_NOT_EXIST;
+				ret = 1;
+				break;
+			}
+		}
+	}
+	free(slots);
+	return ret;
+}
+
+//判断两个节点是否结构相等，类型或长度不同时立即返回。
+//对象按成员的多重集合比较：lhs的每个成员匹配rhs中一个尚未匹配、key和值都相等的成员，
+//有重复key时结果仍然对称，并与 lept_hash（成员哈希之和）一致
+int lept_is_equal(const lept_value* lhs, const lept_value* rhs)
+{
+	size_t i, j;
+	uint64_t used;
+	lept_value ltmp, rtmp;
+	assert(lhs != NULL && rhs != NULL);
+	if (lhs->type != rhs->type)
+		return 0;
+	LEPT_DECODE(lhs);
+	LEPT_DECODE(rhs);
+	switch (lhs->type)
+	{
+	case LEPT_STRING:
+		return lhs->u.s.len == rhs->u.s.len &&
+			memcmp(lhs->u.s.s, rhs->u.s.s, lhs->u.s.len) == 0;
+	case LEPT_NUMBER:
+		return lhs->u.n == rhs->u.n;
+	case LEPT_ARRAY:
+		if (lhs->u.a.size != rhs->u.a.size)
+			return 0;
+		for (i = 0; i < lhs->u.a.size; i++)
+			if (!lept_is_equal(lept_array_at(lhs, i, &ltmp), lept_array_at(rhs, i, &rtmp)))
+				return 0;
+		return 1;
+	case LEPT_OBJECT:
+		if (lhs->u.o.size != rhs->u.o.size)
+			return 0;
+		if (lhs->u.o.size > LEPT_EQUAL_HASH_THRESHOLD)
+			return lept_is_equal_object_hashed(lhs, rhs);
+		for (i = 0, used = 0; i < lhs->u.o.size; i++)	//成员较少时线性查找，used标记rhs中已匹配的成员
+		{
+			const lept_member* m = &lhs->u.o.m[i];
+			for (j = 0; j < rhs->u.o.size; j++)
+				if (!(used >> j & 1) && rhs->u.o.m[j].klen == m->klen && memcmp(rhs->u.o.m[j].k, m->k, m->klen) == 0 &&
+					lept_is_equal(&m->v, &rhs->u.o.m[j].v))
+					break;
+			if (j == rhs->u.o.size)
+				return 0;
+			used |= (uint64_t)1 << j;
+		}
+		return 1;
+	default:
+		return 1;
+	}
+}
+
+//获取节点类型
+lept_type lept_get_type(const lept_value* v)
+{
+	assert(v != NULL);
+	return v->type;
+}
+
+//获取节点的bool类型，TRUE or FALASE
+int lept_get_boolean(const lept_value* v)
+{
+	assert(v != NULL && (v->type == LEPT_TRUE || v->type == LEPT_FALSE));
+	return v->type == LEPT_TRUE;
+}
+
+//给节点类型设置bool类型，TRUE or FALSE
+void lept_set_boolean(lept_value* v, int b)
+{
+	lept_free(v);
+	v->type = b ? LEPT_TRUE : LEPT_FALSE;
+}
+
+//获取节点的数字
+double lept_get_number(const lept_value* v)
+{
+	assert(v != NULL && v->type == LEPT_NUMBER);
+	LEPT_DECODE(v);
+	return v->u.n;
+}
+
+//给节点设置数字和相应类型
+void lept_set_number(lept_value* v, double n)
+{
+	lept_free(v);
+	v->u.n = n;
+	v->type = LEPT_NUMBER;
+}
+
+//获取节点的字符串
+const char* lept_get_string(const lept_value* v)
+{
+	assert(v != NULL && v->type == LEPT_STRING);
+	LEPT_DECODE(v);
+	return v->u.s.s;
+}
+
+//获取节点的字符串的长度
+size_t lept_get_string_length(const lept_value* v)
+{
+	assert(v != NULL && v->type == LEPT_STRING);
+	LEPT_DECODE(v);
+	return v->u.s.len;
+}
+
+//给节点设置字符串
+void lept_set_string(lept_value* v, const char* s, size_t len)
+{
+	assert(v != NULL && (s != NULL || len == 0));
+	lept_free(v);
+	v->u.s.s = (char*)malloc(len + 1);
+	LEPT_STAT_ADD(malloc_calls, 1);
+	LEPT_STAT_ADD(malloc_bytes, len + 1);
+	memcpy(v->u.s.s, s, len);
+	v->u.s.s[len] = '\0';
+	v->u.s.len = len;
+	v->type = LEPT_STRING;
+}
+
+//给节点设置数组，并预留capacity个元素的空间
+void lept_set_array(lept_value* v, size_t capacity)
+{
+	assert(v != NULL);
+	lept_free(v);
+	v->type = LEPT_ARRAY;
+	v->u.a.size = 0;
+	v->u.a.capacity = capacity;
+	v->u.a.e = (lept_value*)lept_block_alloc(capacity * sizeof(lept_value));
+}
+
+//给节点设置size个元素的紧凑数字数组，返回待填写的 double[]
+static double* lept_set_packed(lept_value* v, size_t size)
+{
+	lept_free(v);
+	v->type = LEPT_ARRAY;
+	v->packed = 1;
+	v->u.pa.size = v->u.pa.capacity = size;
+	v->u.pa.d = (double*)lept_block_alloc(size * sizeof(double));
+	return v->u.pa.d;
+}
+
+//把紧凑数字数组展开为普通元素，容量不变。压缩树中的 double[] 属于整块内存，不单独释放
+void lept_unpack_array(lept_value* v)
+{
+	size_t i;
+	lept_value* e;
+	assert(v != NULL && v->type == LEPT_ARRAY);
+	if (!v->packed)
+		return;
+	e = (lept_value*)lept_block_alloc(v->u.pa.capacity * sizeof(lept_value));
+	for (i = 0; i < v->u.pa.size; i++)
+	{
+		lept_init(&e[i]);
+		e[i].type = LEPT_NUMBER;
+		e[i].u.n = v->u.pa.d[i];
+	}
+	if (e != NULL)	//展开不改变输出，缓存转给新的数组
+	{
+		*LEPT_CACHE_OF(e) = *LEPT_CACHE_OF(v->u.pa.d);
+		*LEPT_CACHE_OF(v->u.pa.d) = NULL;
+	}
+	lept_block_free(v->u.pa.d, v->compact != LEPT_COMPACT_INNER);
+	v->u.a.e = e;
+	v->packed = 0;
+	v->compact = LEPT_COMPACT_NONE;
+}
+
+//获取紧凑数字数组的 double[]，不展开；普通数组返回NULL
+const double* lept_get_array_doubles(const lept_value* v, size_t* n)
+{
+	assert(v != NULL && v->type == LEPT_ARRAY);
+	if (!v->packed)
+		return NULL;
+	if (n)
+		*n = v->u.pa.size;
+	return v->u.pa.d;
+}
+
+//获取数组中某个数字元素的值，两种存储都可以读取
+double lept_get_array_number(const lept_value* v, size_t index)
+{
+	lept_value tmp;
+	assert(v != NULL && v->type == LEPT_ARRAY);
+	assert(index < v->u.a.size);
+	return lept_get_number(lept_array_at(v, index, &tmp));
+}
+
+//获取数组的元素个数
+size_t lept_get_array_size(const lept_value* v)
+{
+	assert(v != NULL && v->type == LEPT_ARRAY);
 	return v->u.a.size;
 }
 
-//获取数组中的某个元素
-lept_value* lept_get_array_element(const lept_value* v, size_t index)
+//获取数组的容量
+size_t lept_get_array_capacity(const lept_value* v)
+{
+	assert(v != NULL && v->type == LEPT_ARRAY);
+	return v->u.a.capacity;
+}
+
+//扩充数组的容量，容量只增不减
+void lept_reserve_array(lept_value* v, size_t capacity)
+{
+	assert(v != NULL && v->type == LEPT_ARRAY);
+	if (v->u.a.capacity < capacity)
+	{
+		size_t size = v->packed ? sizeof(double) : sizeof(lept_value);
+		if (v->compact != LEPT_COMPACT_NONE)	//整块内存中的数组不能扩充
+			lept_thaw(v);
+		v->u.a.capacity = capacity;
+		v->u.a.e = (lept_value*)lept_block_realloc(v->u.a.e, capacity * size);	//紧凑数组的 double[] 与 u.a.e 共用同一个指针
+	}
+}
+
+//收缩数组的容量至元素个数，压缩树中的数组不收缩
+void lept_shrink_array(lept_value* v)
+{
+	assert(v != NULL && v->type == LEPT_ARRAY);
+	if (v->u.a.capacity > v->u.a.size && v->compact == LEPT_COMPACT_NONE)
+	{
+		v->u.a.capacity = v->u.a.size;
+		if (v->u.a.size == 0)
+		{
+			lept_block_free(v->u.a.e, 1);
+			v->u.a.e = NULL;
+		}
+		else
+			v->u.a.e = (lept_value*)lept_block_realloc(v->u.a.e, v->u.a.size * (v->packed ? sizeof(double) : sizeof(lept_value)));
+	}
+}
+
+//清空数组的元素，不改变容量
+void lept_clear_array(lept_value* v)
+{
+	assert(v != NULL && v->type == LEPT_ARRAY);
+	lept_erase_array_element(v, 0, v->u.a.size);
+}
+
+//获取数组中的某个元素
+lept_value* lept_get_array_element(const lept_value* v, size_t index)
+{
+	assert(v != NULL && v->type == LEPT_ARRAY);
+	assert(index < v->u.a.size);
+	lept_unpack_array((lept_value*)v);	//返回的元素可以被修改成任意类型，所以紧凑数组必须展开，这不是只读操作
+	return &v->u.a.e[index];
+}
+
+//在数组末尾添加一个元素，容量不足时扩充为原来的两倍，均摊O(1)
+lept_value* lept_pushback_array_element(lept_value* v)
+{
+	assert(v != NULL && v->type == LEPT_ARRAY);
+	lept_invalidate(v);
+	lept_unpack_array(v);
+	if (v->u.a.size == v->u.a.capacity)
+		lept_reserve_array(v, v->u.a.capacity == 0 ? 1 : v->u.a.capacity * 2);
+	lept_init(&v->u.a.e[v->u.a.size]);
+	return &v->u.a.e[v->u.a.size++];
+}
+
+//删除数组末尾的元素
+void lept_popback_array_element(lept_value* v)
+{
+	assert(v != NULL && v->type == LEPT_ARRAY && v->u.a.size > 0);
+	lept_invalidate(v);
+	if (v->packed)
+		v->u.pa.size--;
+	else
+		lept_free(&v->u.a.e[--v->u.a.size]);
+}
+
+//在index处插入一个元素，其后的元素依次后移
+lept_value* lept_insert_array_element(lept_value* v, size_t index)
 {
-	assert(v != NULL && v->type == LEPT_ARRAY);
-	assert(index < v->u.a.size);
+	assert(v != NULL && v->type == LEPT_ARRAY && index <= v->u.a.size);
+	lept_invalidate(v);
+	lept_unpack_array(v);
+	if (v->u.a.size == v->u.a.capacity)
+		lept_reserve_array(v, v->u.a.capacity == 0 ? 1 : v->u.a.capacity * 2);
+	memmove(&v->u.a.e[index + 1], &v->u.a.e[index], (v->u.a.size - index) * sizeof(lept_value));
+	v->u.a.size++;
+	lept_init(&v->u.a.e[index]);
 	return &v->u.a.e[index];
 }
 
+//删除从index开始的count个元素，其后的元素依次前移
+void lept_erase_array_element(lept_value* v, size_t index, size_t count)
+{
+	size_t i;
+	assert(v != NULL && v->type == LEPT_ARRAY && index + count <= v->u.a.size);
+	lept_invalidate(v);
+	if (v->packed)
+		memmove(&v->u.pa.d[index], &v->u.pa.d[index + count], (v->u.pa.size - index - count) * sizeof(double));
+	else
+	{
+		for (i = index; i < index + count; i++)
+			lept_free(&v->u.a.e[i]);
+		memmove(&v->u.a.e[index], &v->u.a.e[index + count], (v->u.a.size - index - count) * sizeof(lept_value));
+	}
+	v->u.a.size -= count;
+}
+
+//给节点设置对象，并预留capacity个成员的空间
+void lept_set_object(lept_value* v, size_t capacity)
+{
+	assert(v != NULL);
+	lept_free(v);
+	v->type = LEPT_OBJECT;
+	v->u.o.size = 0;
+	v->u.o.capacity = capacity;
+	v->u.o.m = (lept_member*)lept_block_alloc(capacity * sizeof(lept_member));
+}
+
 //获取对象成员个数
 size_t lept_get_object_size(const lept_value* v)
 {
@@ -644,6 +3069,58 @@ size_t lept_get_object_size(const lept_value* v)
 	return v->u.o.size;
 }
 
+//获取对象的容量
+size_t lept_get_object_capacity(const lept_value* v)
+{
+	assert(v != NULL && v->type == LEPT_OBJECT);
+	return v->u.o.capacity;
+}
+
+//扩充对象的容量，容量只增不减
+void lept_reserve_object(lept_value* v, size_t capacity)
+{
+	assert(v != NULL && v->type == LEPT_OBJECT);
+	if (v->u.o.capacity < capacity)
+	{
+		if (v->compact != LEPT_COMPACT_NONE)	//整块内存中的成员数组不能扩充
+			lept_thaw(v);
+		v->u.o.capacity = capacity;
+		v->u.o.m = (lept_member*)lept_block_realloc(v->u.o.m, capacity * sizeof(lept_member));
+	}
+}
+
+//收缩对象的容量至成员个数，压缩树中的对象不收缩
+void lept_shrink_object(lept_value* v)
+{
+	assert(v != NULL && v->type == LEPT_OBJECT);
+	if (v->u.o.capacity > v->u.o.size && v->compact == LEPT_COMPACT_NONE)
+	{
+		v->u.o.capacity = v->u.o.size;
+		if (v->u.o.size == 0)
+		{
+			lept_block_free(v->u.o.m, 1);
+			v->u.o.m = NULL;
+		}
+		else
+			v->u.o.m = (lept_member*)lept_block_realloc(v->u.o.m, v->u.o.size * sizeof(lept_member));
+	}
+}
+
+//清空对象的成员，不改变容量
+void lept_clear_object(lept_value* v)
+{
+	size_t i;
+	assert(v != NULL && v->type == LEPT_OBJECT);
+	lept_invalidate(v);
+	for (i = 0; i < v->u.o.size; i++)
+	{
+		if (v->compact == LEPT_COMPACT_NONE)
+			free(v->u.o.m[i].k);
+		lept_free(&v->u.o.m[i].v);
+	}
+	v->u.o.size = 0;
+}
+
 //获取对象某个成员的key值
 const char* lept_get_object_key(const lept_value* v, size_t index)
 {
@@ -667,3 +3144,700 @@ lept_value* lept_get_object_value(const lept_value* v, size_t index)
 	assert(index < v->u.o.size);
 	return &v->u.o.m[index].v;
 }
+
+//查找key对应的成员下标，线性查找
+size_t lept_find_object_index(const lept_value* v, const char* key, size_t klen)
+{
+	size_t i;
+	assert(v != NULL && v->type == LEPT_OBJECT && key != NULL);
+	for (i = 0; i < v->u.o.size; i++)
+		if (v->u.o.m[i].klen == klen && memcmp(v->u.o.m[i].k, key, klen) == 0)
+			return i;
+	return LEPT_KEY_NOT_EXIST;
+}
+
+//查找key对应的成员value，不存在时返回NULL
+lept_value* lept_find_object_value(lept_value* v, const char* key, size_t klen)
+{
+	size_t index = lept_find_object_index(v, key, klen);
+	return index != LEPT_KEY_NOT_EXIST ? &v->u.o.m[index].v : NULL;
+}
+
+//返回key对应的成员value以便修改并丢弃缓存，key不存在时在末尾新增一个值为null的成员
+lept_value* lept_set_object_value(lept_value* v, const char* key, size_t klen)
+{
+	size_t index;
+	lept_member* m;
+	assert(v != NULL && v->type == LEPT_OBJECT && key != NULL);
+	lept_invalidate(v);	//返回的成员可能被修改
+	if ((index = lept_find_object_index(v, key, klen)) != LEPT_KEY_NOT_EXIST)
+		return &v->u.o.m[index].v;
+	if (v->compact != LEPT_COMPACT_NONE)	//新的key单独分配，压缩对象的key不会被逐个释放
+		lept_thaw(v);
+	if (v->u.o.size == v->u.o.capacity)	//容量不足时扩充为原来的两倍，均摊O(1)
+		lept_reserve_object(v, v->u.o.capacity == 0 ? 1 : v->u.o.capacity * 2);
+	m = &v->u.o.m[v->u.o.size++];
+	memcpy(m->k = (char*)malloc(klen + 1), key, klen);
+	m->k[klen] = '\0';
+	m->klen = klen;
+	lept_init(&m->v);
+	return &m->v;
+}
+
+//删除对象中的某个成员，其后的成员依次前移
+void lept_remove_object_value(lept_value* v, size_t index)
+{
+	assert(v != NULL && v->type == LEPT_OBJECT && index < v->u.o.size);
+	lept_invalidate(v);
+	if (v->compact == LEPT_COMPACT_NONE)
+		free(v->u.o.m[index].k);
+	lept_free(&v->u.o.m[index].v);
+	memmove(&v->u.o.m[index], &v->u.o.m[index + 1], (v->u.o.size - index - 1) * sizeof(lept_member));
+	v->u.o.size--;
+}
+
+//解码JSON Pointer中p处的一段token（p指向'/'）到buf，~0 还原为 '~'，~1 还原为 '/'。
+//返回下一段的开头，token中出现非法的 '~' 时返回NULL
+static const char* lept_pointer_token(const char* p, const char* end, char* buf, size_t* len)
+{
+	size_t n = 0;
+	assert(p < end && *p == '/');
+	for (p++; p < end && *p != '/'; p++)
+	{
+		if (*p == '~')
+		{
+			if (p + 1 == end || (p[1] != '0' && p[1] != '1'))
+				return NULL;
+			buf[n++] = *++p == '0' ? '~' : '/';
+		}
+		else
+			buf[n++] = *p;
+	}
+	*len = n;
+	return p;
+}
+
+//把token解析成数组下标：只允许十进制数字且不能有前导0，失败时返回 LEPT_KEY_NOT_EXIST
+static size_t lept_pointer_index(const char* token, size_t len)
+{
+	size_t i, index = 0;
+	if (len == 0 || len > 18 || (len > 1 && token[0] == '0'))
+		return LEPT_KEY_NOT_EXIST;
+	for (i = 0; i < len; i++)
+	{
+		if (!ISDIGIT(token[i]))
+			return LEPT_KEY_NOT_EXIST;
+		index = index * 10 + (token[i] - '0');
+	}
+	return index;
+}
+
+//在容器v中按已解码的token查找子节点，不存在时返回NULL
+static lept_value* lept_pointer_child(lept_value* v, const char* token, size_t len)
+{
+	size_t index;
+	if (v->type == LEPT_OBJECT)
+		return lept_find_object_value(v, token, len);
+	if (v->type == LEPT_ARRAY && (index = lept_pointer_index(token, len)) < v->u.a.size)
+		return lept_get_array_element(v, index);
+	return NULL;
+}
+
+//按JSON Pointer（RFC 6901）查找节点，touch不为0时丢弃路径上所有数组/对象的缓存
+static lept_value* lept_pointer_walk(lept_value* v, const char* pointer, size_t len, int touch)
+{
+	const char* p = pointer;
+	const char* end = pointer + len;
+	lept_value* cur = v;
+	char* buf;
+	size_t n;
+	assert(v != NULL && (pointer != NULL || len == 0));
+	if (touch)
+		lept_invalidate(cur);
+	if (len == 0)
+		return cur;
+	if (*p != '/')
+		return NULL;
+	buf = (char*)malloc(len);
+	while (cur != NULL && p < end)
+	{
+		if ((p = lept_pointer_token(p, end, buf, &n)) == NULL)
+			cur = NULL;
+		else if ((cur = lept_pointer_child(cur, buf, n)) != NULL && touch)
+			lept_invalidate(cur);
+	}
+	free(buf);
+	return cur;
+}
+
+//按JSON Pointer（RFC 6901）查找节点，pointer为""时返回v本身，找不到时返回NULL
+lept_value* lept_find_pointer(const lept_value* v, const char* pointer, size_t len)
+{
+	return lept_pointer_walk((lept_value*)v, pointer, len, 0);
+}
+
+//按JSON Pointer查找将要修改的节点，并丢弃它和它所有祖先的缓存。找不到时返回NULL，已丢弃的缓存不会恢复
+lept_value* lept_touch_pointer(lept_value* v, const char* pointer, size_t len)
+{
+	return lept_pointer_walk(v, pointer, len, 1);
+}
+
+//合并补丁（RFC 7386）：patch为对象时逐个成员合并，值为null的成员删除，其余递归合并；
+//否则用patch的副本替换target。未涉及的子树原地保留，既不复制也不重新分配
+void lept_apply_merge_patch(lept_value* target, const lept_value* patch)
+{
+	size_t i, index;
+	assert(target != NULL && patch != NULL && target != patch);
+	if (patch->type != LEPT_OBJECT)
+	{
+		lept_copy(target, patch);
+		return;
+	}
+	if (target->type != LEPT_OBJECT)
+		lept_set_object(target, patch->u.o.size);
+	for (i = 0; i < patch->u.o.size; i++)
+	{
+		const lept_member* m = &patch->u.o.m[i];
+		if (m->v.type == LEPT_NULL)
+		{
+			if ((index = lept_find_object_index(target, m->k, m->klen)) != LEPT_KEY_NOT_EXIST)
+				lept_remove_object_value(target, index);
+		}
+		else
+			lept_apply_merge_patch(lept_set_object_value(target, m->k, m->klen), &m->v);
+	}
+}
+
+//JSON Patch中的一个路径：整个路径、最后一段token，以及最后一段token所在的父节点
+typedef struct
+{
+	const char* s;
+	size_t len;
+	char* token;		//已解码的最后一段token
+	size_t tlen;
+	lept_value* parent;	//路径为""时为NULL
+}lept_patch_path;
+
+//解析op中名为name的路径，找到父节点。路径中间的节点必须存在。touch不为0时丢弃路径上的缓存
+static int lept_patch_resolve(lept_value* target, const lept_value* op, const char* name, lept_patch_path* path, int touch)
+{
+	const lept_value* s = lept_find_object_value((lept_value*)op, name, strlen(name));
+	const char* p, * end, * next;
+	lept_value* cur = target;
+	path->token = NULL;
+	path->tlen = 0;
+	path->parent = NULL;
+	if (s == NULL || s->type != LEPT_STRING)
+		return LEPT_PATCH_INVALID_OPERATION;
+	path->s = p = lept_get_string(s);
+	path->len = s->u.s.len;
+	end = p + path->len;
+	if (touch)
+		lept_invalidate(target);
+	if (path->len == 0)
+		return LEPT_PATCH_OK;
+	if (*p != '/')
+		return LEPT_PATCH_INVALID_OPERATION;
+	path->token = (char*)malloc(path->len);
+	for (;;)
+	{
+		if ((next = lept_pointer_token(p, end, path->token, &path->tlen)) == NULL)
+			return LEPT_PATCH_INVALID_OPERATION;
+		if (next == end)	//最后一段
+		{
+			path->parent = cur;
+			return LEPT_PATCH_OK;
+		}
+		if ((cur = lept_pointer_child(cur, path->token, path->tlen)) == NULL)
+			return LEPT_PATCH_PATH_NOT_FOUND;
+		if (touch)
+			lept_invalidate(cur);
+		p = next;
+	}
+}
+
+//查找路径指向的节点，不存在时返回NULL
+static lept_value* lept_patch_get(lept_value* target, const lept_patch_path* path)
+{
+	if (path->parent == NULL)
+		return target;
+	return lept_pointer_child(path->parent, path->token, path->tlen);
+}
+
+//add：把value移动到路径处。对象中已有的成员被替换，数组中插入到下标处（"-"表示末尾）
+static int lept_patch_add(lept_value* target, const lept_patch_path* path, lept_value* value)
+{
+	size_t index;
+	lept_value* parent = path->parent;
+	if (parent == NULL)
+		lept_move(target, value);
+	else if (parent->type == LEPT_OBJECT)
+		lept_move(lept_set_object_value(parent, path->token, path->tlen), value);
+	else if (parent->type == LEPT_ARRAY)
+	{
+		if (path->tlen == 1 && path->token[0] == '-')
+			index = parent->u.a.size;
+		else if ((index = lept_pointer_index(path->token, path->tlen)) == LEPT_KEY_NOT_EXIST || index > parent->u.a.size)
+			return LEPT_PATCH_PATH_NOT_FOUND;
+		lept_move(lept_insert_array_element(parent, index), value);
+	}
+	else
+		return LEPT_PATCH_PATH_NOT_FOUND;
+	return LEPT_PATCH_OK;
+}
+
+//remove：删除路径处的节点，out不为NULL时把被删除的节点移动到out，不复制
+static int lept_patch_remove(lept_value* target, const lept_patch_path* path, lept_value* out)
+{
+	size_t index;
+	lept_value* parent = path->parent;
+	if (parent == NULL)		//不能删除整个文档
+		return LEPT_PATCH_INVALID_OPERATION;
+	if (parent->type == LEPT_OBJECT)
+	{
+		if ((index = lept_find_object_index(parent, path->token, path->tlen)) == LEPT_KEY_NOT_EXIST)
+			return LEPT_PATCH_PATH_NOT_FOUND;
+		if (out)
+			lept_move(out, &parent->u.o.m[index].v);
+		lept_remove_object_value(parent, index);
+	}
+	else if (parent->type == LEPT_ARRAY)
+	{
+		if ((index = lept_pointer_index(path->token, path->tlen)) == LEPT_KEY_NOT_EXIST || index >= parent->u.a.size)
+			return LEPT_PATCH_PATH_NOT_FOUND;
+		if (out)
+			lept_move(out, lept_get_array_element(parent, index));
+		lept_erase_array_element(parent, index, 1);
+	}
+	else
+		return LEPT_PATCH_PATH_NOT_FOUND;
+	(void)target;
+	return LEPT_PATCH_OK;
+}
+
+//判断op字段是否为name
+static int lept_patch_op_is(const lept_value* op, const char* name)
+{
+	size_t len = strlen(name);
+	LEPT_DECODE(op);
+	return op->u.s.len == len && memcmp(op->u.s.s, name, len) == 0;
+}
+
+//执行一个JSON Patch操作
+static int lept_patch_apply_op(lept_value* target, const lept_value* op)
+{
+	lept_patch_path path, from;
+	const lept_value* name, * value;
+	lept_value temp, * v;
+	int ret;
+	if (op->type != LEPT_OBJECT ||
+		(name = lept_find_object_value((lept_value*)op, "op", 2)) == NULL || name->type != LEPT_STRING)
+		return LEPT_PATCH_INVALID_OPERATION;
+	value = lept_find_object_value((lept_value*)op, "value", 5);
+	from.token = NULL;
+	lept_init(&temp);
+	if ((ret = lept_patch_resolve(target, op, "path", &path, !lept_patch_op_is(name, "test"))) != LEPT_PATCH_OK)
+		;
+	else if (lept_patch_op_is(name, "add"))
+	{
+		if (value == NULL)
+			ret = LEPT_PATCH_INVALID_OPERATION;
+		else
+		{
+			lept_copy(&temp, value);
+			ret = lept_patch_add(target, &path, &temp);
+		}
+	}
+	else if (lept_patch_op_is(name, "remove"))
+		ret = lept_patch_remove(target, &path, NULL);
+	else if (lept_patch_op_is(name, "replace"))
+	{
+		if (value == NULL)
+			ret = LEPT_PATCH_INVALID_OPERATION;
+		else if ((v = lept_patch_get(target, &path)) == NULL)
+			ret = LEPT_PATCH_PATH_NOT_FOUND;
+		else
+			lept_copy(v, value);
+	}
+	else if (lept_patch_op_is(name, "move") || lept_patch_op_is(name, "copy"))
+	{
+		int move = lept_patch_op_is(name, "move");
+		if ((ret = lept_patch_resolve(target, op, "from", &from, move)) == LEPT_PATCH_OK)
+		{
+			if ((v = lept_patch_get(target, &from)) == NULL)
+				ret = LEPT_PATCH_PATH_NOT_FOUND;
+			else if (move && path.len > from.len && memcmp(path.s, from.s, from.len) == 0 && path.s[from.len] == '/')
+				ret = LEPT_PATCH_INVALID_OPERATION;		//不能移动到自己的子节点中
+			else if (move)
+			{
+				//先移出再插入，整棵子树只转移所有权。两次解析路径，因为删除会改变数组下标
+				if ((ret = lept_patch_remove(target, &from, &temp)) == LEPT_PATCH_OK)
+				{
+					free(path.token);
+					if ((ret = lept_patch_resolve(target, op, "path", &path, 1)) == LEPT_PATCH_OK)
+						ret = lept_patch_add(target, &path, &temp);
+				}
+			}
+			else
+			{
+				lept_copy(&temp, v);	//先复制到临时节点，插入数组时源节点可能被移动
+				ret = lept_patch_add(target, &path, &temp);
+			}
+		}
+	}
+	else if (lept_patch_op_is(name, "test"))
+	{
+		if (value == NULL)
+			ret = LEPT_PATCH_INVALID_OPERATION;
+		else if ((v = lept_patch_get(target, &path)) == NULL)
+			ret = LEPT_PATCH_PATH_NOT_FOUND;
+		else if (!lept_is_equal(v, value))
+			ret = LEPT_PATCH_TEST_FAILED;
+	}
+	else
+		ret = LEPT_PATCH_INVALID_OPERATION;
+	lept_free(&temp);
+	free(path.token);
+	free(from.token);
+	return ret;
+}
+
+//JSON Patch（RFC 6902）：ops为操作数组，依次原地修改target。只有被操作的路径会修改，其余子树不复制也不重新分配。
+//某个操作失败时返回错误码并停止，之前的操作不会撤销；需要原子性时先用lept_copy备份
+int lept_apply_patch(lept_value* target, const lept_value* ops)
+{
+	size_t i;
+	int ret;
+	lept_value tmp;
+	assert(target != NULL && ops != NULL && target != ops);
+	if (ops->type != LEPT_ARRAY)
+		return LEPT_PATCH_INVALID_OPERATION;
+	for (i = 0; i < ops->u.a.size; i++)
+		if ((ret = lept_patch_apply_op(target, lept_array_at(ops, i, &tmp))) != LEPT_PATCH_OK)
+			return ret;
+	return LEPT_PATCH_OK;
+}
+
+//lept_diff 的状态：两棵树的子树哈希表，当前节点的JSON Pointer，生成的操作数组
+typedef struct
+{
+	lept_hash_table ta, tb;
+	char* path;
+	size_t len, capacity;
+	lept_value* patch;
+}lept_diff_context;
+
+static void lept_diff_put(lept_diff_context* c, const char* s, size_t len)
+{
+	if (c->len + len > c->capacity)
+	{
+		while (c->len + len > c->capacity)
+			c->capacity += c->capacity >> 1;
+		c->path = (char*)realloc(c->path, c->capacity);
+	}
+	memcpy(c->path + c->len, s, len);
+	c->len += len;
+}
+
+//在路径末尾加上一段key，'~' 写成 ~0，'/' 写成 ~1
+static void lept_diff_push_key(lept_diff_context* c, const char* key, size_t klen)
+{
+	size_t i;
+	lept_diff_put(c, "/", 1);
+	for (i = 0; i < klen; i++)
+		if (key[i] == '~')
+			lept_diff_put(c, "~0", 2);
+		else if (key[i] == '/')
+			lept_diff_put(c, "~1", 2);
+		else
+			lept_diff_put(c, &key[i], 1);
+}
+
+static void lept_diff_push_index(lept_diff_context* c, size_t index)
+{
+	char buf[32];
+	lept_diff_put(c, buf, (size_t)sprintf(buf, "/%lu", (unsigned long)index));
+}
+
+//生成一个操作，路径为当前路径，value不为NULL时复制到 "value"
+static void lept_diff_emit(lept_diff_context* c, const char* op, const lept_value* value)
+{
+	lept_value* o = lept_pushback_array_element(c->patch);
+	lept_set_object(o, value ? 3 : 2);
+	lept_set_string(lept_set_object_value(o, "op", 2), op, strlen(op));
+	lept_set_string(lept_set_object_value(o, "path", 4), c->path, c->len);
+	if (value)
+		lept_copy(lept_set_object_value(o, "value", 5), value);
+}
+
+//求出容器各个子节点在哈希表中的下标，标量不在表中，对应位置不使用
+static size_t* lept_diff_children(const lept_hash_table* t, const lept_value* v, size_t index)
+{
+	size_t i, n = v->type == LEPT_ARRAY ? v->u.a.size : v->u.o.size, next = index + 1, * children;
+	children = (size_t*)malloc((n > 0 ? n : 1) * sizeof(size_t));
+	for (i = 0; i < n; i++)
+	{
+		lept_value tmp;
+		const lept_value* e = v->type == LEPT_ARRAY ? lept_array_at(v, i, &tmp) : &v->u.o.m[i].v;
+		children[i] = next;
+		if (e->type == LEPT_ARRAY || e->type == LEPT_OBJECT)
+			next += t->e[next].count;
+	}
+	return children;
+}
+
+//两个节点是否相同：数组/对象先比较子树哈希，哈希相同再逐一比较，排除碰撞
+static int lept_diff_same(const lept_diff_context* c, const lept_value* a, size_t ia, const lept_value* b, size_t ib)
+{
+	if (a->type != b->type)
+		return 0;
+	if ((a->type == LEPT_ARRAY || a->type == LEPT_OBJECT) && c->ta.e[ia].hash != c->tb.e[ib].hash)
+		return 0;
+	return lept_is_equal(a, b);
+}
+
+static void lept_diff_value(lept_diff_context* c, const lept_value* a, size_t ia, const lept_value* b, size_t ib);
+
+//数组：去掉两端相同的元素，中间部分逐个比较，多出的元素在末尾增加或删除。中间插入/删除一段时只产生这一段的操作
+static void lept_diff_array(lept_diff_context* c, const lept_value* a, size_t ia, const lept_value* b, size_t ib)
+{
+	size_t n = a->u.a.size, m = b->u.a.size, head = 0, tail = 0, common, i, len = c->len;
+	size_t* ca = lept_diff_children(&c->ta, a, ia), * cb = lept_diff_children(&c->tb, b, ib);
+	lept_value atmp, btmp;	//紧凑数组的元素
+	while (head < n && head < m &&
+		lept_diff_same(c, lept_array_at(a, head, &atmp), ca[head], lept_array_at(b, head, &btmp), cb[head]))
+		head++;
+	while (tail < n - head && tail < m - head &&
+		lept_diff_same(c, lept_array_at(a, n - 1 - tail, &atmp), ca[n - 1 - tail], lept_array_at(b, m - 1 - tail, &btmp), cb[m - 1 - tail]))
+		tail++;
+	n -= head + tail;
+	m -= head + tail;
+	common = n < m ? n : m;
+	for (i = head; i < head + common; i++)
+	{
+		lept_diff_push_index(c, i);
+		lept_diff_value(c, lept_array_at(a, i, &atmp), ca[i], lept_array_at(b, i, &btmp), cb[i]);
+		c->len = len;
+	}
+	for (; i < head + m; i++)
+	{
+		lept_diff_push_index(c, i);
+		lept_diff_emit(c, "add", lept_array_at(b, i, &btmp));
+		c->len = len;
+	}
+	for (i = head + n; i > head + common; i--)	//从后往前删除，前面的下标不变
+	{
+		lept_diff_push_index(c, i - 1);
+		lept_diff_emit(c, "remove", NULL);
+		c->len = len;
+	}
+	free(ca);
+	free(cb);
+}
+
+//对象：按key匹配成员，与顺序无关。成员较多时为b的key建立哈希表，O(n)
+static void lept_diff_object(lept_diff_context* c, const lept_value* a, size_t ia, const lept_value* b, size_t ib)
+{
+	size_t i, index, mask = 0, len = c->len, * slots = NULL;
+	size_t* ca = lept_diff_children(&c->ta, a, ia), * cb = lept_diff_children(&c->tb, b, ib);
+	char* matched = (char*)calloc(b->u.o.size > 0 ? b->u.o.size : 1, 1);
+	if (b->u.o.size > LEPT_EQUAL_HASH_THRESHOLD)
+		slots = lept_key_table(b, &mask);
+	for (i = 0; i < a->u.o.size; i++)
+	{
+		const lept_member* m = &a->u.o.m[i];
+		index = slots ? lept_key_table_find(b, slots, mask, m->k, m->klen) : lept_find_object_index(b, m->k, m->klen);
+		lept_diff_push_key(c, m->k, m->klen);
+		if (index == LEPT_KEY_NOT_EXIST)
+			lept_diff_emit(c, "remove", NULL);
+		else
+		{
+			matched[index] = 1;
+			lept_diff_value(c, &m->v, ca[i], &b->u.o.m[index].v, cb[index]);
+		}
+		c->len = len;
+	}
+	for (i = 0; i < b->u.o.size; i++)
+		if (!matched[i])
+		{
+			lept_diff_push_key(c, b->u.o.m[i].k, b->u.o.m[i].klen);
+			lept_diff_emit(c, "add", &b->u.o.m[i].v);
+			c->len = len;
+		}
+	free(slots);
+	free(matched);
+	free(ca);
+	free(cb);
+}
+
+//相同的子树整个跳过；类型不同或标量不同时整体替换
+static void lept_diff_value(lept_diff_context* c, const lept_value* a, size_t ia, const lept_value* b, size_t ib)
+{
+	if (lept_diff_same(c, a, ia, b, ib))
+		return;
+	if (a->type == LEPT_ARRAY && b->type == LEPT_ARRAY)
+		lept_diff_array(c, a, ia, b, ib);
+	else if (a->type == LEPT_OBJECT && b->type == LEPT_OBJECT)
+		lept_diff_object(c, a, ia, b, ib);
+	else
+		lept_diff_emit(c, "replace", b);
+}
+
+void lept_diff(const lept_value* a, const lept_value* b, lept_value* patch)
+{
+	lept_diff_context c;
+	assert(a != NULL && b != NULL && patch != NULL && patch != a && patch != b);
+	memset(&c, 0, sizeof(c));
+	lept_hash_node(a, &c.ta);
+	lept_hash_node(b, &c.tb);
+	c.path = (char*)malloc(c.capacity = 64);
+	c.patch = patch;
+	lept_set_array(patch, 0);
+	lept_diff_value(&c, a, 0, b, 0);
+	free(c.path);
+	free(c.ta.e);
+	free(c.tb.e);
+}
+
+//只读文档，root在冻结后不再修改，refs为引用计数
+struct lept_doc
+{
+	lept_value root;
+	long refs;
+};
+
+//冻结节点树，v的所有权转移给文档
+lept_doc* lept_doc_create(lept_value* v)
+{
+	lept_doc* doc;
+	assert(v != NULL);
+	doc = (lept_doc*)malloc(sizeof(lept_doc));
+	lept_init(&doc->root);
+	lept_move(&doc->root, v);
+	lept_materialize(&doc->root);	//冻结后会被多个线程同时读取，不能再延迟解码
+	doc->refs = 1;
+	return doc;
+}
+
+//解析JSON并冻结，出错时*doc为NULL
+int lept_doc_parse(lept_doc** doc, const char* json)
+{
+	lept_value v;
+	int ret;
+	assert(doc != NULL);
+	lept_init(&v);
+	*doc = NULL;
+	if ((ret = lept_parse(&v, json)) == LEPT_PARSE_OK)
+		*doc = lept_doc_create(&v);
+	return ret;
+}
+
+//增加引用计数。调用者必须已经持有doc的一个引用
+lept_doc* lept_doc_ref(lept_doc* doc)
+{
+	assert(doc != NULL);
+	lept_atomic_inc(&doc->refs);
+	return doc;
+}
+
+//减少引用计数，最后一个引用释放时回收整棵树
+void lept_doc_unref(lept_doc* doc)
+{
+	if (doc != NULL && lept_atomic_dec(&doc->refs) == 0)
+	{
+		lept_free(&doc->root);
+		free(doc);
+	}
+}
+
+//文档的根节点，只能读取
+const lept_value* lept_doc_root(const lept_doc* doc)
+{
+	assert(doc != NULL);
+	return &doc->root;
+}
+
+//写时复制：只有调用者持有引用时直接修改原树，否则复制一份新文档并释放对旧文档的引用。
+//返回的根节点在再次冻结（共享）之前可以随意修改
+lept_value* lept_doc_edit(lept_doc** doc)
+{
+	lept_doc* copy;
+	assert(doc != NULL && *doc != NULL);
+	if (lept_atomic_load(&(*doc)->refs) == 1)
+		return &(*doc)->root;
+	copy = (lept_doc*)malloc(sizeof(lept_doc));
+	lept_init(&copy->root);
+	lept_copy(&copy->root, &(*doc)->root);
+	copy->refs = 1;
+	lept_doc_unref(*doc);
+	*doc = copy;
+	return &copy->root;
+}
+
+//取得当前文档的引用。读取指针和增加引用计数必须在锁内完成，否则文档可能在两者之间被替换并释放
+lept_doc* lept_doc_slot_load(lept_doc_slot* slot)
+{
+	lept_doc* doc;
+	assert(slot != NULL);
+	while (lept_atomic_lock(&slot->lock))
+		;
+	if ((doc = slot->doc) != NULL)
+		lept_doc_ref(doc);
+	lept_atomic_unlock(&slot->lock);
+	return doc;
+}
+
+//原子替换文档。旧文档在锁外释放引用，仍在读取它的线程不受影响，最后一个读者释放时回收
+void lept_doc_slot_store(lept_doc_slot* slot, lept_doc* doc)
+{
+	lept_doc* old;
+	assert(slot != NULL);
+	while (lept_atomic_lock(&slot->lock))
+		;
+	old = slot->doc;
+	slot->doc = doc;
+	lept_atomic_unlock(&slot->lock);
+	lept_doc_unref(old);
+}
+
+//当前线程的统计快照，未开启 LEPT_ENABLE_STATS 时为全0
+void lept_stats_snapshot(lept_stats* out)
+{
+	assert(out != NULL);
+#ifdef LEPT_ENABLE_STATS
+	if (lept_stats_phase >= 0)		//正在某个阶段中（如在回调中取快照），先结算已经过的时间
+		lept_stats_enter(lept_stats_phase);
+	memcpy(out, &lept_stats_tls, sizeof(lept_stats));
+#else
+	memset(out, 0, sizeof(lept_stats));
+#endif
+}
+
+//清零当前线程的统计
+void lept_stats_reset(void)
+{
+#ifdef LEPT_ENABLE_STATS
+	memset(&lept_stats_tls, 0, sizeof(lept_stats));
+#endif
+}
+
+//汇总多个线程的统计
+void lept_stats_merge(lept_stats* dst, const lept_stats* src)
+{
+	size_t i;
+	assert(dst != NULL && src != NULL);
+	dst->bytes_parsed += src->bytes_parsed;
+	for (i = 0; i <= LEPT_OBJECT; i++)
+		dst->nodes[i] += src->nodes[i];
+	dst->malloc_calls += src->malloc_calls;
+	dst->malloc_bytes += src->malloc_bytes;
+	dst->realloc_calls += src->realloc_calls;
+	dst->realloc_bytes += src->realloc_bytes;
+	if (dst->stack_high_water < src->stack_high_water)
+		dst->stack_high_water = src->stack_high_water;
+	dst->stack_regrows += src->stack_regrows;
+	dst->strings_escaped += src->strings_escaped;
+	dst->strings_plain += src->strings_plain;
+	for (i = 0; i < LEPT_PHASE_COUNT; i++)
+		dst->phase_ns[i] += src->phase_ns[i];
+}
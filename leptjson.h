@@ -1,7 +1,12 @@
-#ifndef LEFPJSON_H_
+#ifndef LEPTJSON_H_
 #define LEPTJSON_H_
 
 #include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 typedef enum 
 {
@@ -23,12 +28,40 @@ struct lept_value
 	union
 	{
 		//C ԵСӦʹ size_t 
-		struct { lept_member* m; size_t size; } o;	// object: members, member count 
-		struct { lept_value* e; size_t size; }a;	// array:  elements, element count 
-		struct { char* s; size_t len; }s;			// string: null-terminated string, string length 
+		struct { lept_member* m; size_t size, capacity; } o;	// object: members, member count, capacity 
+		struct { lept_value* e; size_t size, capacity; }a;		// array:  elements, element count, capacity 
+		struct { double* d; size_t size, capacity; }pa;		// array parsed with LEPT_FLAG_PACK_NUMBERS: packed numbers, same layout as a 
+		struct { char* s; size_t len; }s;	// string: null-terminated string, string length (quoted source text while LEPT_LAZY_PENDING) 
+		struct { double n; const char* raw; size_t rawlen; }nr;			// number parsed with LEPT_FLAG_LAZY: value, source text 
 		double n;									// number 
 	}u;
 	lept_type type;
+	unsigned char lazy;		//LEPT_LAZY_*/ַǷԴı
+	unsigned char compact;	//LEPT_COMPACT_*ַ/Ԫ/ԱǷλ lept_compact ڴ
+	unsigned char packed;	//ԪǷ double[] 洢 u.pa УLEPT_FLAG_PACK_NUMBERS
+};
+
+//LEPT_FLAG_LAZY /ַ״̬
+enum
+{
+	LEPT_LAZY_NONE = 0,			//ͨڵ
+	LEPT_LAZY_PENDING,			//ֻ¼Դıu.n / u.s.s δ룬ַ u.s.s / u.s.len ָŵԴı
+	LEPT_LAZY_DECODED			//ѽ룬ԴıȻЧJSONʱԭַԴıλñڽ֮ǰͬһη
+};
+
+//ڵ洢Ĺ lept_compact 
+enum
+{
+	LEPT_COMPACT_NONE = 0,		//ͨڵ㣬ַ/Ԫ/ԱԵ
+	LEPT_COMPACT_ROOT,			//ѹĸԪ/ԱλڴĿͷͷͷ
+	LEPT_COMPACT_INNER			//ѹڲڵ㣺洢ڸڴ棬lept_free ͷ
+};
+
+//lept_compact ˳
+enum
+{
+	LEPT_ORDER_DEPTH_FIRST = 0,	//ȣÿ/ţʺñл
+	LEPT_ORDER_BREADTH_FIRST	//ȣͬһĽڵڣʺֻ漸Ĳ
 };
 
 //ObjectĳԱԱˡֵ͡Լĳ
@@ -54,18 +87,238 @@ enum
 	LEPT_PARSE_MISS_KEY,						//ĳԱȱkeyֵ
 	LEPT_PARSE_MISS_COLON,						//Աȱðţ
 	LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET,		//ȱٶţߴ}
+	LEPT_PARSE_INVALID_BINARY,					//ݲǺϷMessagePackݱض
+	LEPT_PARSE_NESTING_TOO_DEEP,				//lept_validatelept_decode_binary ʱ/Ƕ׳ LEPT_VALIDATE_MAX_DEPTH 
+	LEPT_PARSE_INVALID_UTF8,					// LEPT_FLAG_VALIDATE_UTF8 ʱַгֲϷUTF-8ֽ
+};
+
+//ҶԱʱkeyڷص±
+#define LEPT_KEY_NOT_EXIST ((size_t)-1)
+
+//lept_apply_patch ķֵ
+enum
+{
+	LEPT_PATCH_OK = 0,							//вִгɹ
+	LEPT_PATCH_INVALID_OPERATION,				//ʽ󣬻ϷɾĵƶԼӽڵУ
+	LEPT_PATCH_PATH_NOT_FOUND,					//·ָĽڵ㲻
+	LEPT_PATCH_TEST_FAILED,						//test Ƚϵֵ
+};
+
+//lept_parse_ex Ľѡɰλ
+enum
+{
+	LEPT_FLAG_VALIDATE_UTF8 = 1 << 0,			//ϸУַUTF-8룬ܾ롢ͳU+10FFFF
+	LEPT_FLAG_FAST_SKIP = 1 << 1,				//lept_parse_select δѡеĲʱַֻŵĽṹУ
+	LEPT_FLAG_LAZY = 1 << 2,					///ַֻУ鲢¼Դı״ζȡʱŽ룬lept_stringify ԭԴı
+												//jsonڽڵ lept_materialize ֮ǰһֱЧδܱ߳ͬʱȡ
+	LEPT_FLAG_LARGE_STRINGS = 1 << 3,			//ֵַԭĲ LEPT_LARGE_STRING_SIZE ʱȿҵβţ
+												//ԭĳһηڵֱַӽȥջҲٸ
+	LEPT_FLAG_PACK_NUMBERS = 1 << 4,			//ԪȫֵΪ double[]ÿԪ8ֽڶһ lept_value
+												//ȡԪָ롢ԪʱԶչΪͨ飬ܱ߳ͬʱȡ
 };
 
 //ʼ
-#define lept_init(v) do{(v)->type = LEPT_NULL;} while(0)
+#define lept_init(v) do{(v)->type = LEPT_NULL; (v)->lazy = LEPT_LAZY_NONE; (v)->compact = LEPT_COMPACT_NONE; (v)->packed = 0;} while(0)
 
 //JSONJSONıһCַսβַnull-terminated string
 int lept_parse(lept_value* v, const char* json);
-// JSON,ڵתJSONַ
+//ѡlept_parseflagsΪ LEPT_FLAG_* 
+int lept_parse_ex(lept_value* v, const char* json, int flags);
+// LEPT_FLAG_LAZY δ/ַԴıչ LEPT_FLAG_PACK_NUMBERS 飬֮ͷjsonҲԶֻ߳
+void lept_materialize(lept_value* v);
+//ѡԽֻΪpathsJSON Pointerָڵ㣬ಿֻУ鲢
+int lept_parse_select(lept_value* v, const char* json, const char* const* paths, size_t count, int flags);
+//һֵֻʶַŵĽṹУת֣consumedظֵ֮λã
+//ʱΪλãȱֵʱΪֵĿͷַδʱΪlen
+int lept_skip_value(const char* json, size_t len, size_t* consumed);
+//ֻУJSONıڴ棻err_offsetسλãɹʱΪѶȡĳȣΪNULL
+int lept_validate(const char* json, size_t len, size_t* err_offset);
+
+//ʽݷwriteuserԭ
+typedef struct lept_writer
+{
+	void (*write)(void* user, const char* data, size_t len);
+	void* user;
+} lept_writer;
+
+//ѹ/JSONıַֺԭʱش룬дݲ
+int lept_minify(const char* json, size_t len, const lept_writer* w);
+int lept_prettify(const char* json, size_t len, const char* indent, const lept_writer* w);
+// JSON,ڵתJSONַʹlept_stringify_cachedĻ
 char* lept_stringify(const lept_value* v, size_t* length);
+//ַϴ/֮ٴεʱδ޸ĵֱӸƻ
+char* lept_stringify_cached(lept_value* v, size_t* length);
+///vĻ档ͨԪֱָ޸ڵҪÿȵãlept_touch_pointer
+//lept_stringify_cachedԻɵ
+void lept_invalidate(lept_value* v);
+//淶JSONRFC 8785Աkeyȡ̱ʾͬĽڵͬı
+char* lept_stringify_canonical(const lept_value* v, size_t* length);
+//ڵMessagePackƸʽصɵfreeַ//󳤶ȳ0xFFFFFFFFʱNULL
+char* lept_encode_binary(const lept_value* v, size_t* length);
+//MessagePackݣݲҪԿַβ
+int lept_decode_binary(lept_value* v, const char* data, size_t length);
 
 //ͷŽڵvռõڴռ
 void lept_free(lept_value* v);
+
+void lept_copy(lept_value* dst, const lept_value* src);	//ȸƣdstΪsrcĶsrcdstӽڵ
+void lept_move(lept_value* dst, lept_value* src);			//ƶsrcȨתƸdstsrcΪNULLsrcdstӽڵ
+void lept_swap(lept_value* lhs, lept_value* rhs);			//ڵ
+
+//еһηڴУorderΪ LEPT_ORDER_*ַkey/֮
+//ڴֽvǷǿ/ʱκ²0֮Կճȡ޸ĺ lept_free
+//Ԫ/ԱʱѸ/ͬƻͨڴ棬ಿڴУڴɸУ
+//ḴҪƵɾӦ޸ѹƳڲڵ㣨lept_movelept_swapʱͬƸ
+size_t lept_compact(lept_value* v, int order);
+
+int lept_is_equal(const lept_value* lhs, const lept_value* rhs);	//жڵǷṹȣԱ˳ظkeyƥ
+uint64_t lept_hash(const lept_value* v);						//ڵ64λṹϣԱ˳
+
+//JSON PointerRFC 6901ҽڵ㣬ҲʱNULL
+lept_value* lept_find_pointer(const lept_value* v, const char* pointer, size_t len);
+//ͬlept_find_pointer·/Ļ棬޸ǰȡڵ
+lept_value* lept_touch_pointer(lept_value* v, const char* pointer, size_t len);
+//ԭӦúϲRFC 7386
+void lept_apply_merge_patch(lept_value* target, const lept_value* patch);
+//ԭӦJSON PatchRFC 6902opsΪ飻ʧʱ֮ǰĲ᳷
+int lept_apply_patch(lept_value* target, const lept_value* ops);
+//ȽabpatchɰaΪbJSON Patch飨add/remove/replace
+//ͬϣkeyƥԱȥͬĲֺȽ
+void lept_diff(const lept_value* a, const lept_value* b, lept_value* patch);
+
+//ͳƵļʱ׶ΣÿʱֻڲĽ׶
+typedef enum
+{
+	LEPT_PHASE_WHITESPACE,
+	LEPT_PHASE_STRING,
+	LEPT_PHASE_NUMBER,
+	LEPT_PHASE_CONTAINER,		///ššðԼ
+	LEPT_PHASE_COUNT
+} lept_phase;
+
+//ͳơֻбʱ LEPT_ENABLE_STATS Żռͳƴȫȫ0
+//̷ֱ߳ۼӣ̵߳Ŀտ lept_stats_merge 
+typedef struct lept_stats
+{
+	uint64_t bytes_parsed;						//lept_parse ֽ
+	uint64_t nodes[LEPT_OBJECT + 1];			//ͳƽĽڵ
+	uint64_t malloc_calls, malloc_bytes;
+	uint64_t realloc_calls, realloc_bytes;
+	uint64_t stack_high_water;					//lept_context ջֵֽڣջʵõռ
+	uint64_t stack_regrows;						//lept_context ջĴ
+	uint64_t strings_escaped, strings_plain;	//ת/תַkey
+	uint64_t phase_ns[LEPT_PHASE_COUNT];		//׶κʱ
+} lept_stats;
+
+void lept_stats_snapshot(lept_stats* out);							//ǰ̵߳ͳƿ
+void lept_stats_reset(void);										//㵱ǰ̵߳ͳ
+void lept_stats_merge(lept_stats* dst, const lept_stats* src);		//srcۼӵdstջȡϴ
+
+//ֻĵĽڵԭüڶ̼߳乲
+//ֻͨconstӿڣlept_get_*lept_find_pointerlept_stringifyȣȡЩӿڲ޸Ľڵ㣬ɲ
+typedef struct lept_doc lept_doc;
+lept_doc* lept_doc_create(lept_value* v);					//vvȨתƸĵvΪNULLüΪ1
+int lept_doc_parse(lept_doc** doc, const char* json);		//ᣬɹʱ*docüΪ1
+lept_doc* lept_doc_ref(lept_doc* doc);						//üdoc
+void lept_doc_unref(lept_doc* doc);							//ü0ʱͷ
+const lept_value* lept_doc_root(const lept_doc* doc);		//ĵĸڵ
+lept_value* lept_doc_edit(lept_doc** doc);					//дʱƣ*docʱɶĸؿ޸ĵĸڵ
+
+//ĵۣ浱ǰĵȸʱԭ滻߸Գãƽڵ LEPT_DOC_SLOT_INIT ̬ʼ
+typedef struct lept_doc_slot
+{
+	lept_doc* doc;
+	long lock;
+} lept_doc_slot;
+#define LEPT_DOC_SLOT_INIT { NULL, 0 }
+lept_doc* lept_doc_slot_load(lept_doc_slot* slot);					//ȡõǰĵһãûĵʱNULL
+void lept_doc_slot_store(lept_doc_slot* slot, lept_doc* doc);		//docӹһãͷžĵ
+//գleptjson_snapshot.cѽڵдɲָĶļʱֻӳļҲ
+//ֱӳڴֻʣӳͬһļʱҳ档ļֽ򱣴
+enum
+{
+	LEPT_SNAPSHOT_OK = 0,
+	LEPT_SNAPSHOT_IO_ERROR,		//д롢򿪻ӳļʧܣerrnoԭ
+	LEPT_SNAPSHOT_INVALID		//ǿļ汾ֽͬļض
+};
+
+typedef struct lept_snapshot lept_snapshot;
+typedef struct lept_snap_node lept_snap_node;		//еĽڵ㣬ָ lept_snapshot_close ֮ǰЧ
+int lept_snapshot_write(const lept_value* v, const char* path);		//д path.tmp ٸѴ򿪾ļĽ̲Ӱ
+int lept_snapshot_open(lept_snapshot** snap, const char* path);		//ֻļͷʧʱ*snapΪNULL
+void lept_snapshot_close(lept_snapshot* snap);
+const lept_snap_node* lept_snapshot_root(const lept_snapshot* snap);
+
+lept_type lept_snap_get_type(const lept_snap_node* n);
+int lept_snap_get_boolean(const lept_snap_node* n);
+double lept_snap_get_number(const lept_snap_node* n);
+const char* lept_snap_get_string(const lept_snap_node* n);					//'\0'β
+size_t lept_snap_get_string_length(const lept_snap_node* n);
+size_t lept_snap_get_array_size(const lept_snap_node* n);
+const lept_snap_node* lept_snap_get_array_element(const lept_snap_node* n, size_t index);
+size_t lept_snap_get_object_size(const lept_snap_node* n);
+const char* lept_snap_get_object_key(const lept_snap_node* n, size_t index);
+size_t lept_snap_get_object_key_length(const lept_snap_node* n, size_t index);
+const lept_snap_node* lept_snap_get_object_value(const lept_snap_node* n, size_t index);
+const lept_snap_node* lept_snap_find_object_value(const lept_snap_node* n, const char* key, size_t klen);	//±ֲ
+void lept_snap_copy(lept_value* dst, const lept_snap_node* n);			//ѿеΪͨڵ
+
+#ifdef LEPT_ENABLE_INGEST
+//NDJSONȡleptjson_ingest.cPOSIXĶͬʱڶĻгн̡߳
+//ʹio_uringʱ˻Ϊһpreaḍ̶߳ʱȡԶͣ
+enum
+{
+	LEPT_INGEST_OK = 0,
+	LEPT_INGEST_IO_ERROR,		//򿪻ȡļʧܣerrnoԭ
+	LEPT_INGEST_ABORTED			//ص˷0
+};
+
+enum
+{
+	LEPT_INGEST_NO_URING = 1 << 0,	//ʹio_uringֱpread߳
+	LEPT_INGEST_DIRECT = 1 << 1		//O_DIRECTļƹҳ
+};
+
+typedef struct lept_ingest_options
+{
+	size_t buffer_size;		//ÿֽȡ4096ı0ʾ1MB
+	int buffers;			//ڶ͵ȴޣ0ʾ8
+	int workers;			//߳0ʾCPU
+	int flags;				//LEPT_INGEST_* 
+	int parse_flags;		// lept_parse_ex  LEPT_FLAG_*
+	const char* const* select;	//ΪNULLʱ lept_parse_selectֻΪЩ·JSON Pointerڵ
+	size_t select_count;
+} lept_ingest_options;
+
+//һеĽvڻصغͷţҪʱ lept_move ߣLEPT_FLAG_LAZY ʱ lept_materializeline滺黹
+typedef struct lept_ingest_record
+{
+	size_t file;			//pathsе±
+	size_t offset;			//ļеֽƫ
+	const char* line;		//еݣз
+	size_t len;
+	int result;				//lept_parse_ex ķֵ
+	lept_value* v;
+	int worker;				//̱߳ţ0 <= worker < workers
+} lept_ingest_record;
+
+//ڽ߳еãͬһļĸв֤˳򣻷ط0ʱֹͣȡ
+typedef int (*lept_ingest_callback)(void* user, const lept_ingest_record* rec);
+
+typedef struct lept_ingest_stats
+{
+	size_t bytes;			//ȡֽ
+	size_t lines;			//в
+	size_t errors;			//ʧܵ
+	size_t reads;			//ύĶ
+	int io_uring;			//Ƿʹio_uring
+} lept_ingest_stats;
+
+//ζȡpathsеļнcboptionsstatsΪNULL
+int lept_ingest_files(const char* const* paths, size_t count, const lept_ingest_options* options,
+	lept_ingest_callback cb, void* user, lept_ingest_stats* stats);
+#endif
+
 #define lept_set_null(v) lept_free(v);
 
 lept_type lept_get_type(const lept_value* v);			//ʽĺȡ
@@ -80,12 +333,39 @@ const char* lept_get_string(const lept_value* v);						//
 size_t lept_get_string_length(const lept_value* v);						//ȡڵַĳ
 void lept_set_string(lept_value* v, const char* s, size_t len);			//ڵַ
 
+void lept_set_array(lept_value* v, size_t capacity);					//ڵ飬ԤcapacityԪصĿռ
 size_t lept_get_array_size(const lept_value* v);						//ȡԪظ
-lept_value* lept_get_array_element(const lept_value* v, size_t index);	//ȡеĳԪ
+size_t lept_get_array_capacity(const lept_value* v);					//ȡ
+void lept_reserve_array(lept_value* v, size_t capacity);				//capacity
+void lept_shrink_array(lept_value* v);									//Ԫظ
+void lept_clear_array(lept_value* v);									//Ԫأı
+//ȡеĳԪءչ޸v̵߳Ķȡ֮ǰ lept_get_array_doubles صָʧЧ
+//ֻʱ lept_get_array_number lept_materialize
+lept_value* lept_get_array_element(const lept_value* v, size_t index);
+const double* lept_get_array_doubles(const lept_value* v, size_t* n);	// double[] ԪظǽʱNULL
+double lept_get_array_number(const lept_value* v, size_t index);		//ȡĳԪصֵ鲻չ
+void lept_unpack_array(lept_value* v);									//ѽչΪͨ lept_value Ԫأ鲻
+lept_value* lept_pushback_array_element(lept_value* v);					//ĩβһԪأԪ
+void lept_popback_array_element(lept_value* v);							//ɾĩβԪ
+lept_value* lept_insert_array_element(lept_value* v, size_t index);		//indexһԪأԪ
+void lept_erase_array_element(lept_value* v, size_t index, size_t count);	//ɾindexʼcountԪ
 
+void lept_set_object(lept_value* v, size_t capacity);					//ڵö󣬲ԤcapacityԱĿռ
 size_t lept_get_object_size(const lept_value* v);						//ȡԱ
+size_t lept_get_object_capacity(const lept_value* v);					//ȡ
+void lept_reserve_object(lept_value* v, size_t capacity);				//capacity
+void lept_shrink_object(lept_value* v);									//Ա
+void lept_clear_object(lept_value* v);									//նĳԱı
 const char* lept_get_object_key(const lept_value* v, size_t index);		//ȡĳԱkeyֵ
 size_t lept_get_object_key_length(const lept_value* v, size_t index);	//ȡĳԱkeyֵ
 lept_value* lept_get_object_value(const lept_value* v, size_t index);	//ȡĳԱvalueֵ
+size_t lept_find_object_index(const lept_value* v, const char* key, size_t klen);		//keyӦĳԱ±꣬ʱLEPT_KEY_NOT_EXIST
+lept_value* lept_find_object_value(lept_value* v, const char* key, size_t klen);		//keyӦĳԱvalueʱNULL
+lept_value* lept_set_object_value(lept_value* v, const char* key, size_t klen);		//keyӦĳԱvalueʱóԱ
+void lept_remove_object_value(lept_value* v, size_t index);							//ɾеĳԱ
+
+#ifdef __cplusplus
+}
+#endif
 
-#endif // !LEFPJSON_H_
+#endif // !LEPTJSON_H_
@@ -0,0 +1,202 @@
+#ifndef LEPTJSON_HPP_
+#define LEPTJSON_HPP_
+
+//C++17 的 lept_value 封装，只有头文件。
+//lept::value 与 lept_value 布局相同，数组元素和对象成员的值可以直接当作 lept::value& 访问，不额外分配也不复制。
+//所有权只能移动（O(1)，不复制子树），需要深度复制时显式调用 clone()
+
+#include "leptjson.h"
+#include <cassert>
+#include <cstddef>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace lept {
+
+class member;
+
+class value
+{
+public:
+	value() noexcept { lept_init(&v_); }
+	~value() { lept_free(&v_); }
+
+	value(value&& rhs) noexcept
+	{
+		lept_init(&v_);
+		lept_swap(&v_, &rhs.v_);
+	}
+	value& operator=(value&& rhs) noexcept
+	{
+		if (this != &rhs)
+			lept_move(&v_, &rhs.v_);
+		return *this;
+	}
+	value(const value&) = delete;
+	value& operator=(const value&) = delete;
+
+	//解析JSON，返回 LEPT_PARSE_*；json需以空字符结尾
+	int parse(const char* json, int flags = 0) noexcept { lept_free(&v_); return lept_parse_ex(&v_, json, flags); }
+	//深度复制
+	value clone() const
+	{
+		value r;
+		lept_copy(&r.v_, &v_);
+		return r;
+	}
+
+	//把已有的lept_value当作lept::value访问，不转移所有权
+	static value& from(lept_value& v) noexcept { return reinterpret_cast<value&>(v); }
+	static const value& from(const lept_value& v) noexcept { return reinterpret_cast<const value&>(v); }
+	lept_value* c_ptr() noexcept { return &v_; }
+	const lept_value* c_ptr() const noexcept { return &v_; }
+
+	lept_type type() const noexcept { return v_.type; }
+	bool is_null() const noexcept { return v_.type == LEPT_NULL; }
+	bool is_bool() const noexcept { return v_.type == LEPT_TRUE || v_.type == LEPT_FALSE; }
+	bool is_number() const noexcept { return v_.type == LEPT_NUMBER; }
+	bool is_string() const noexcept { return v_.type == LEPT_STRING; }
+	bool is_array() const noexcept { return v_.type == LEPT_ARRAY; }
+	bool is_object() const noexcept { return v_.type == LEPT_OBJECT; }
+
+	bool get_bool() const noexcept { assert(is_bool()); return v_.type == LEPT_TRUE; }
+	//LEPT_FLAG_LAZY 解析的节点首次读取时由C接口解码
+	double get_number() const noexcept { assert(is_number()); return v_.lazy == LEPT_LAZY_PENDING ? lept_get_number(&v_) : v_.u.n; }
+	//直接引用节点中的字符串，长度已知，不需要strlen
+	std::string_view get_string() const noexcept
+	{
+		assert(is_string());
+		if (v_.lazy == LEPT_LAZY_PENDING)
+			lept_get_string(&v_);
+		return std::string_view(v_.u.s.s, v_.u.s.len);
+	}
+
+	void set_null() noexcept { lept_free(&v_); }
+	void set_bool(bool b) noexcept { lept_set_boolean(&v_, b); }
+	void set_number(double n) noexcept { lept_set_number(&v_, n); }
+	void set_string(std::string_view s) { lept_set_string(&v_, s.data(), s.size()); }
+	void set_array(std::size_t capacity = 0) { lept_set_array(&v_, capacity); }
+	void set_object(std::size_t capacity = 0) { lept_set_object(&v_, capacity); }
+
+	//数组/对象的元素个数
+	std::size_t size() const noexcept
+	{
+		assert(is_array() || is_object());
+		return v_.type == LEPT_ARRAY ? v_.u.a.size : v_.u.o.size;
+	}
+
+	//按下标访问数组元素，紧凑数字数组（LEPT_FLAG_PACK_NUMBERS）先展开
+	value& operator[](std::size_t index) noexcept
+	{
+		assert(is_array() && index < v_.u.a.size);
+		return from(*lept_get_array_element(&v_, index));
+	}
+	//只读访问不展开，不修改数组的存储；但 LEPT_FLAG_LAZY 解析的树读取数字/字符串时仍会解码，
+	//未经 lept_materialize 的这种树不能被多个线程同时读取。
+	//紧凑数组没有 lept_value 元素，只能用 doubles() 或 number_at() 读取，否则抛出 std::logic_error
+	const value& operator[](std::size_t index) const
+	{
+		assert(index < v_.u.a.size);
+		return const_elements()[index];
+	}
+	//紧凑数字数组的元素，不展开；普通数组返回nullptr
+	const double* doubles(std::size_t& n) const noexcept { assert(is_array()); return lept_get_array_doubles(&v_, &n); }
+	//数组中某个数字元素的值，紧凑数组不展开
+	double number_at(std::size_t index) const noexcept
+	{
+		assert(is_array() && index < v_.u.a.size);
+		return lept_get_array_number(&v_, index);
+	}
+	//按key访问对象成员：与std::map相同，key不存在时新增值为null的成员
+	value& operator[](std::string_view key) { return from(*lept_set_object_value(&v_, key.data(), key.size())); }
+	//只读访问时key必须存在
+	const value& operator[](std::string_view key) const noexcept
+	{
+		const value* v = find(key);
+		assert(v != nullptr);
+		return *v;
+	}
+	//查找key对应的成员，不存在时返回nullptr
+	value* find(std::string_view key) noexcept
+	{
+		lept_value* v = lept_find_object_value(&v_, key.data(), key.size());
+		return v ? &from(*v) : nullptr;
+	}
+	const value* find(std::string_view key) const noexcept { return const_cast<value*>(this)->find(key); }
+
+	value& push_back() { return from(*lept_pushback_array_element(&v_)); }
+	void pop_back() noexcept { lept_popback_array_element(&v_); }
+
+	//range-for遍历数组元素
+	value* begin() noexcept { assert(is_array()); lept_unpack_array(&v_); return reinterpret_cast<value*>(v_.u.a.e); }
+	value* end() noexcept { return begin() + v_.u.a.size; }
+	//只读遍历与只读下标相同，紧凑数组抛出 std::logic_error
+	const value* begin() const { return const_elements(); }
+	const value* end() const { return begin() + v_.u.a.size; }
+
+	//range-for遍历对象成员
+	template <typename M>
+	struct range
+	{
+		M* first, * last;
+		M* begin() const noexcept { return first; }
+		M* end() const noexcept { return last; }
+	};
+	range<member> members() noexcept;
+	range<const member> members() const noexcept;
+
+	bool operator==(const value& rhs) const noexcept { return lept_is_equal(&v_, &rhs.v_) != 0; }
+	bool operator!=(const value& rhs) const noexcept { return !(*this == rhs); }
+
+private:
+	//只读访问的元素数组。紧凑数组的 double[] 不是 lept_value，不能当作元素读取，任何构建模式下都检查
+	const value* const_elements() const
+	{
+		assert(is_array());
+		if (v_.packed)
+			throw std::logic_error("lept::value: packed array has no element nodes, use number_at() or doubles()");
+		return reinterpret_cast<const value*>(v_.u.a.e);
+	}
+
+	lept_value v_;
+};
+
+//对象成员，与lept_member布局相同
+class member
+{
+public:
+	member() = delete;
+	member(const member&) = delete;
+	member& operator=(const member&) = delete;
+
+	std::string_view key() const noexcept { return std::string_view(m_.k, m_.klen); }
+	lept::value& value() noexcept { return lept::value::from(m_.v); }
+	const lept::value& value() const noexcept { return lept::value::from(m_.v); }
+
+private:
+	lept_member m_;
+};
+
+inline value::range<member> value::members() noexcept
+{
+	assert(is_object());
+	member* m = reinterpret_cast<member*>(v_.u.o.m);
+	return { m, m + v_.u.o.size };
+}
+
+inline value::range<const member> value::members() const noexcept
+{
+	assert(is_object());
+	const member* m = reinterpret_cast<const member*>(v_.u.o.m);
+	return { m, m + v_.u.o.size };
+}
+
+static_assert(sizeof(value) == sizeof(lept_value) && std::is_standard_layout<value>::value, "lept::value must alias lept_value");
+static_assert(sizeof(member) == sizeof(lept_member) && std::is_standard_layout<member>::value, "lept::member must alias lept_member");
+static_assert(std::is_nothrow_move_constructible<value>::value && !std::is_copy_constructible<value>::value, "lept::value is move-only");
+
+} // namespace lept
+
+#endif // !LEPTJSON_HPP_
@@ -0,0 +1,684 @@
+//NDJSON批量读取：读取和解析重叠进行。
+//分发线程（调用者）提交读请求，读完的缓冲区按读取顺序处理：与上一个缓冲区剩下的半行拼接，
+//把整行部分交给解析线程，末尾的半行留给下一个缓冲区。缓冲区解析完才归还，缓冲区个数即内存上限
+#define _GNU_SOURCE
+
+#include "leptjson.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define LEPT_INGEST_URING
+#endif
+#endif
+
+#define LEPT_INGEST_ALIGN			4096
+#define LEPT_INGEST_ROUND_UP(n)		(((n) + LEPT_INGEST_ALIGN - 1) / LEPT_INGEST_ALIGN * LEPT_INGEST_ALIGN)
+#define LEPT_INGEST_BUFFER_SIZE		(1 << 20)
+#define LEPT_INGEST_BUFFERS			8
+
+typedef struct lept_ingest_buffer lept_ingest_buffer;
+struct lept_ingest_buffer
+{
+	char* data;					//LEPT_INGEST_ALIGN对齐，多留一个字节放最后一行的结尾'\0'
+	struct iovec iov;			//iov_len是want按LEPT_INGEST_ALIGN向上取整，满足O_DIRECT的要求
+	size_t file, offset, len;	//读取的文件、偏移和读到的字节数
+	size_t want;				//本块在文件中的字节数
+	size_t seq;					//读请求的序号，分发按序号顺序进行
+	int result;					//读取结果，<0为-errno
+	int last;					//是否为文件的最后一块
+	char* head;					//上一块剩下的半行与本块第一行拼接成的整行，以'\0'结尾
+	size_t head_len, head_offset;
+	size_t begin, end;			//交给解析线程的整行范围
+	lept_ingest_buffer* next;
+};
+
+typedef struct
+{
+	const char* const* paths;
+	size_t count;
+	lept_ingest_options opt;
+	lept_ingest_callback cb;
+	void* user;
+
+	pthread_mutex_t lock;
+	pthread_cond_t job_cond;		//解析线程等待任务
+	pthread_cond_t event_cond;		//分发线程等待空闲缓冲区或读完成（pread线程）
+	pthread_cond_t read_cond;		//pread线程等待读请求
+	lept_ingest_buffer* buffers;
+	lept_ingest_buffer* free_list;
+	lept_ingest_buffer* job_head, * job_tail;
+	lept_ingest_buffer* read_head, * read_tail;		//pread线程的请求队列
+	lept_ingest_buffer* done_list;					//pread线程完成的请求
+	int finished;					//不再有新任务/新请求
+	volatile int abort;
+
+	int* fds;
+	size_t* sizes;
+	size_t lines, errors;
+
+#ifdef LEPT_INGEST_URING
+	int ring_fd;
+	unsigned* sq_tail, * sq_mask, * sq_array;
+	unsigned* cq_head, * cq_tail, * cq_mask;
+	struct io_uring_sqe* sqes;
+	struct io_uring_cqe* cqes;
+	void* sq_ptr, * cq_ptr;
+	size_t sq_size, cq_size, sqes_size;
+	unsigned to_submit;
+#endif
+} lept_ingest_context;
+
+typedef struct
+{
+	lept_ingest_context* c;
+	int id;
+} lept_ingest_worker;
+
+/* io_uring：没有liburing，直接用系统调用映射提交队列和完成队列 */
+
+#ifdef LEPT_INGEST_URING
+static int lept_uring_init(lept_ingest_context* c, unsigned entries)
+{
+	struct io_uring_params p;
+	char* sq;
+	char* cq;
+	memset(&p, 0, sizeof(p));
+	c->ring_fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+	if (c->ring_fd < 0)
+		return -1;
+	c->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	c->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		c->sq_size = c->cq_size = c->sq_size > c->cq_size ? c->sq_size : c->cq_size;
+	c->sq_ptr = mmap(NULL, c->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, c->ring_fd, IORING_OFF_SQ_RING);
+	if (c->sq_ptr == MAP_FAILED)
+		goto fail_sq;
+	c->cq_ptr = c->sq_ptr;
+	if (!(p.features & IORING_FEAT_SINGLE_MMAP))
+	{
+		c->cq_ptr = mmap(NULL, c->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, c->ring_fd, IORING_OFF_CQ_RING);
+		if (c->cq_ptr == MAP_FAILED)
+			goto fail_cq;
+	}
+	c->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	c->sqes = (struct io_uring_sqe*)mmap(NULL, c->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, c->ring_fd, IORING_OFF_SQES);
+	if (c->sqes == MAP_FAILED)
+		goto fail_sqes;
+	sq = (char*)c->sq_ptr;
+	cq = (char*)c->cq_ptr;
+	c->sq_tail = (unsigned*)(sq + p.sq_off.tail);
+	c->sq_mask = (unsigned*)(sq + p.sq_off.ring_mask);
+	c->sq_array = (unsigned*)(sq + p.sq_off.array);
+	c->cq_head = (unsigned*)(cq + p.cq_off.head);
+	c->cq_tail = (unsigned*)(cq + p.cq_off.tail);
+	c->cq_mask = (unsigned*)(cq + p.cq_off.ring_mask);
+	c->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+	c->to_submit = 0;
+	return 0;
+fail_sqes:
+	if (c->cq_ptr != c->sq_ptr)
+		munmap(c->cq_ptr, c->cq_size);
+fail_cq:
+	munmap(c->sq_ptr, c->sq_size);
+fail_sq:
+	close(c->ring_fd);
+	c->ring_fd = -1;
+	return -1;
+}
+
+static void lept_uring_free(lept_ingest_context* c)
+{
+	munmap(c->sqes, c->sqes_size);
+	if (c->cq_ptr != c->sq_ptr)
+		munmap(c->cq_ptr, c->cq_size);
+	munmap(c->sq_ptr, c->sq_size);
+	close(c->ring_fd);
+}
+
+//把读请求放进提交队列，lept_uring_wait 时一起提交
+static void lept_uring_queue(lept_ingest_context* c, lept_ingest_buffer* b)
+{
+	unsigned tail = *c->sq_tail, index = tail & *c->sq_mask;
+	struct io_uring_sqe* sqe = &c->sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_READV;		//READV从第一个io_uring版本起就支持
+	sqe->fd = c->fds[b->file];
+	sqe->addr = (unsigned long)&b->iov;
+	sqe->len = 1;
+	sqe->off = b->offset;
+	sqe->user_data = (unsigned long)b;
+	c->sq_array[index] = index;
+	__atomic_store_n(c->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	c->to_submit++;
+}
+
+//提交排队的请求，等待并取出一个完成的请求
+static lept_ingest_buffer* lept_uring_wait(lept_ingest_context* c)
+{
+	lept_ingest_buffer* b;
+	struct io_uring_cqe* cqe;
+	unsigned head;
+	int n;
+	while (c->to_submit)
+	{
+		if ((n = (int)syscall(__NR_io_uring_enter, c->ring_fd, c->to_submit, 0, 0, NULL, 0)) < 0 && errno != EINTR)
+			return NULL;
+		c->to_submit -= n > 0 ? (unsigned)n : 0;
+	}
+	for (;;)
+	{
+		head = *c->cq_head;
+		if (head != __atomic_load_n(c->cq_tail, __ATOMIC_ACQUIRE))
+			break;
+		if (syscall(__NR_io_uring_enter, c->ring_fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR)
+			return NULL;
+	}
+	cqe = &c->cqes[head & *c->cq_mask];
+	b = (lept_ingest_buffer*)(unsigned long)cqe->user_data;
+	b->result = cqe->res;
+	__atomic_store_n(c->cq_head, head + 1, __ATOMIC_RELEASE);
+	return b;
+}
+#endif
+
+/* pread线程：io_uring不可用时按请求顺序同步读取 */
+
+static void* lept_ingest_reader(void* arg)
+{
+	lept_ingest_context* c = (lept_ingest_context*)arg;
+	lept_ingest_buffer* b;
+	ssize_t n;
+	for (;;)
+	{
+		pthread_mutex_lock(&c->lock);
+		while (c->read_head == NULL && !c->finished)
+			pthread_cond_wait(&c->read_cond, &c->lock);
+		if ((b = c->read_head) == NULL)
+		{
+			pthread_mutex_unlock(&c->lock);
+			return NULL;
+		}
+		if ((c->read_head = b->next) == NULL)
+			c->read_tail = NULL;
+		pthread_mutex_unlock(&c->lock);
+
+		while ((n = pread(c->fds[b->file], b->iov.iov_base, b->iov.iov_len, (off_t)b->offset)) < 0 && errno == EINTR)
+			;
+		b->result = n < 0 ? -errno : (int)n;
+
+		pthread_mutex_lock(&c->lock);
+		b->next = c->done_list;
+		c->done_list = b;
+		pthread_cond_signal(&c->event_cond);
+		pthread_mutex_unlock(&c->lock);
+	}
+}
+
+/* 解析线程 */
+
+static int lept_ingest_blank(const char* p, const char* end)
+{
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+		p++;
+	return p == end;
+}
+
+//解析以'\0'结尾的一行，返回回调的返回值
+static int lept_ingest_line(lept_ingest_context* c, int worker, size_t file, size_t offset, const char* line, size_t len, size_t* lines, size_t* errors)
+{
+	lept_ingest_record rec;
+	lept_value v;
+	int ret;
+	if (lept_ingest_blank(line, line + len))
+		return 0;
+	lept_init(&v);
+	rec.file = file;
+	rec.offset = offset;
+	rec.line = line;
+	rec.len = len;
+	if (c->opt.select)
+		rec.result = lept_parse_select(&v, line, c->opt.select, c->opt.select_count, c->opt.parse_flags);
+	else
+		rec.result = lept_parse_ex(&v, line, c->opt.parse_flags);
+	rec.v = &v;
+	rec.worker = worker;
+	(*lines)++;
+	if (rec.result != LEPT_PARSE_OK)
+		(*errors)++;
+	ret = c->cb(c->user, &rec);
+	lept_free(&v);
+	return ret;
+}
+
+static void lept_ingest_parse(lept_ingest_context* c, int worker, lept_ingest_buffer* b, size_t* lines, size_t* errors)
+{
+	char* p = b->data + b->begin, * end = b->data + b->end, * q;
+	if (b->head && lept_ingest_line(c, worker, b->file, b->head_offset, b->head, b->head_len, lines, errors))
+		c->abort = 1;
+	for (; p < end && !c->abort; p = q + 1)
+	{
+		if ((q = (char*)memchr(p, '\n', (size_t)(end - p))) == NULL)
+			q = end;		//文件最后一块的最后一行，data[len]已是'\0'
+		*q = '\0';
+		if (lept_ingest_line(c, worker, b->file, b->offset + (size_t)(p - b->data), p, (size_t)(q - p), lines, errors))
+			c->abort = 1;
+	}
+}
+
+static void lept_ingest_release(lept_ingest_context* c, lept_ingest_buffer* b)
+{
+	free(b->head);
+	b->head = NULL;
+	b->next = c->free_list;
+	c->free_list = b;
+	pthread_cond_signal(&c->event_cond);
+}
+
+static void* lept_ingest_worker_main(void* arg)
+{
+	lept_ingest_worker* w = (lept_ingest_worker*)arg;
+	lept_ingest_context* c = w->c;
+	lept_ingest_buffer* b;
+	size_t lines = 0, errors = 0;
+	for (;;)
+	{
+		pthread_mutex_lock(&c->lock);
+		while (c->job_head == NULL && !c->finished)
+			pthread_cond_wait(&c->job_cond, &c->lock);
+		if ((b = c->job_head) == NULL)
+			break;
+		if ((c->job_head = b->next) == NULL)
+			c->job_tail = NULL;
+		pthread_mutex_unlock(&c->lock);
+
+		if (!c->abort)
+			lept_ingest_parse(c, w->id, b, &lines, &errors);
+
+		pthread_mutex_lock(&c->lock);
+		lept_ingest_release(c, b);
+		pthread_mutex_unlock(&c->lock);
+	}
+	c->lines += lines;
+	c->errors += errors;
+	pthread_mutex_unlock(&c->lock);
+	return NULL;
+}
+
+/* 分发 */
+
+static int lept_ingest_reserve(char** buf, size_t* cap, size_t size)
+{
+	char* grown;
+	size_t n = *cap ? *cap : 256;
+	if (size <= *cap)
+		return 0;
+	while (n < size)
+		n += n >> 1;
+	if ((grown = (char*)realloc(*buf, n)) == NULL)
+		return -1;
+	*buf = grown;
+	*cap = n;
+	return 0;
+}
+
+//处理按顺序读完的一块：拼接上一块剩下的半行，整行部分交给解析线程，末尾的半行保存到carry。
+//返回1表示需要解析，0表示缓冲区可以直接归还，-1表示内存不足
+static int lept_ingest_dispatch(lept_ingest_buffer* b, char** carry, size_t* carry_len, size_t* carry_cap, size_t* carry_offset)
+{
+	char* data = b->data, * first, * last;
+	size_t len = b->len, n;
+	data[len] = '\0';
+	if ((first = (char*)memchr(data, '\n', len)) == NULL && !b->last)
+	{
+		//整块都在一行内：全部追加到carry
+		if (lept_ingest_reserve(carry, carry_cap, *carry_len + len))
+			return -1;
+		if (*carry_len == 0)
+			*carry_offset = b->offset;
+		memcpy(*carry + *carry_len, data, len);
+		*carry_len += len;
+		return 0;
+	}
+	n = first ? (size_t)(first - data) : len;
+	b->head = NULL;
+	b->begin = 0;
+	if (*carry_len)
+	{
+		if ((b->head = (char*)malloc(*carry_len + n + 1)) == NULL)
+			return -1;
+		memcpy(b->head, *carry, *carry_len);
+		memcpy(b->head + *carry_len, data, n);
+		b->head_len = *carry_len + n;
+		b->head[b->head_len] = '\0';
+		b->head_offset = *carry_offset;
+		b->begin = first ? n + 1 : len;
+		*carry_len = 0;
+	}
+	if (b->last)
+		b->end = len;
+	else
+	{
+		last = (char*)memrchr(data, '\n', len);
+		b->end = (size_t)(last - data) + 1;
+		if (lept_ingest_reserve(carry, carry_cap, len - b->end))
+			return -1;
+		*carry_offset = b->offset + b->end;
+		*carry_len = len - b->end;
+		memcpy(*carry, last + 1, *carry_len);
+	}
+	return 1;
+}
+
+static void lept_ingest_push_job(lept_ingest_context* c, lept_ingest_buffer* b)
+{
+	b->next = NULL;
+	if (c->job_tail)
+		c->job_tail->next = b;
+	else
+		c->job_head = b;
+	c->job_tail = b;
+	pthread_cond_signal(&c->job_cond);
+}
+
+//fd是否以O_DIRECT打开
+static int lept_ingest_is_direct(int fd)
+{
+#ifdef O_DIRECT
+	int flags = fcntl(fd, F_GETFL);
+	return flags >= 0 && (flags & O_DIRECT) != 0;
+#else
+	(void)fd;
+	return 0;
+#endif
+}
+
+static int lept_ingest_open(lept_ingest_context* c, size_t i)
+{
+	struct stat st;
+	int fd = -1;
+#ifdef O_DIRECT
+	if (c->opt.flags & LEPT_INGEST_DIRECT)
+		fd = open(c->paths[i], O_RDONLY | O_DIRECT);
+#endif
+	if (fd < 0 && (fd = open(c->paths[i], O_RDONLY)) < 0)
+		return -1;
+	if (fstat(fd, &st) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+	c->fds[i] = fd;
+	c->sizes[i] = (size_t)st.st_size;
+#ifdef POSIX_FADV_SEQUENTIAL
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+	return 0;
+}
+
+int lept_ingest_files(const char* const* paths, size_t count, const lept_ingest_options* options,
+	lept_ingest_callback cb, void* user, lept_ingest_stats* stats)
+{
+	lept_ingest_context c;
+	lept_ingest_worker* workers = NULL;
+	pthread_t* threads = NULL, reader;
+	lept_ingest_buffer** pending = NULL;		//已读完、等待按序分发的缓冲区，下标为 seq % buffers
+	lept_ingest_buffer* b;
+	char* carry = NULL;
+	size_t carry_len = 0, carry_cap = 0, carry_offset = 0;
+	size_t file = 0, offset = 0, next_seq = 0, seq = 0, bytes = 0, reads = 0, i;
+	int in_flight = 0, started = 0, use_uring = 0, has_reader = 0, ret = LEPT_INGEST_OK, err = 0;
+
+	memset(&c, 0, sizeof(c));
+	if (options)
+		c.opt = *options;
+	if (c.opt.buffer_size == 0)
+		c.opt.buffer_size = LEPT_INGEST_BUFFER_SIZE;
+	c.opt.buffer_size = LEPT_INGEST_ROUND_UP(c.opt.buffer_size);
+	if (c.opt.buffers <= 0)
+		c.opt.buffers = LEPT_INGEST_BUFFERS;
+	if (c.opt.workers <= 0 && (c.opt.workers = (int)sysconf(_SC_NPROCESSORS_ONLN)) <= 0)
+		c.opt.workers = 1;
+	c.paths = paths;
+	c.count = count;
+	c.cb = cb;
+	c.user = user;
+	pthread_mutex_init(&c.lock, NULL);
+	pthread_cond_init(&c.job_cond, NULL);
+	pthread_cond_init(&c.event_cond, NULL);
+	pthread_cond_init(&c.read_cond, NULL);
+
+	c.fds = (int*)malloc(sizeof(int) * (count ? count : 1));
+	c.sizes = (size_t*)malloc(sizeof(size_t) * (count ? count : 1));
+	c.buffers = (lept_ingest_buffer*)calloc((size_t)c.opt.buffers, sizeof(lept_ingest_buffer));
+	pending = (lept_ingest_buffer**)calloc((size_t)c.opt.buffers, sizeof(lept_ingest_buffer*));
+	workers = (lept_ingest_worker*)malloc(sizeof(lept_ingest_worker) * (size_t)c.opt.workers);
+	threads = (pthread_t*)malloc(sizeof(pthread_t) * (size_t)c.opt.workers);
+	if (!c.fds || !c.sizes || !c.buffers || !pending || !workers || !threads)
+	{
+		err = ENOMEM;
+		goto cleanup;
+	}
+	for (i = 0; i < count; i++)
+		c.fds[i] = -1;
+	for (i = 0; i < (size_t)c.opt.buffers; i++)
+	{
+		b = &c.buffers[i];
+		if (posix_memalign((void**)&b->data, LEPT_INGEST_ALIGN, c.opt.buffer_size + LEPT_INGEST_ALIGN) != 0)
+		{
+			err = ENOMEM;
+			goto cleanup;
+		}
+		b->next = c.free_list;
+		c.free_list = b;
+	}
+
+#ifdef LEPT_INGEST_URING
+	c.ring_fd = -1;
+	if (!(c.opt.flags & LEPT_INGEST_NO_URING) && lept_uring_init(&c, (unsigned)c.opt.buffers) == 0)
+		use_uring = 1;
+#endif
+	if (!use_uring)
+	{
+		if ((err = pthread_create(&reader, NULL, lept_ingest_reader, &c)) != 0)
+			goto cleanup;
+		has_reader = 1;
+	}
+	for (; started < c.opt.workers; started++)
+	{
+		workers[started].c = &c;
+		workers[started].id = started;
+		if ((err = pthread_create(&threads[started], NULL, lept_ingest_worker_main, &workers[started])) != 0)
+			break;
+	}
+	if (started == 0)
+		goto cleanup;
+	err = 0;
+
+	pthread_mutex_lock(&c.lock);
+	for (;;)
+	{
+		//有空闲缓冲区就提交下一块的读请求
+		while (c.free_list && file < count && !c.abort && ret == LEPT_INGEST_OK)
+		{
+			if (c.fds[file] < 0 && lept_ingest_open(&c, file) != 0)
+			{
+				err = errno;
+				ret = LEPT_INGEST_IO_ERROR;
+				break;
+			}
+			if (c.sizes[file] == 0)
+			{
+				close(c.fds[file]);
+				c.fds[file++] = -1;
+				continue;
+			}
+			b = c.free_list;
+			c.free_list = b->next;
+			b->file = file;
+			b->offset = offset;
+			b->want = c.sizes[file] - offset < c.opt.buffer_size ? c.sizes[file] - offset : c.opt.buffer_size;
+			b->iov.iov_base = b->data;
+			b->iov.iov_len = LEPT_INGEST_ROUND_UP(b->want);
+			b->seq = seq++;
+			if ((offset += b->want) >= c.sizes[file])
+				file++, offset = 0;
+			in_flight++;
+			reads++;
+#ifdef LEPT_INGEST_URING
+			if (use_uring)
+			{
+				lept_uring_queue(&c, b);
+				continue;
+			}
+#endif
+			b->next = NULL;
+			if (c.read_tail)
+				c.read_tail->next = b;
+			else
+				c.read_head = b;
+			c.read_tail = b;
+			pthread_cond_signal(&c.read_cond);
+		}
+		if (in_flight == 0)
+		{
+			if (file >= count || c.abort || ret != LEPT_INGEST_OK)
+				break;
+			//缓冲区都在解析线程手里，等待归还
+			pthread_cond_wait(&c.event_cond, &c.lock);
+			continue;
+		}
+
+		//等待一个读完成
+#ifdef LEPT_INGEST_URING
+		if (use_uring)
+		{
+			pthread_mutex_unlock(&c.lock);
+			b = lept_uring_wait(&c);
+			pthread_mutex_lock(&c.lock);
+			if (b == NULL)
+			{
+				err = errno;
+				ret = LEPT_INGEST_IO_ERROR;
+				break;		//环已不可用，无法等待其余请求
+			}
+		}
+		else
+#endif
+		{
+			while (c.done_list == NULL)
+				pthread_cond_wait(&c.event_cond, &c.lock);
+			b = c.done_list;
+			c.done_list = b->next;
+		}
+		in_flight--;
+		pending[b->seq % (size_t)c.opt.buffers] = b;
+
+		//按序号顺序分发
+		while ((b = pending[next_seq % (size_t)c.opt.buffers]) != NULL && b->seq == next_seq)
+		{
+			int r;
+			pending[next_seq++ % (size_t)c.opt.buffers] = NULL;
+			if (b->result >= 0 && (size_t)b->result < b->want)
+			{
+				//短读：同步读完剩余部分，读不到时视为文件结束。
+				//O_DIRECT要求地址、偏移和长度都对齐，读到的长度不对齐时只能是读到了文件末尾
+				ssize_t n;
+				size_t got = (size_t)b->result;
+				int direct = lept_ingest_is_direct(c.fds[b->file]);
+				while (got < b->want && (!direct || got % LEPT_INGEST_ALIGN == 0) &&
+					(n = pread(c.fds[b->file], b->data + got, direct ? LEPT_INGEST_ROUND_UP(b->want - got) : b->want - got, (off_t)(b->offset + got))) > 0)
+					got += (size_t)n;
+				b->result = (int)got;
+			}
+			if (b->result > 0 && (size_t)b->result > b->want)
+				b->result = (int)b->want;	//按对齐长度读时文件变长了，多读的部分属于下一块
+			if (b->result < 0 || c.abort || ret != LEPT_INGEST_OK)
+			{
+				if (b->result < 0 && ret == LEPT_INGEST_OK)
+				{
+					err = -b->result;
+					ret = LEPT_INGEST_IO_ERROR;
+				}
+				lept_ingest_release(&c, b);
+				continue;
+			}
+			//读不满说明文件变短了，同样当作文件结束，剩下的块读到0字节
+			b->len = (size_t)b->result;
+			b->last = b->offset + b->len >= c.sizes[b->file] || b->len < b->want;
+			bytes += b->len;
+			if (b->offset + b->want >= c.sizes[b->file])
+			{
+				close(c.fds[b->file]);		//该文件的读请求都已完成
+				c.fds[b->file] = -1;
+			}
+			r = lept_ingest_dispatch(b, &carry, &carry_len, &carry_cap, &carry_offset);
+			if (r > 0)
+				lept_ingest_push_job(&c, b);
+			else
+			{
+				if (r < 0)
+				{
+					err = ENOMEM;
+					ret = LEPT_INGEST_IO_ERROR;
+				}
+				lept_ingest_release(&c, b);
+			}
+		}
+	}
+	pthread_mutex_unlock(&c.lock);
+
+cleanup:
+	pthread_mutex_lock(&c.lock);
+	c.finished = 1;
+	pthread_cond_broadcast(&c.job_cond);
+	pthread_cond_broadcast(&c.read_cond);
+	pthread_mutex_unlock(&c.lock);
+	for (i = 0; i < (size_t)started; i++)
+		pthread_join(threads[i], NULL);
+	if (has_reader)
+		pthread_join(reader, NULL);
+#ifdef LEPT_INGEST_URING
+	if (use_uring)
+		lept_uring_free(&c);
+#endif
+	if (ret == LEPT_INGEST_OK && err)
+		ret = LEPT_INGEST_IO_ERROR;
+	if (ret == LEPT_INGEST_OK && c.abort)
+		ret = LEPT_INGEST_ABORTED;
+	if (stats)
+	{
+		stats->bytes = bytes;
+		stats->lines = c.lines;
+		stats->errors = c.errors;
+		stats->reads = reads;
+		stats->io_uring = use_uring;
+	}
+	for (i = 0; c.fds && i < count; i++)
+		if (c.fds[i] >= 0)
+			close(c.fds[i]);
+	for (i = 0; c.buffers && i < (size_t)c.opt.buffers; i++)
+		free(c.buffers[i].data);
+	free(carry);
+	free(c.fds);
+	free(c.sizes);
+	free(c.buffers);
+	free(pending);
+	free(workers);
+	free(threads);
+	pthread_cond_destroy(&c.read_cond);
+	pthread_cond_destroy(&c.event_cond);
+	pthread_cond_destroy(&c.job_cond);
+	pthread_mutex_destroy(&c.lock);
+	errno = err;
+	return ret;
+}
@@ -0,0 +1,553 @@
+#ifndef LEPTJSON_LITERAL_HPP_
+#define LEPTJSON_LITERAL_HPP_
+
+//C++20 编译期JSON字面量：R"({"port":8080})"_json 在编译期按 lept_parse 的语法解析，
+//不合法的JSON是编译错误。结果是静态只读的节点表，运行时不解析也不分配内存。
+//lept::schema<T> 把结构体的成员绑定到key，decode 按绑定逐个字段展开，解码代码在编译期针对每个结构体生成
+
+#include "leptjson.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+namespace lept {
+
+namespace literal_detail {
+
+//不是constexpr函数：编译期求值时调用它会使表达式不是常量表达式，编译器报错并指出reason
+inline void json_literal_error(const char* reason) { (void)reason; }
+
+//字符串字面量作为模板参数
+template <std::size_t N>
+struct fixed_string
+{
+	char data[N];
+	constexpr fixed_string(const char (&s)[N]) { for (std::size_t i = 0; i < N; i++) data[i] = s[i]; }
+	constexpr std::string_view view() const { return std::string_view(data, N - 1); }
+};
+
+//节点表中的一个节点。字符串和key以偏移量保存在字符表中，这样节点表可以按值复制；
+//数组/对象的子节点在节点表中连续存放，从first开始共size个
+struct node
+{
+	lept_type type = LEPT_NULL;
+	double n = 0;
+	std::size_t str = 0, len = 0;
+	std::size_t key = 0, klen = 0;
+	std::size_t first = 0, size = 0;
+};
+
+//递归下降解析，语法与 lept_parse 相同。nodes为nullptr时只统计节点数和字符数
+struct parser
+{
+	std::string_view s;
+	std::size_t p = 0;
+	node* nodes = nullptr;
+	char* chars = nullptr;
+	std::size_t node_count = 1, char_count = 0;		//0号节点为根节点
+
+	constexpr char peek() const { return p < s.size() ? s[p] : '\0'; }
+	constexpr void whitespace() { while (peek() == ' ' || peek() == '\t' || peek() == '\n' || peek() == '\r') p++; }
+	static constexpr bool is_digit(char ch) { return ch >= '0' && ch <= '9'; }
+
+	constexpr void put(char ch)
+	{
+		if (chars)
+			chars[char_count] = ch;
+		char_count++;
+	}
+
+	constexpr void parse_literal(node& v, std::string_view literal, lept_type type)
+	{
+		if (s.substr(p, literal.size()) != literal)
+			json_literal_error("invalid value");
+		p += literal.size();
+		v.type = type;
+	}
+
+	//10的e次方，e不超过22时是精确值
+	static constexpr long double pow10(int e)
+	{
+		long double r = 1, base = 10;
+		for (unsigned u = e < 0 ? -e : e; u; u >>= 1, base *= base)
+			if (u & 1)
+				r *= base;
+		return e < 0 ? 1 / r : r;
+	}
+
+	//有效数字不超过2^53且指数绝对值不超过22时，一次乘除即可得到正确舍入的结果；其余情况用long double近似
+	constexpr void parse_number(node& v)
+	{
+		std::uint64_t m = 0;
+		int digits = 0, scale = 0, e = 0, esign = 1;
+		bool negative = false;
+		if (peek() == '-') { negative = true; p++; }
+		if (peek() == '0')
+			p++;
+		else if (peek() >= '1' && peek() <= '9')
+			for (; is_digit(peek()); p++)
+				if (digits < 19) { m = m * 10 + (peek() - '0'); digits += m != 0; }
+				else scale++;
+		else
+			json_literal_error("invalid value");
+		if (peek() == '.')
+		{
+			p++;
+			if (!is_digit(peek()))
+				json_literal_error("invalid value");
+			for (; is_digit(peek()); p++)
+				if (digits < 19) { m = m * 10 + (peek() - '0'); digits += m != 0; scale--; }
+		}
+		if (peek() == 'e' || peek() == 'E')
+		{
+			p++;
+			if (peek() == '+' || peek() == '-')
+				esign = s[p++] == '-' ? -1 : 1;
+			if (!is_digit(peek()))
+				json_literal_error("invalid value");
+			for (; is_digit(peek()); p++)
+				if (e < 100000)
+					e = e * 10 + (peek() - '0');
+		}
+		e = e * esign + scale;
+		double d;
+		if (m == 0)
+			d = 0;
+		else if (m <= (std::uint64_t(1) << 53) && e >= -22 && e <= 22)
+			d = e < 0 ? double(m) / double(pow10(-e)) : double(m) * double(pow10(e));
+		else if (e > 400)
+			d = __builtin_huge_val();
+		else if (e < -400)
+			d = 0;
+		else
+			d = double(static_cast<long double>(m) * pow10(e));
+		if (d > 1.7976931348623157e308)
+			json_literal_error("number too big");
+		v.type = LEPT_NUMBER;
+		v.n = negative ? -d : d;
+	}
+
+	constexpr unsigned hex4()
+	{
+		unsigned u = 0;
+		for (int i = 0; i < 4; i++, p++)
+		{
+			char ch = peek();
+			u <<= 4;
+			if (is_digit(ch)) u |= ch - '0';
+			else if (ch >= 'A' && ch <= 'F') u |= ch - ('A' - 10);
+			else if (ch >= 'a' && ch <= 'f') u |= ch - ('a' - 10);
+			else json_literal_error("invalid unicode hex");
+		}
+		return u;
+	}
+
+	constexpr void encode_utf8(unsigned u)
+	{
+		if (u <= 0x7F)
+			put(char(u));
+		else if (u <= 0x7FF)
+		{
+			put(char(0xC0 | (u >> 6)));
+			put(char(0x80 | (u & 0x3F)));
+		}
+		else if (u <= 0xFFFF)
+		{
+			put(char(0xE0 | (u >> 12)));
+			put(char(0x80 | ((u >> 6) & 0x3F)));
+			put(char(0x80 | (u & 0x3F)));
+		}
+		else
+		{
+			put(char(0xF0 | (u >> 18)));
+			put(char(0x80 | ((u >> 12) & 0x3F)));
+			put(char(0x80 | ((u >> 6) & 0x3F)));
+			put(char(0x80 | (u & 0x3F)));
+		}
+	}
+
+	//解析字符串，解码后的内容追加到字符表中
+	constexpr void parse_string(std::size_t& str, std::size_t& len)
+	{
+		p++;	//跳过 '"'
+		str = char_count;
+		for (;;)
+		{
+			char ch = peek();
+			p++;
+			if (ch == '"')
+				break;
+			if (ch == '\\')
+			{
+				switch (s[p++])
+				{
+				case '"': put('"'); break;
+				case '\\': put('\\'); break;
+				case '/': put('/'); break;
+				case 'b': put('\b'); break;
+				case 'f': put('\f'); break;
+				case 'n': put('\n'); break;
+				case 'r': put('\r'); break;
+				case 't': put('\t'); break;
+				case 'u':
+				{
+					unsigned u = hex4();
+					if (u >= 0xD800 && u <= 0xDBFF)
+					{
+						if (peek() != '\\' || (p++, peek()) != 'u')
+							json_literal_error("invalid unicode surrogate");
+						p++;
+						unsigned u2 = hex4();
+						if (u2 < 0xDC00 || u2 > 0xDFFF)
+							json_literal_error("invalid unicode surrogate");
+						u = (((u - 0xD800) << 10) | (u2 - 0xDC00)) + 0x10000;
+					}
+					encode_utf8(u);
+					break;
+				}
+				default: json_literal_error("invalid string escape");
+				}
+			}
+			else if (ch == '\0' && p > s.size())
+				json_literal_error("miss quotation mark");
+			else if (static_cast<unsigned char>(ch) < 0x20)
+				json_literal_error("invalid string char");
+			else
+				put(ch);
+		}
+		len = char_count - str;
+	}
+
+	//预先数出容器的元素个数，以便子节点连续存放。只跟踪括号和字符串，语法错误留给正式解析报告
+	constexpr std::size_t count_elements() const
+	{
+		std::size_t q = p, n = 1;
+		int depth = 0;
+		for (; q < s.size(); q++)
+		{
+			char ch = s[q];
+			if (ch == '"')
+			{
+				for (q++; q < s.size() && s[q] != '"'; q++)
+					if (s[q] == '\\')
+						q++;
+			}
+			else if (ch == '[' || ch == '{')
+				depth++;
+			else if ((ch == ']' || ch == '}') && depth-- == 0)
+				break;
+			else if (ch == ',' && depth == 0)
+				n++;
+		}
+		return n;
+	}
+
+	constexpr void parse_value(std::size_t slot)
+	{
+		node temp;
+		node& v = nodes ? nodes[slot] : temp;
+		switch (peek())
+		{
+		case 't': parse_literal(v, "true", LEPT_TRUE); break;
+		case 'f': parse_literal(v, "false", LEPT_FALSE); break;
+		case 'n': parse_literal(v, "null", LEPT_NULL); break;
+		case '"': v.type = LEPT_STRING; parse_string(v.str, v.len); break;
+		case '[':
+		case '{':
+		{
+			bool object = peek() == '{';
+			char close = object ? '}' : ']';
+			v.type = object ? LEPT_OBJECT : LEPT_ARRAY;
+			p++;
+			whitespace();
+			if (peek() == close)
+			{
+				p++;
+				break;
+			}
+			v.size = count_elements();
+			v.first = node_count;
+			node_count += v.size;
+			for (std::size_t i = 0; ; i++)
+			{
+				if (i == v.size)
+					json_literal_error(object ? "miss comma or curly bracket" : "miss comma or square bracket");
+				if (object)
+				{
+					std::size_t key = 0, klen = 0;
+					if (peek() != '"')
+						json_literal_error("miss key");
+					parse_string(key, klen);
+					if (nodes)
+					{
+						nodes[v.first + i].key = key;
+						nodes[v.first + i].klen = klen;
+					}
+					whitespace();
+					if (peek() != ':')
+						json_literal_error("miss colon");
+					p++;
+					whitespace();
+				}
+				parse_value(v.first + i);
+				whitespace();
+				if (peek() == ',')
+				{
+					p++;
+					whitespace();
+				}
+				else if (peek() == close)
+				{
+					p++;
+					if (i + 1 != v.size)
+						json_literal_error(object ? "miss comma or curly bracket" : "miss comma or square bracket");
+					break;
+				}
+				else
+					json_literal_error(object ? "miss comma or curly bracket" : "miss comma or square bracket");
+			}
+			break;
+		}
+		case '\0': json_literal_error("expect value"); break;
+		default: parse_number(v); break;
+		}
+	}
+
+	constexpr void run()
+	{
+		whitespace();
+		parse_value(0);
+		whitespace();
+		if (p != s.size())
+			json_literal_error("root not singular");
+	}
+};
+
+struct counts
+{
+	std::size_t nodes, chars;
+};
+
+consteval counts count(std::string_view s)
+{
+	parser ps{ s };
+	ps.run();
+	return { ps.node_count, ps.char_count };
+}
+
+template <std::size_t NodeCount, std::size_t CharCount>
+struct document
+{
+	std::array<node, NodeCount> nodes{};
+	std::array<char, CharCount == 0 ? 1 : CharCount> chars{};
+};
+
+template <fixed_string S>
+consteval auto build()
+{
+	constexpr counts c = count(S.view());
+	document<c.nodes, c.chars> d;
+	parser ps{ S.view(), 0, d.nodes.data(), d.chars.data() };
+	ps.run();
+	return d;
+}
+
+//每个不同的字面量对应一个静态只读的节点表
+template <fixed_string S>
+inline constexpr auto literal_document = build<S>();
+
+//运行时查找不存在的key时返回的null节点
+inline constexpr node null_node{};
+
+} // namespace literal_detail
+
+//编译期字面量中的一个节点，只读视图，接口与 lept::value 的只读部分相同
+class static_value
+{
+public:
+	constexpr static_value(const literal_detail::node* nodes, const char* chars, std::size_t index) noexcept
+		: nodes_(nodes), chars_(chars), i_(index) {}
+
+	constexpr lept_type type() const noexcept { return node_().type; }
+	constexpr bool is_null() const noexcept { return type() == LEPT_NULL; }
+	constexpr bool is_bool() const noexcept { return type() == LEPT_TRUE || type() == LEPT_FALSE; }
+	constexpr bool is_number() const noexcept { return type() == LEPT_NUMBER; }
+	constexpr bool is_string() const noexcept { return type() == LEPT_STRING; }
+	constexpr bool is_array() const noexcept { return type() == LEPT_ARRAY; }
+	constexpr bool is_object() const noexcept { return type() == LEPT_OBJECT; }
+
+	constexpr bool get_bool() const noexcept { return type() == LEPT_TRUE; }
+	constexpr double get_number() const noexcept { return node_().n; }
+	constexpr std::string_view get_string() const noexcept { return std::string_view(chars_ + node_().str, node_().len); }
+	//作为对象成员时的key
+	constexpr std::string_view key() const noexcept { return std::string_view(chars_ + node_().key, node_().klen); }
+	constexpr std::size_t size() const noexcept { return node_().size; }
+
+	constexpr static_value operator[](std::size_t index) const noexcept { return static_value(nodes_, chars_, node_().first + index); }
+	constexpr std::optional<static_value> find(std::string_view key) const noexcept
+	{
+		for (std::size_t i = 0; i < size(); i++)
+			if ((*this)[i].key() == key)
+				return (*this)[i];
+		return std::nullopt;
+	}
+	//key不存在时：编译期求值报错，运行时返回一个null节点
+	constexpr static_value operator[](std::string_view key) const noexcept
+	{
+		std::optional<static_value> v = find(key);
+		if (v)
+			return *v;
+		literal_detail::json_literal_error("key not found");
+		return static_value(&literal_detail::null_node, "", 0);
+	}
+
+	//遍历数组元素或对象成员，对象成员用key()取得key
+	class iterator
+	{
+	public:
+		constexpr iterator(const literal_detail::node* nodes, const char* chars, std::size_t index) noexcept
+			: nodes_(nodes), chars_(chars), i_(index) {}
+		constexpr static_value operator*() const noexcept { return static_value(nodes_, chars_, i_); }
+		constexpr iterator& operator++() noexcept { i_++; return *this; }
+		constexpr bool operator!=(const iterator& rhs) const noexcept { return i_ != rhs.i_; }
+	private:
+		const literal_detail::node* nodes_;
+		const char* chars_;
+		std::size_t i_;
+	};
+	constexpr iterator begin() const noexcept { return iterator(nodes_, chars_, node_().first); }
+	constexpr iterator end() const noexcept { return iterator(nodes_, chars_, node_().first + node_().size); }
+
+	//在运行时复制成可修改的 lept::value
+	value to_value() const
+	{
+		value v;
+		switch (type())
+		{
+		case LEPT_NULL: break;
+		case LEPT_FALSE: case LEPT_TRUE: v.set_bool(get_bool()); break;
+		case LEPT_NUMBER: v.set_number(get_number()); break;
+		case LEPT_STRING: v.set_string(get_string()); break;
+		case LEPT_ARRAY:
+			v.set_array(size());
+			for (static_value e : *this)
+				v.push_back() = e.to_value();
+			break;
+		case LEPT_OBJECT:
+			v.set_object(size());
+			for (static_value m : *this)
+				v[m.key()] = m.to_value();
+			break;
+		}
+		return v;
+	}
+
+private:
+	constexpr const literal_detail::node& node_() const noexcept { return nodes_[i_]; }
+
+	const literal_detail::node* nodes_;
+	const char* chars_;
+	std::size_t i_;
+};
+
+namespace literals {
+
+template <literal_detail::fixed_string S>
+constexpr static_value operator""_json() noexcept
+{
+	return static_value(literal_detail::literal_document<S>.nodes.data(), literal_detail::literal_document<S>.chars.data(), 0);
+}
+
+} // namespace literals
+
+//结构体成员与key的绑定
+template <typename T, typename M>
+struct field
+{
+	std::string_view key;
+	M T::* member;
+};
+
+template <typename T, typename M>
+constexpr field<T, M> bind(std::string_view key, M T::* member) noexcept { return { key, member }; }
+
+//为结构体T特化，提供 static constexpr auto fields = std::make_tuple(lept::bind("key", &T::member), ...);
+template <typename T>
+struct schema;
+
+namespace literal_detail {
+
+template <typename T, typename = void>
+struct has_schema : std::false_type {};
+template <typename T>
+struct has_schema<T, std::void_t<decltype(schema<T>::fields)>> : std::true_type {};
+
+//V为 static_value 或 lept::value，两者的只读接口相同
+template <typename V, typename M>
+constexpr bool decode_into(const V& v, M& out);
+
+template <typename V, typename T, typename M>
+constexpr bool decode_field(const V& v, T& out, const field<T, M>& f)
+{
+	auto member = v.find(f.key);
+	return member ? decode_into(*member, out.*f.member) : true;		//缺少的key保留原值
+}
+
+template <typename V, typename M>
+constexpr bool decode_into(const V& v, M& out)
+{
+	if constexpr (std::is_same_v<M, bool>)
+	{
+		if (!v.is_bool())
+			return false;
+		out = v.get_bool();
+	}
+	else if constexpr (std::is_arithmetic_v<M>)
+	{
+		if (!v.is_number())
+			return false;
+		out = static_cast<M>(v.get_number());
+	}
+	else if constexpr (std::is_same_v<M, std::string_view> || std::is_same_v<M, std::string>)
+	{
+		if (!v.is_string())
+			return false;
+		out = M(v.get_string());
+	}
+	else
+	{
+		static_assert(has_schema<M>::value, "lept::schema<T> is not specialized for this type");
+		if (!v.is_object())
+			return false;
+		return std::apply([&](const auto&... f) { return (decode_field(v, out, f) && ...); }, schema<M>::fields);
+	}
+	return true;
+}
+
+} // namespace literal_detail
+
+//运行时按绑定解码，类型不符时返回false。std::string_view成员引用v中的字符串，生命周期不超过v
+template <typename T>
+bool decode(const value& v, T& out)
+{
+	return literal_detail::decode_into(v, out);
+}
+
+//编译期从字面量解码，类型不符时编译失败
+template <typename T>
+consteval T decode(static_value v)
+{
+	T out{};
+	if (!literal_detail::decode_into(v, out))
+		literal_detail::json_literal_error("literal does not match the schema");
+	return out;
+}
+
+} // namespace lept
+
+#endif // !LEPTJSON_LITERAL_HPP_
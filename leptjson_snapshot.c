@@ -0,0 +1,535 @@
+//节点树快照：把树按广度优先写成不含指针的二进制文件，打开时整个映射到内存，直接在映射上只读访问，不需要解析。
+//每个节点16字节，偏移都相对于引用它的节点（或成员）本身，所以映射到任何地址都可以使用；多个进程映射同一文件时共享页缓存。
+//文件按本机字节序写出，只能在字节序相同的机器上打开
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "leptjson.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//成员个数不少于该值的对象在成员数组之后附加按key排序的下标，查找时二分
+#ifndef LEPT_SNAPSHOT_INDEX_MIN
+#define LEPT_SNAPSHOT_INDEX_MIN 16
+#endif
+
+#define LEPT_SNAPSHOT_MAGIC		"LEPTSNAP"
+#define LEPT_SNAPSHOT_VERSION	1
+#define LEPT_SNAPSHOT_BOM		0x01020304u		//读出的值不同说明字节序不同
+
+//tag的低3位是类型，其余是字符串长度或数组/对象的元素个数。
+//data：数字为double的位模式；字符串、非空数组/对象为数据相对本节点的偏移，数据总在节点之后
+struct lept_snap_node
+{
+	uint64_t tag;
+	uint64_t data;
+};
+
+//key为key相对本成员的偏移，key和字符串都以'\0'结尾
+typedef struct
+{
+	uint64_t key, klen;
+	lept_snap_node v;
+} lept_snap_member;
+
+typedef struct
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t bom;
+	uint64_t size;			//文件总长度
+	lept_snap_node root;
+} lept_snapshot_header;
+
+struct lept_snapshot
+{
+	const char* base;
+	size_t size;
+#ifdef _WIN32
+	HANDLE file, mapping;
+#endif
+};
+
+#define LEPT_SNAP_ALIGN(n)		(((n) + 7) & ~(uint64_t)7)
+#define LEPT_SNAP_TYPE(n)		((lept_type)((n)->tag & 7))
+#define LEPT_SNAP_SIZE(n)		((size_t)((n)->tag >> 3))
+#define LEPT_SNAP_DATA(n)		((const char*)(n) + (n)->data)
+
+typedef struct
+{
+	FILE* fp;
+	uint64_t pos;					//已写出的字节数
+	uint64_t next;					//下一个数组/对象数据块的位置
+	const lept_value** queue;		//已分配位置、等待写出的数组/对象，按位置顺序排列
+	size_t head, count, capacity;
+	int error;
+}lept_snap_writer;
+
+//读取数组的第i个元素，紧凑数字数组不展开
+static const lept_value* lept_snap_child(const lept_value* v, size_t i, lept_value* tmp)
+{
+	size_t n;
+	if (lept_get_array_doubles(v, &n) == NULL)
+		return lept_get_array_element(v, i);
+	lept_init(tmp);
+	lept_set_number(tmp, lept_get_array_number(v, i));
+	return tmp;
+}
+
+static size_t lept_snap_count(const lept_value* v)
+{
+	return lept_get_type(v) == LEPT_ARRAY ? lept_get_array_size(v) : lept_get_object_size(v);
+}
+
+//数组/对象数据块的长度：节点或成员数组，对象的排序下标，然后是直接子节点的字符串和key
+static uint64_t lept_snap_block_size(const lept_value* v)
+{
+	const lept_value* e;
+	size_t i, n = lept_snap_count(v);
+	uint64_t size;
+	if (lept_get_type(v) == LEPT_ARRAY)
+	{
+		size = n * sizeof(lept_snap_node);
+		if (lept_get_array_doubles(v, NULL) != NULL)	//紧凑数字数组没有字符串
+			return LEPT_SNAP_ALIGN(size);
+		for (i = 0; i < n; i++)
+			if (lept_get_type(e = lept_get_array_element(v, i)) == LEPT_STRING)
+				size += lept_get_string_length(e) + 1;
+	}
+	else
+	{
+		size = n * sizeof(lept_snap_member) + (n >= LEPT_SNAPSHOT_INDEX_MIN ? n * sizeof(uint64_t) : 0);
+		for (i = 0; i < n; i++)
+		{
+			size += lept_get_object_key_length(v, i) + 1;
+			if (lept_get_type(e = lept_get_object_value(v, i)) == LEPT_STRING)
+				size += lept_get_string_length(e) + 1;
+		}
+	}
+	return LEPT_SNAP_ALIGN(size);
+}
+
+static void lept_snap_put(lept_snap_writer* w, const void* data, size_t len)
+{
+	if (len > 0 && fwrite(data, 1, len, w->fp) != len)
+		w->error = 1;
+	w->pos += len;
+}
+
+static void lept_snap_pad(lept_snap_writer* w)
+{
+	static const char zeros[8] = { 0 };
+	lept_snap_put(w, zeros, (size_t)(LEPT_SNAP_ALIGN(w->pos) - w->pos));
+}
+
+//填写位于at的节点。字符串放在*str处并后移*str；非空数组/对象分配下一个数据块并排队
+static void lept_snap_fill(lept_snap_writer* w, lept_snap_node* n, uint64_t at, const lept_value* v, uint64_t* str)
+{
+	lept_type type = lept_get_type(v);
+	size_t size = 0;
+	double d;
+	n->data = 0;
+	switch (type)
+	{
+	case LEPT_NUMBER:
+		d = lept_get_number(v);
+		memcpy(&n->data, &d, sizeof(d));
+		break;
+	case LEPT_STRING:
+		size = lept_get_string_length(v);
+		n->data = *str - at;
+		*str += size + 1;
+		break;
+	case LEPT_ARRAY:
+	case LEPT_OBJECT:
+		if ((size = lept_snap_count(v)) == 0)
+			break;
+		n->data = w->next - at;
+		w->next += lept_snap_block_size(v);
+		if (w->count == w->capacity)
+		{
+			w->capacity = w->capacity == 0 ? 64 : w->capacity * 2;
+			w->queue = (const lept_value**)realloc(w->queue, w->capacity * sizeof(const lept_value*));
+		}
+		w->queue[w->count++] = v;
+		break;
+	default:
+		break;
+	}
+	n->tag = (uint64_t)size << 3 | (uint64_t)type;
+}
+
+static void lept_snap_put_string(lept_snap_writer* w, const lept_value* v)
+{
+	if (lept_get_type(v) == LEPT_STRING)
+		lept_snap_put(w, lept_get_string(v), lept_get_string_length(v) + 1);
+}
+
+typedef struct
+{
+	const char* k;
+	size_t klen, index;
+} lept_snap_key;
+
+static int lept_snap_key_compare(const void* a, const void* b)
+{
+	const lept_snap_key* x = (const lept_snap_key*)a, * y = (const lept_snap_key*)b;
+	int c = memcmp(x->k, y->k, x->klen < y->klen ? x->klen : y->klen);
+	if (c != 0)
+		return c;
+	if (x->klen != y->klen)
+		return x->klen < y->klen ? -1 : 1;
+	return x->index < y->index ? -1 : x->index > y->index;	//重复的key按原顺序，查找时返回第一个
+}
+
+//写出数组/对象的数据块，位置就是分配时的 w->next
+static void lept_snap_write_block(lept_snap_writer* w, const lept_value* v)
+{
+	lept_value tmp;
+	size_t i, n = lept_snap_count(v);
+	uint64_t at = w->pos, str;
+	if (lept_get_type(v) == LEPT_ARRAY)
+	{
+		lept_snap_node node;
+		str = at + n * sizeof(lept_snap_node);
+		for (i = 0; i < n; i++)
+		{
+			lept_snap_fill(w, &node, at + i * sizeof(node), lept_snap_child(v, i, &tmp), &str);
+			lept_snap_put(w, &node, sizeof(node));
+		}
+		if (lept_get_array_doubles(v, NULL) == NULL)
+			for (i = 0; i < n; i++)
+				lept_snap_put_string(w, lept_get_array_element(v, i));
+	}
+	else
+	{
+		lept_snap_member m;
+		lept_snap_key* keys = NULL;
+		str = at + n * sizeof(lept_snap_member) + (n >= LEPT_SNAPSHOT_INDEX_MIN ? n * sizeof(uint64_t) : 0);
+		for (i = 0; i < n; i++)
+		{
+			uint64_t member_at = at + i * sizeof(m);
+			m.key = str - member_at;
+			m.klen = lept_get_object_key_length(v, i);
+			str += m.klen + 1;
+			lept_snap_fill(w, &m.v, member_at + offsetof(lept_snap_member, v), lept_get_object_value(v, i), &str);
+			lept_snap_put(w, &m, sizeof(m));
+		}
+		if (n >= LEPT_SNAPSHOT_INDEX_MIN)
+		{
+			keys = (lept_snap_key*)malloc(n * sizeof(lept_snap_key));
+			for (i = 0; i < n; i++)
+			{
+				keys[i].k = lept_get_object_key(v, i);
+				keys[i].klen = lept_get_object_key_length(v, i);
+				keys[i].index = i;
+			}
+			qsort(keys, n, sizeof(lept_snap_key), lept_snap_key_compare);
+			for (i = 0; i < n; i++)
+			{
+				uint64_t index = keys[i].index;
+				lept_snap_put(w, &index, sizeof(index));
+			}
+			free(keys);
+		}
+		for (i = 0; i < n; i++)
+		{
+			lept_snap_put(w, lept_get_object_key(v, i), lept_get_object_key_length(v, i) + 1);
+			lept_snap_put_string(w, lept_get_object_value(v, i));
+		}
+	}
+	lept_snap_pad(w);
+	assert(w->error || w->pos == LEPT_SNAP_ALIGN(str));
+}
+
+//写出快照：先写到 path.tmp 再改名，已经映射旧文件的进程不受影响
+int lept_snapshot_write(const lept_value* v, const char* path)
+{
+	lept_snap_writer w;
+	lept_snapshot_header h;
+	uint64_t str = sizeof(h);
+	size_t len = strlen(path);
+	char* tmp = (char*)malloc(len + 5);
+	int ret = LEPT_SNAPSHOT_OK;
+	assert(v != NULL && path != NULL);
+	memcpy(tmp, path, len);
+	memcpy(tmp + len, ".tmp", 5);
+	if ((w.fp = fopen(tmp, "wb")) == NULL)
+	{
+		free(tmp);
+		return LEPT_SNAPSHOT_IO_ERROR;
+	}
+	w.pos = 0;
+	w.queue = NULL;
+	w.head = w.count = w.capacity = 0;
+	w.error = 0;
+	//根是字符串时放在文件头之后，根的数据块从其后开始
+	w.next = LEPT_SNAP_ALIGN(sizeof(h) + (lept_get_type(v) == LEPT_STRING ? lept_get_string_length(v) + 1 : 0));
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, LEPT_SNAPSHOT_MAGIC, sizeof(h.magic));
+	h.version = LEPT_SNAPSHOT_VERSION;
+	h.bom = LEPT_SNAPSHOT_BOM;
+	lept_snap_fill(&w, &h.root, offsetof(lept_snapshot_header, root), v, &str);
+	lept_snap_put(&w, &h, sizeof(h));	//文件总长度最后回填
+	lept_snap_put_string(&w, v);
+	lept_snap_pad(&w);
+	for (; w.head < w.count; w.head++)		//写出过程中队列会继续增长
+		lept_snap_write_block(&w, w.queue[w.head]);
+	assert(w.error || w.pos == w.next);
+	h.size = w.pos;
+	if (!w.error && (fseek(w.fp, 0, SEEK_SET) != 0 || fwrite(&h, sizeof(h), 1, w.fp) != 1))
+		w.error = 1;
+	if (fclose(w.fp) != 0)
+		w.error = 1;
+	free(w.queue);
+#ifdef _WIN32
+	if (!w.error)
+		remove(path);	//Windows的rename不覆盖已有文件
+#endif
+	if (w.error || rename(tmp, path) != 0)
+	{
+		remove(tmp);
+		ret = LEPT_SNAPSHOT_IO_ERROR;
+	}
+	free(tmp);
+	return ret;
+}
+
+//映射快照文件并检查文件头，不逐个检查节点：文件应由 lept_snapshot_write 生成
+int lept_snapshot_open(lept_snapshot** snap, const char* path)
+{
+	lept_snapshot* s;
+	const lept_snapshot_header* h;
+	assert(snap != NULL && path != NULL);
+	*snap = NULL;
+	s = (lept_snapshot*)malloc(sizeof(lept_snapshot));
+#ifdef _WIN32
+	{
+		LARGE_INTEGER size;
+		s->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (s->file == INVALID_HANDLE_VALUE)
+		{
+			free(s);
+			return LEPT_SNAPSHOT_IO_ERROR;
+		}
+		if (!GetFileSizeEx(s->file, &size) || size.QuadPart < (LONGLONG)sizeof(lept_snapshot_header) ||
+			(s->mapping = CreateFileMappingA(s->file, NULL, PAGE_READONLY, 0, 0, NULL)) == NULL)
+		{
+			CloseHandle(s->file);
+			free(s);
+			return LEPT_SNAPSHOT_INVALID;
+		}
+		s->size = (size_t)size.QuadPart;
+		if ((s->base = (const char*)MapViewOfFile(s->mapping, FILE_MAP_READ, 0, 0, 0)) == NULL)
+		{
+			CloseHandle(s->mapping);
+			CloseHandle(s->file);
+			free(s);
+			return LEPT_SNAPSHOT_IO_ERROR;
+		}
+	}
+#else
+	{
+		struct stat st;
+		void* p;
+		int fd = open(path, O_RDONLY);
+		if (fd < 0 || fstat(fd, &st) != 0)
+		{
+			if (fd >= 0)
+				close(fd);
+			free(s);
+			return LEPT_SNAPSHOT_IO_ERROR;
+		}
+		if ((size_t)st.st_size < sizeof(lept_snapshot_header))
+		{
+			close(fd);
+			free(s);
+			return LEPT_SNAPSHOT_INVALID;
+		}
+		//MAP_SHARED：只读映射与其他进程共用页缓存，按需调入
+		p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if (p == MAP_FAILED)
+		{
+			free(s);
+			return LEPT_SNAPSHOT_IO_ERROR;
+		}
+		s->base = (const char*)p;
+		s->size = (size_t)st.st_size;
+	}
+#endif
+	h = (const lept_snapshot_header*)s->base;
+	if (memcmp(h->magic, LEPT_SNAPSHOT_MAGIC, sizeof(h->magic)) != 0 || h->version != LEPT_SNAPSHOT_VERSION ||
+		h->bom != LEPT_SNAPSHOT_BOM || h->size != s->size)
+	{
+		lept_snapshot_close(s);
+		return LEPT_SNAPSHOT_INVALID;
+	}
+	*snap = s;
+	return LEPT_SNAPSHOT_OK;
+}
+
+//解除映射。之前取得的节点指针全部失效
+void lept_snapshot_close(lept_snapshot* snap)
+{
+	if (snap == NULL)
+		return;
+#ifdef _WIN32
+	UnmapViewOfFile(snap->base);
+	CloseHandle(snap->mapping);
+	CloseHandle(snap->file);
+#else
+	munmap((void*)snap->base, snap->size);
+#endif
+	free(snap);
+}
+
+const lept_snap_node* lept_snapshot_root(const lept_snapshot* snap)
+{
+	assert(snap != NULL);
+	return &((const lept_snapshot_header*)snap->base)->root;
+}
+
+lept_type lept_snap_get_type(const lept_snap_node* n)
+{
+	assert(n != NULL);
+	return LEPT_SNAP_TYPE(n);
+}
+
+int lept_snap_get_boolean(const lept_snap_node* n)
+{
+	assert(n != NULL && (LEPT_SNAP_TYPE(n) == LEPT_TRUE || LEPT_SNAP_TYPE(n) == LEPT_FALSE));
+	return LEPT_SNAP_TYPE(n) == LEPT_TRUE;
+}
+
+double lept_snap_get_number(const lept_snap_node* n)
+{
+	double d;
+	assert(n != NULL && LEPT_SNAP_TYPE(n) == LEPT_NUMBER);
+	memcpy(&d, &n->data, sizeof(d));
+	return d;
+}
+
+const char* lept_snap_get_string(const lept_snap_node* n)
+{
+	assert(n != NULL && LEPT_SNAP_TYPE(n) == LEPT_STRING);
+	return LEPT_SNAP_DATA(n);
+}
+
+size_t lept_snap_get_string_length(const lept_snap_node* n)
+{
+	assert(n != NULL && LEPT_SNAP_TYPE(n) == LEPT_STRING);
+	return LEPT_SNAP_SIZE(n);
+}
+
+size_t lept_snap_get_array_size(const lept_snap_node* n)
+{
+	assert(n != NULL && LEPT_SNAP_TYPE(n) == LEPT_ARRAY);
+	return LEPT_SNAP_SIZE(n);
+}
+
+const lept_snap_node* lept_snap_get_array_element(const lept_snap_node* n, size_t index)
+{
+	assert(n != NULL && LEPT_SNAP_TYPE(n) == LEPT_ARRAY && index < LEPT_SNAP_SIZE(n));
+	return (const lept_snap_node*)LEPT_SNAP_DATA(n) + index;
+}
+
+size_t lept_snap_get_object_size(const lept_snap_node* n)
+{
+	assert(n != NULL && LEPT_SNAP_TYPE(n) == LEPT_OBJECT);
+	return LEPT_SNAP_SIZE(n);
+}
+
+static const lept_snap_member* lept_snap_member_at(const lept_snap_node* n, size_t index)
+{
+	assert(n != NULL && LEPT_SNAP_TYPE(n) == LEPT_OBJECT && index < LEPT_SNAP_SIZE(n));
+	return (const lept_snap_member*)LEPT_SNAP_DATA(n) + index;
+}
+
+const char* lept_snap_get_object_key(const lept_snap_node* n, size_t index)
+{
+	const lept_snap_member* m = lept_snap_member_at(n, index);
+	return (const char*)m + m->key;
+}
+
+size_t lept_snap_get_object_key_length(const lept_snap_node* n, size_t index)
+{
+	return (size_t)lept_snap_member_at(n, index)->klen;
+}
+
+const lept_snap_node* lept_snap_get_object_value(const lept_snap_node* n, size_t index)
+{
+	return &lept_snap_member_at(n, index)->v;
+}
+
+//按key查找成员的值，找不到时返回NULL。成员较多时在排序下标上二分，key重复时返回第一个
+const lept_snap_node* lept_snap_find_object_value(const lept_snap_node* n, const char* key, size_t klen)
+{
+	const lept_snap_member* m;
+	const uint64_t* index;
+	size_t i, lo = 0, hi, size;
+	assert(n != NULL && LEPT_SNAP_TYPE(n) == LEPT_OBJECT && key != NULL);
+	size = hi = LEPT_SNAP_SIZE(n);
+	m = (const lept_snap_member*)LEPT_SNAP_DATA(n);
+	if (size < LEPT_SNAPSHOT_INDEX_MIN)
+	{
+		for (i = 0; i < size; i++)
+			if (m[i].klen == klen && memcmp((const char*)&m[i] + m[i].key, key, klen) == 0)
+				return &m[i].v;
+		return NULL;
+	}
+	index = (const uint64_t*)(m + size);
+	while (lo < hi)		//第一个不小于key的位置
+	{
+		size_t mid = lo + (hi - lo) / 2;
+		const lept_snap_member* e = &m[index[mid]];
+		int c = memcmp((const char*)e + e->key, key, e->klen < klen ? (size_t)e->klen : klen);
+		if (c < 0 || (c == 0 && e->klen < klen))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo < size && m[index[lo]].klen == klen && memcmp((const char*)&m[index[lo]] + m[index[lo]].key, key, klen) == 0)
+		return &m[index[lo]].v;
+	return NULL;
+}
+
+//把快照中的子树复制为普通节点树，之后可以修改或使用 lept_stringify 等接口
+void lept_snap_copy(lept_value* dst, const lept_snap_node* n)
+{
+	size_t i, size;
+	assert(dst != NULL && n != NULL);
+	size = LEPT_SNAP_SIZE(n);
+	switch (LEPT_SNAP_TYPE(n))
+	{
+	case LEPT_NULL:		lept_set_null(dst); break;
+	case LEPT_FALSE:	lept_set_boolean(dst, 0); break;
+	case LEPT_TRUE:		lept_set_boolean(dst, 1); break;
+	case LEPT_NUMBER:	lept_set_number(dst, lept_snap_get_number(n)); break;
+	case LEPT_STRING:	lept_set_string(dst, LEPT_SNAP_DATA(n), size); break;
+	case LEPT_ARRAY:
+		lept_set_array(dst, size);
+		for (i = 0; i < size; i++)
+			lept_snap_copy(lept_pushback_array_element(dst), (const lept_snap_node*)LEPT_SNAP_DATA(n) + i);
+		break;
+	case LEPT_OBJECT:
+		lept_set_object(dst, size);
+		for (i = 0; i < size; i++)
+			lept_snap_copy(lept_set_object_value(dst, lept_snap_get_object_key(n, i), lept_snap_get_object_key_length(n, i)),
+				lept_snap_get_object_value(n, i));
+		break;
+	default: assert(0 && "invalid type");
+	}
+}
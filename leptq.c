@@ -0,0 +1,449 @@
+//leptq：NDJSON日志的流式过滤工具。每行只为表达式用到的路径建立节点（lept_parse_select），其余部分跳过；
+//读取文件时用 lept_ingest_files 在多个线程中解析，从标准输入读取时单线程处理。结束时在stderr输出吞吐量
+//用法：leptq [-w 线程数] [-o] [-c] [-q] [-S] 表达式 [文件...]
+//  -w 解析线程数，默认为在线CPU数；-c 只输出匹配的行数；-q 不输出吞吐量；-S 跳过的部分也完整校验
+//  -o 按输入顺序输出：只用一个解析线程，读取仍与解析重叠
+//  多个解析线程时各线程的输出分批写出，不同缓冲区中的行不保持输入顺序；读取标准输入时总是按输入顺序
+//  没有文件或文件为 - 时读取标准输入
+//      leptq --gen 文件 MB数        生成用于测试的日志
+//表达式：条件 [| 投影]
+//  条件：用 and 连接的若干项，每项为 路径 [运算符 JSON值]。只有路径时表示该路径存在；运算符为 == != < <= > >=，
+//        ==、!= 按 lept_is_equal 比较，大小比较只在两边同为数字或同为字符串（按字节）时成立
+//  投影：用逗号分隔的路径，一个时输出该值，多个时输出数组，不存在的路径输出null；没有投影时原样输出整行
+//  路径为JSON Pointer，不能含空白和 =!<>|, 字符；条件为空时所有能解析的行都匹配
+//例：leptq '/level == "error" and /ms >= 250 | /ts, /req/path' app.log
+#define _POSIX_C_SOURCE 200809L
+
+#include "leptjson.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+//每个解析线程的输出缓冲区超过这个大小时加锁写出
+#define LEPTQ_FLUSH_SIZE (64 * 1024)
+
+enum { LEPTQ_EXISTS, LEPTQ_EQ, LEPTQ_NE, LEPTQ_LT, LEPTQ_LE, LEPTQ_GT, LEPTQ_GE };
+
+//条件中的一项
+typedef struct
+{
+	size_t path;			//paths中的下标
+	int op;					//LEPTQ_*
+	lept_value literal;		//比较的值，LEPTQ_EXISTS 时不使用
+}leptq_term;
+
+//编译后的表达式
+typedef struct
+{
+	char** paths;			//条件和投影用到的路径，去重后传给 lept_parse_select
+	size_t path_count;
+	leptq_term* terms;
+	size_t term_count;
+	size_t* proj;			//投影的路径在paths中的下标
+	size_t proj_count;
+}leptq_query;
+
+//每个解析线程的输出和计数，只由该线程修改
+typedef struct
+{
+	char* s;
+	size_t len, cap;
+	size_t matched;
+}leptq_output;
+
+typedef struct
+{
+	const leptq_query* q;
+	leptq_output* out;
+	int count_only;
+	pthread_mutex_t lock;	//保护stdout
+}leptq_run;
+
+static const char* leptq_skip_space(const char* p)
+{
+	while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+		p++;
+	return p;
+}
+
+static int leptq_path_char(char ch)
+{
+	return ch != '\0' && strchr(" \t\n\r=!<>|,", ch) == NULL;
+}
+
+//读取一个路径，返回它在paths中的下标，相同的路径只保存一次
+static size_t leptq_intern_path(leptq_query* q, const char* p, size_t len)
+{
+	size_t i;
+	for (i = 0; i < q->path_count; i++)
+		if (strlen(q->paths[i]) == len && memcmp(q->paths[i], p, len) == 0)
+			return i;
+	q->paths = (char**)realloc(q->paths, (q->path_count + 1) * sizeof(char*));
+	memcpy(q->paths[q->path_count] = (char*)malloc(len + 1), p, len);
+	q->paths[q->path_count][len] = '\0';
+	return q->path_count++;
+}
+
+static const char* leptq_parse_path(leptq_query* q, const char* p, size_t* index)
+{
+	const char* begin = p;
+	if (*p != '/')
+		return NULL;
+	while (leptq_path_char(*p))
+		p++;
+	*index = leptq_intern_path(q, begin, (size_t)(p - begin));
+	return p;
+}
+
+//比较运算符，不是运算符时返回LEPTQ_EXISTS
+static const char* leptq_parse_op(const char* p, int* op)
+{
+	static const struct { const char* s; int op; } ops[] = {
+		{ "==", LEPTQ_EQ }, { "!=", LEPTQ_NE }, { "<=", LEPTQ_LE }, { ">=", LEPTQ_GE }, { "<", LEPTQ_LT }, { ">", LEPTQ_GT }
+	};
+	size_t i, len;
+	for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++)
+		if (strncmp(p, ops[i].s, len = strlen(ops[i].s)) == 0)
+		{
+			*op = ops[i].op;
+			return p + len;
+		}
+	*op = LEPTQ_EXISTS;
+	return p;
+}
+
+//比较的值用库的 lept_skip_value 找出范围，再用 lept_parse 解析
+static const char* leptq_parse_literal(const char* p, lept_value* v)
+{
+	size_t consumed;
+	char* text;
+	int ret;
+	if (lept_skip_value(p, strlen(p), &consumed) != LEPT_PARSE_OK)
+		return NULL;
+	memcpy(text = (char*)malloc(consumed + 1), p, consumed);
+	text[consumed] = '\0';
+	lept_init(v);
+	ret = lept_parse(v, text);
+	free(text);
+	return ret == LEPT_PARSE_OK ? p + consumed : NULL;
+}
+
+static void leptq_free(leptq_query* q)
+{
+	size_t i;
+	for (i = 0; i < q->term_count; i++)
+		lept_free(&q->terms[i].literal);
+	for (i = 0; i < q->path_count; i++)
+		free(q->paths[i]);
+	free(q->paths);
+	free(q->terms);
+	free(q->proj);
+	memset(q, 0, sizeof(leptq_query));
+}
+
+//编译表达式，出错时返回出错的位置，成功时返回NULL
+static const char* leptq_compile(leptq_query* q, const char* expr)
+{
+	const char* p = leptq_skip_space(expr), * next;
+	leptq_term* t;
+	memset(q, 0, sizeof(leptq_query));
+	while (*p != '\0' && *p != '|')
+	{
+		if (q->term_count > 0)
+		{
+			if (strncmp(p, "and", 3) != 0 || leptq_path_char(p[3]))
+				return p;
+			p = leptq_skip_space(p + 3);
+		}
+		q->terms = (leptq_term*)realloc(q->terms, (q->term_count + 1) * sizeof(leptq_term));
+		t = &q->terms[q->term_count];
+		lept_init(&t->literal);
+		if ((next = leptq_parse_path(q, p, &t->path)) == NULL)
+			return p;
+		p = leptq_parse_op(leptq_skip_space(next), &t->op);
+		q->term_count++;
+		if (t->op != LEPTQ_EXISTS && (p = leptq_parse_literal(leptq_skip_space(p), &t->literal)) == NULL)
+			return next;
+		p = leptq_skip_space(p);
+	}
+	if (*p == '|')
+	{
+		do
+		{
+			q->proj = (size_t*)realloc(q->proj, (q->proj_count + 1) * sizeof(size_t));
+			p = leptq_skip_space(p + 1);
+			if ((next = leptq_parse_path(q, p, &q->proj[q->proj_count])) == NULL)
+				return p;
+			q->proj_count++;
+			p = leptq_skip_space(next);
+		} while (*p == ',');
+		if (*p != '\0')
+			return p;
+	}
+	return NULL;
+}
+
+//大小比较只在同为数字或同为字符串时成立
+static int leptq_compare(const lept_value* v, int op, const lept_value* literal)
+{
+	int cmp;
+	size_t len;
+	if (op == LEPTQ_EQ || op == LEPTQ_NE)
+		return lept_is_equal(v, literal) == (op == LEPTQ_EQ);
+	if (lept_get_type(v) == LEPT_NUMBER && lept_get_type(literal) == LEPT_NUMBER)
+		cmp = lept_get_number(v) < lept_get_number(literal) ? -1 : lept_get_number(v) > lept_get_number(literal);
+	else if (lept_get_type(v) == LEPT_STRING && lept_get_type(literal) == LEPT_STRING)
+	{
+		len = lept_get_string_length(v) < lept_get_string_length(literal) ? lept_get_string_length(v) : lept_get_string_length(literal);
+		if ((cmp = memcmp(lept_get_string(v), lept_get_string(literal), len)) == 0)
+			cmp = lept_get_string_length(v) < lept_get_string_length(literal) ? -1 : lept_get_string_length(v) > lept_get_string_length(literal);
+	}
+	else
+		return 0;
+	switch (op)
+	{
+	case LEPTQ_LT: return cmp < 0;
+	case LEPTQ_LE: return cmp <= 0;
+	case LEPTQ_GT: return cmp > 0;
+	default: return cmp >= 0;
+	}
+}
+
+static const lept_value* leptq_find(const leptq_query* q, const lept_value* v, size_t path)
+{
+	return lept_find_pointer(v, q->paths[path], strlen(q->paths[path]));
+}
+
+static int leptq_match(const leptq_query* q, const lept_value* v)
+{
+	const lept_value* found;
+	size_t i;
+	for (i = 0; i < q->term_count; i++)
+		if ((found = leptq_find(q, v, q->terms[i].path)) == NULL ||
+			(q->terms[i].op != LEPTQ_EXISTS && !leptq_compare(found, q->terms[i].op, &q->terms[i].literal)))
+			return 0;
+	return 1;
+}
+
+static void leptq_put(leptq_output* out, const char* s, size_t len)
+{
+	if (out->len + len > out->cap)
+	{
+		while (out->len + len > out->cap)
+			out->cap = out->cap == 0 ? LEPTQ_FLUSH_SIZE : out->cap * 2;
+		out->s = (char*)realloc(out->s, out->cap);
+	}
+	memcpy(out->s + out->len, s, len);
+	out->len += len;
+}
+
+static void leptq_flush(leptq_run* r, leptq_output* out)
+{
+	if (out->len == 0)
+		return;
+	pthread_mutex_lock(&r->lock);
+	fwrite(out->s, 1, out->len, stdout);
+	pthread_mutex_unlock(&r->lock);
+	out->len = 0;
+}
+
+//输出匹配的一行：投影的值，或者原样输出整行
+static void leptq_emit(leptq_run* r, leptq_output* out, const lept_value* v, const char* line, size_t len)
+{
+	const lept_value* found;
+	char* json;
+	size_t i, n;
+	if (!leptq_match(r->q, v))
+		return;
+	out->matched++;
+	if (r->count_only)
+		return;
+	if (r->q->proj_count == 0)
+		leptq_put(out, line, len);
+	else
+	{
+		if (r->q->proj_count > 1)
+			leptq_put(out, "[", 1);
+		for (i = 0; i < r->q->proj_count; i++)
+		{
+			if (i > 0)
+				leptq_put(out, ",", 1);
+			if ((found = leptq_find(r->q, v, r->q->proj[i])) == NULL)
+				leptq_put(out, "null", 4);
+			else
+			{
+				json = lept_stringify(found, &n);
+				leptq_put(out, json, n);
+				free(json);
+			}
+		}
+		if (r->q->proj_count > 1)
+			leptq_put(out, "]", 1);
+	}
+	leptq_put(out, "\n", 1);
+	if (out->len >= LEPTQ_FLUSH_SIZE)
+		leptq_flush(r, out);
+}
+
+static int leptq_ingest_callback(void* user, const lept_ingest_record* rec)
+{
+	leptq_run* r = (leptq_run*)user;
+	if (rec->result == LEPT_PARSE_OK)
+		leptq_emit(r, &r->out[rec->worker], rec->v, rec->line, rec->len);
+	return 0;
+}
+
+//从标准输入逐行读取，单线程
+static void leptq_read_stdin(leptq_run* r, int parse_flags, lept_ingest_stats* stats)
+{
+	const leptq_query* q = r->q;
+	lept_value v;
+	char* line = NULL, * p;
+	size_t cap = 0;
+	ssize_t len;
+	while ((len = getline(&line, &cap, stdin)) > 0)
+	{
+		stats->bytes += (size_t)len;
+		if (line[len - 1] == '\n')
+			line[--len] = '\0';
+		for (p = line; *p == ' ' || *p == '\t' || *p == '\r'; p++)
+			;
+		if (*p == '\0')		//与 lept_ingest_files 一样跳过空行
+			continue;
+		stats->lines++;
+		if (lept_parse_select(&v, line, (const char* const*)q->paths, q->path_count, parse_flags) != LEPT_PARSE_OK)
+			stats->errors++;
+		else
+		{
+			leptq_emit(r, &r->out[0], &v, line, (size_t)len);
+			lept_free(&v);
+		}
+	}
+	free(line);
+}
+
+//生成用于测试的日志：每行一个请求记录，带有过滤时需要跳过的嵌套部分
+static int leptq_generate(const char* path, double mb)
+{
+	static const char* levels[] = { "debug", "info", "info", "info", "warn", "error" };
+	static const char* methods[] = { "GET", "GET", "POST", "PUT", "DELETE" };
+	unsigned seed = 12345;
+	double limit = mb * 1024 * 1024, size = 0;
+	long i;
+	FILE* fp;
+	if ((fp = fopen(path, "w")) == NULL)
+		return 1;
+	for (i = 0; size < limit; i++)
+	{
+#define LEPTQ_RAND() (seed = seed * 1103515245u + 12345u, (seed >> 16) & 0x7fff)
+		unsigned level = LEPTQ_RAND() % 6, method = LEPTQ_RAND() % 5, ms = LEPTQ_RAND() % 1000, id = LEPTQ_RAND();
+		size += fprintf(fp,
+			"{\"ts\":%lld,\"level\":\"%s\",\"ms\":%u,"
+			"\"req\":{\"method\":\"%s\",\"path\":\"/api/v1/items/%u\",\"status\":%d,"
+			"\"headers\":{\"user-agent\":\"Mozilla/5.0 (X11; Linux x86_64)\",\"accept\":\"application/json\",\"x-request-id\":\"%08x-%04x\"}},"
+			"\"tags\":[\"svc-%u\",\"zone-%c\",%u,%s],\"msg\":\"request \\\"%u\\\" finished in %u ms\"}\n",
+			1700000000000LL + i * 7, levels[level], ms, methods[method], id % 5000, level == 5 ? 500 : 200,
+			id, ms, id % 16, 'a' + (int)(id % 3), ms * 3, level ? "true" : "null", id, ms);
+#undef LEPTQ_RAND
+	}
+	fclose(fp);
+	return 0;
+}
+
+static double leptq_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+//表达式没有用到路径时也只做选择性解析，不建树
+static const char* const leptq_no_paths[1] = { "" };
+
+static int leptq_usage(const char* name)
+{
+	fprintf(stderr, "usage: %s [-w workers] [-o] [-c] [-q] [-S] expression [file...]\n"
+		"       %s --gen file MB\n", name, name);
+	return 2;
+}
+
+int main(int argc, char* argv[])
+{
+	lept_ingest_options opt;
+	lept_ingest_stats stats;
+	leptq_query q;
+	leptq_run r;
+	const char* err;
+	double start, seconds;
+	size_t matched = 0;
+	int i, quiet = 0, ordered = 0, ret = LEPT_INGEST_OK, workers = 0, parse_flags = LEPT_FLAG_FAST_SKIP;
+
+	if (argc == 4 && strcmp(argv[1], "--gen") == 0)
+		return leptq_generate(argv[2], atof(argv[3]));
+	memset(&r, 0, sizeof(r));
+	for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++)
+	{
+		if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) workers = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-o") == 0) ordered = 1;
+		else if (strcmp(argv[i], "-c") == 0) r.count_only = 1;
+		else if (strcmp(argv[i], "-q") == 0) quiet = 1;
+		else if (strcmp(argv[i], "-S") == 0) parse_flags = 0;
+		else return leptq_usage(argv[0]);
+	}
+	if (i == argc)
+		return leptq_usage(argv[0]);
+	if ((err = leptq_compile(&q, argv[i])) != NULL)
+	{
+		fprintf(stderr, "leptq: syntax error at column %d: %s\n", (int)(err - argv[i]) + 1, argv[i]);
+		leptq_free(&q);
+		return 2;
+	}
+	i++;
+	if (ordered)
+		workers = 1;		//一个解析线程按分发的顺序处理缓冲区，输出即输入顺序
+	else if (workers <= 0 && (workers = (int)sysconf(_SC_NPROCESSORS_ONLN)) <= 0)
+		workers = 1;
+	r.q = &q;
+	r.out = (leptq_output*)calloc((size_t)workers, sizeof(leptq_output));
+	pthread_mutex_init(&r.lock, NULL);
+	memset(&stats, 0, sizeof(stats));
+
+	start = leptq_now();
+	if (i == argc || (i + 1 == argc && strcmp(argv[i], "-") == 0))
+	{
+		workers = 1;
+		leptq_read_stdin(&r, parse_flags, &stats);
+	}
+	else
+	{
+		memset(&opt, 0, sizeof(opt));
+		opt.workers = workers;
+		opt.parse_flags = parse_flags;
+		opt.select = q.path_count > 0 ? (const char* const*)q.paths : leptq_no_paths;
+		opt.select_count = q.path_count;
+		if ((ret = lept_ingest_files((const char* const*)argv + i, (size_t)(argc - i), &opt, leptq_ingest_callback, &r, &stats)) != LEPT_INGEST_OK)
+			fprintf(stderr, "leptq: cannot read input\n");
+	}
+	for (i = 0; i < workers; i++)
+	{
+		leptq_flush(&r, &r.out[i]);
+		matched += r.out[i].matched;
+		free(r.out[i].s);
+	}
+	seconds = leptq_now() - start;
+	if (r.count_only)
+		printf("%lu\n", (unsigned long)matched);
+	fflush(stdout);
+	if (!quiet)
+		fprintf(stderr, "leptq: %.1f MB, %lu lines (%lu errors), %lu matched in %.3f s, %.1f MB/s, %d thread%s%s\n",
+			stats.bytes / (1024.0 * 1024.0), (unsigned long)stats.lines, (unsigned long)stats.errors, (unsigned long)matched,
+			seconds, seconds > 0 ? stats.bytes / (1024.0 * 1024.0) / seconds : 0.0, workers, workers > 1 ? "s" : "",
+			stats.io_uring ? ", io_uring" : "");
+	pthread_mutex_destroy(&r.lock);
+	free(r.out);
+	leptq_free(&q);
+	return ret != LEPT_INGEST_OK ? 2 : matched > 0 ? 0 : 1;
+}
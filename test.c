@@ -255,6 +255,7 @@ static void test_parse_object()
         v.type = LEPT_FALSE;\
         EXPECT_EQ_INT(error, lept_parse(&v, json));\
         EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));\
+        EXPECT_EQ_INT(error, lept_validate(json, strlen(json), NULL));\
         lept_free(&v);\
     } while(0)
 
@@ -346,6 +347,49 @@ static void test_parse_invalid_unicode_surrogate() {
     TEST_ERROR(LEPT_PARSE_INVALID_UNICODE_SURROGATE, "\"\\uD800\\uE000\"");
 }
 
+//ϸUTF-8УʱĽʧ
+#define TEST_UTF8_ERROR(json)\
+    do {\
+        lept_value v;\
+        lept_init(&v);\
+        EXPECT_EQ_INT(LEPT_PARSE_INVALID_UTF8, lept_parse_ex(&v, json, LEPT_FLAG_VALIDATE_UTF8));\
+        EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));\
+        EXPECT_EQ_INT(LEPT_PARSE_INVALID_UTF8, lept_parse_ex(&v, json, LEPT_FLAG_LAZY | LEPT_FLAG_VALIDATE_UTF8));\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));\
+        lept_free(&v);\
+    } while(0)
+
+//ַгֲϷUTF-8ֽ
+static void test_parse_invalid_utf8() {
+    lept_value v;
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_ex(&v, "[\"\xC2\xA2\xE2\x82\xAC\xF0\x9D\x84\x9E\xED\x9F\xBF\xF4\x8F\xBF\xBF\"]", LEPT_FLAG_VALIDATE_UTF8));
+    EXPECT_EQ_STRING("\xC2\xA2\xE2\x82\xAC\xF0\x9D\x84\x9E\xED\x9F\xBF\xF4\x8F\xBF\xBF", lept_get_string(lept_get_array_element(&v, 0)), lept_get_string_length(lept_get_array_element(&v, 0)));
+    lept_free(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_ex(&v, "{\"\xE4\xBD\xA0\xE5\xA5\xBD, 0123456789abcdef\":\"\\u00A2\xC2\xA2\"}", LEPT_FLAG_VALIDATE_UTF8));
+    lept_free(&v);
+    //ֽп16ֽڵĿ߽
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_ex(&v, "\"0123456789abcd\xE2\x82\xAC" "0123456789abcdef\"", LEPT_FLAG_LAZY | LEPT_FLAG_VALIDATE_UTF8));
+    EXPECT_EQ_STRING("0123456789abcd\xE2\x82\xAC" "0123456789abcdef", lept_get_string(&v), lept_get_string_length(&v));
+    lept_free(&v);
+
+    TEST_UTF8_ERROR("\"\x80\"");                 //ĺֽ
+    TEST_UTF8_ERROR("\"\xC0\xAF\"");             //
+    TEST_UTF8_ERROR("\"\xC1\xBF\"");
+    TEST_UTF8_ERROR("\"\xE0\x9F\xBF\"");
+    TEST_UTF8_ERROR("\"\xF0\x8F\xBF\xBF\"");
+    TEST_UTF8_ERROR("\"\xED\xA0\x80\"");         // U+D800
+    TEST_UTF8_ERROR("\"\xF4\x90\x80\x80\"");     //U+10FFFF
+    TEST_UTF8_ERROR("\"\xF5\x80\x80\x80\"");
+    TEST_UTF8_ERROR("\"\xFF\"");
+    TEST_UTF8_ERROR("\"\xE2\x82\"");             //бض
+    TEST_UTF8_ERROR("\"\xE2\x82\\n\"");
+    TEST_UTF8_ERROR("\"\xC2\x41\"");             //ֽڲϷ
+    TEST_UTF8_ERROR("\"0123456789abcdef0123456789abcdef\xE2\x28\xA1\"");
+    TEST_UTF8_ERROR("\"0123456789abcd\xE2\x82(123456789abcdef\"");
+    TEST_UTF8_ERROR("{\"\xC0\x80\":1}");         //keyͬУ
+}
+
 //ȱٶ,]
 static void test_parse_miss_comma_or_square_bracket() {
     TEST_ERROR(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "[1");
@@ -380,6 +424,575 @@ static void test_parse_miss_comma_or_curly_bracket() {
     TEST_ERROR(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":{}");
 }
 
+#define TEST_SELECT(expect, json, paths, flags)\
+    do{\
+        lept_value v;\
+        char* json2;\
+        size_t length;\
+        lept_init(&v);\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_select(&v, json, paths, sizeof(paths) / sizeof(paths[0]), flags));\
+        json2 = lept_stringify(&v, &length);\
+        EXPECT_EQ_STRING(expect, json2, length);\
+        lept_free(&v);\
+        free(json2);\
+    }while(0)
+
+//ѡԽֻѡе
+static void test_parse_select()
+{
+    static const char json[] = "{\"id\":7,\"user\":{\"name\":\"abc\",\"tags\":[\"x\",\"y\"],\"a/b\":1,\"m~n\":2},\"items\":[{\"p\":1},{\"p\":2,\"q\":[1e10,\"\\u00A2\"]}],\"skip\":[[[{}]]]}";
+    const char* root[] = { "" };
+    const char* id[] = { "/id" };
+    const char* user[] = { "/user/name", "/user/tags/1", "/user/a~1b", "/user/m~0n" };
+    const char* items[] = { "/items/1/p", "/id/deeper", "/missing" };
+    const char* overlap[] = { "/user/name", "/user" };
+    const char* none[] = { "bad" };
+    const char* tilde[] = { "/a~", "/a~2", "/b~1c" };
+    const char* empty[] = { "/", "/e" };
+    lept_value v;
+
+    TEST_SELECT("{\"id\":7,\"user\":{\"name\":\"abc\",\"tags\":[\"x\",\"y\"],\"a/b\":1,\"m~n\":2},\"items\":[{\"p\":1},{\"p\":2,\"q\":[10000000000,\"\xC2\xA2\"]}],\"skip\":[[[{}]]]}", json, root, 0);
+    TEST_SELECT("{\"id\":7,\"user\":{\"name\":\"abc\",\"tags\":[\"x\",\"y\"],\"a/b\":1,\"m~n\":2},\"items\":[{\"p\":1},{\"p\":2,\"q\":[10000000000,\"\xC2\xA2\"]}],\"skip\":[[[{}]]]}", json, root, LEPT_FLAG_FAST_SKIP);
+    TEST_SELECT("{\"id\":7}", json, id, 0);
+    TEST_SELECT("{\"id\":7}", json, id, LEPT_FLAG_FAST_SKIP);
+    TEST_SELECT("{\"user\":{\"name\":\"abc\",\"tags\":[null,\"y\"],\"a/b\":1,\"m~n\":2}}", json, user, 0);
+    TEST_SELECT("{\"user\":{\"name\":\"abc\",\"tags\":[null,\"y\"],\"a/b\":1,\"m~n\":2}}", json, user, LEPT_FLAG_FAST_SKIP);
+    TEST_SELECT("{\"items\":[null,{\"p\":2}]}", json, items, 0);
+    TEST_SELECT("{\"items\":[null,{\"p\":2}]}", json, items, LEPT_FLAG_FAST_SKIP);
+    TEST_SELECT("{\"user\":{\"name\":\"abc\",\"tags\":[\"x\",\"y\"],\"a/b\":1,\"m~n\":2}}", json, overlap, 0);
+    TEST_SELECT("{\"user\":{\"name\":\"abc\",\"tags\":[\"x\",\"y\"],\"a/b\":1,\"m~n\":2}}", json, overlap, LEPT_FLAG_FAST_SKIP);
+    TEST_SELECT("null", "123", none, 0);
+    TEST_SELECT("null", "123", none, LEPT_FLAG_FAST_SKIP);
+    //Ƿ~ת岻ƥκμĩβ~Խ
+    TEST_SELECT("{\"b/c\":3}", "{\"a~\":1,\"a~2\":2,\"b/c\":3}", tilde, 0);
+    TEST_SELECT("{\"b/c\":3}", "{\"a~\":1,\"a~2\":2,\"b/c\":3}", tilde, LEPT_FLAG_FAST_SKIP);
+    //ռն
+    TEST_SELECT("{\"\":{},\"e\":[]}", "{\"\":{},\"e\":[],\"f\":1}", empty, 0);
+
+    //ĲͬҪУ飬lept_parseͬ
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, lept_parse_select(&v, "{\"id\":1,\"x\":[1 2]}", id, 1, 0));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+    EXPECT_EQ_INT(LEPT_PARSE_INVALID_STRING_ESCAPE, lept_parse_select(&v, "{\"id\":1,\"x\":\"\\v\"}", id, 1, 0));
+    EXPECT_EQ_INT(LEPT_PARSE_NUMBER_TOO_BIG, lept_parse_select(&v, "[1e309]", id, 1, 0));
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COLON, lept_parse_select(&v, "{\"id\" 1}", id, 1, 0));
+    EXPECT_EQ_INT(LEPT_PARSE_ROOT_NOT_SINGULAR, lept_parse_select(&v, "{\"id\":1} x", id, 1, 0));
+    EXPECT_EQ_INT(LEPT_PARSE_EXPECT_VALUE, lept_parse_select(&v, " ", id, 1, 0));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+}
+
+#define TEST_SKIP(expect_ret, expect_consumed, json)\
+    do {\
+        size_t consumed;\
+        EXPECT_EQ_INT(expect_ret, lept_skip_value(json, strlen(json), &consumed));\
+        EXPECT_EQ_SIZE_T(expect_consumed, consumed);\
+    } while(0)
+
+//Կһֵ
+static void test_skip_value()
+{
+    TEST_SKIP(LEPT_PARSE_OK, 5, " null , 1");
+    TEST_SKIP(LEPT_PARSE_OK, 6, "-1.5e3]");
+    TEST_SKIP(LEPT_PARSE_OK, 15, "\"ab\\\"c\\\\\\u00A2\" x");
+    TEST_SKIP(LEPT_PARSE_OK, 2, "[]]");
+    TEST_SKIP(LEPT_PARSE_OK, 19, "{\"a\":[1,{\"b\":\"]\"}]} , ");
+    //Խ16ֽڿ飬ַеźתŲӰ
+    TEST_SKIP(LEPT_PARSE_OK, 85, "[[[[1234567890, 1234567890], [1234567890]]], \"[[[ \\\" {{{ 0123456789abcdef\", {\"k\":[]}], 0");
+    TEST_SKIP(LEPT_PARSE_OK, 64, "[\"0123456789abcdef0123456789abcdef\\\\\", \"0123456789abcdef\\\"]\", 1]]]");
+    //ʱconsumedΪλãȱֵʱΪֵĿͷδʱΪĩβ
+    TEST_SKIP(LEPT_PARSE_EXPECT_VALUE, 2, "  ");
+    TEST_SKIP(LEPT_PARSE_INVALID_VALUE, 0, "]");
+    TEST_SKIP(LEPT_PARSE_INVALID_VALUE, 2, " \t}");
+    TEST_SKIP(LEPT_PARSE_MISS_QUOTATION_MARK, 6, "\"abc\\\"");
+    TEST_SKIP(LEPT_PARSE_MISS_QUOTATION_MARK, 49, "[\"0123456789abcdef0123456789abcdef]]]]]]]]]]]]]]]");
+    TEST_SKIP(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, 39, "[[0123456789abcdef, [0123456789abcdef]]");
+    TEST_SKIP(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, 7, "{\"a\":{}");
+}
+
+//ֻУ鲻TEST_ERRORlept_parseһԱ
+static void test_validate()
+{
+    char deep[2 * 1100 + 1];
+    size_t offset, i;
+    const char* s = "{\"a\":[1,2,\"long string that spans more than sixteen bytes\\n\"],\"b\":{}}";
+
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_validate(s, strlen(s), &offset));
+    EXPECT_EQ_SIZE_T(strlen(s), offset);
+
+    //ȲβĲ֣ݿԲԿַβ
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_validate("[1,2]xxx", 5, NULL));
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_QUOTATION_MARK, lept_validate("\"abc\"", 4, NULL));
+    EXPECT_EQ_INT(LEPT_PARSE_INVALID_VALUE, lept_validate("tru", 3, NULL));
+    EXPECT_EQ_INT(LEPT_PARSE_INVALID_VALUE, lept_validate("1.5e", 4, NULL));
+    EXPECT_EQ_INT(LEPT_PARSE_ROOT_NOT_SINGULAR, lept_validate("1\0", 2, NULL));
+
+    //λ
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COLON, lept_validate("{\"a\" 1}", 7, &offset));
+    EXPECT_EQ_SIZE_T(5, offset);
+    EXPECT_EQ_INT(LEPT_PARSE_INVALID_STRING_CHAR, lept_validate("[\"0123456789abcdef0123\x01\"]", 25, &offset));
+    EXPECT_EQ_SIZE_T(22, offset);
+
+    //жstrtodһ
+    TEST_ERROR(LEPT_PARSE_NUMBER_TOO_BIG, "1.7976931348623159e308");
+    TEST_ERROR(LEPT_PARSE_NUMBER_TOO_BIG, "0.00001e314");
+    TEST_ERROR(LEPT_PARSE_NUMBER_TOO_BIG, "[100000000000000000000000000000000000000e300]");
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_validate("1.7976931348623158e308", 22, NULL));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_validate("0.00001e313", 11, NULL));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_validate("0e99999", 7, NULL));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_validate("1e-99999", 8, NULL));
+
+    //Чֺǰ0ܶʱʵλ㣺lept_parseLEPT_FLAG_LAZYжͬ
+    {
+        const size_t n = 2000000;
+        char* json = (char*)malloc(n + 64);
+        lept_value v;
+        lept_init(&v);
+        memcpy(json, "0.", 2);
+        memset(json + 2, '0', n);
+        strcpy(json + 2 + n, "1e2000009");
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_ex(&v, json, LEPT_FLAG_LAZY));
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_validate(json, strlen(json), NULL));
+        memset(json, '9', n + 10);
+        strcpy(json + n + 10, "e-1999700");
+        EXPECT_EQ_INT(LEPT_PARSE_NUMBER_TOO_BIG, lept_parse(&v, json));
+        EXPECT_EQ_INT(LEPT_PARSE_NUMBER_TOO_BIG, lept_parse_ex(&v, json, LEPT_FLAG_LAZY));
+        EXPECT_EQ_INT(LEPT_PARSE_NUMBER_TOO_BIG, lept_validate(json, strlen(json), NULL));
+        strcpy(json + n + 10, "e-2000009");
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_ex(&v, json, LEPT_FLAG_LAZY));
+        EXPECT_TRUE(lept_get_number(&v) > 9.0 && lept_get_number(&v) <= 10.0);
+        lept_free(&v);
+        strcpy(json, "1e");
+        memset(json + 2, '0', 40);
+        strcpy(json + 42, "308");
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_validate(json, strlen(json), NULL));
+        strcpy(json + 2, "99999999999999999999999999999");
+        EXPECT_EQ_INT(LEPT_PARSE_NUMBER_TOO_BIG, lept_validate(json, strlen(json), NULL));
+        free(json);
+    }
+
+    //Ƕײ
+    for (i = 0; i < 1100; i++) {
+        deep[i] = '[';
+        deep[2 * 1100 - 1 - i] = ']';
+    }
+    deep[2 * 1100] = '\0';
+    EXPECT_EQ_INT(LEPT_PARSE_NESTING_TOO_DEEP, lept_validate(deep, 2 * 1100, NULL));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_validate(deep + 100, 2 * 1000, NULL));
+}
+
+//õwriter׷ӵ̶СĻ
+typedef struct {
+    char buf[1024];
+    size_t len;
+    int calls;
+} test_sink;
+
+static void test_sink_write(void* user, const char* data, size_t len) {
+    test_sink* sink = (test_sink*)user;
+    if (sink->len + len <= sizeof(sink->buf)) {
+        memcpy(sink->buf + sink->len, data, len);
+        sink->len += len;
+    }
+    sink->calls++;
+}
+
+#define TEST_MINIFY(expect, json)\
+    do {\
+        test_sink sink;\
+        lept_writer w;\
+        sink.len = 0;\
+        sink.calls = 0;\
+        w.write = test_sink_write;\
+        w.user = &sink;\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_minify(json, strlen(json), &w));\
+        EXPECT_EQ_STRING(expect, sink.buf, sink.len);\
+    } while(0)
+
+#define TEST_PRETTIFY(expect, json)\
+    do {\
+        test_sink sink;\
+        lept_writer w;\
+        sink.len = 0;\
+        sink.calls = 0;\
+        w.write = test_sink_write;\
+        w.user = &sink;\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_prettify(json, strlen(json), "  ", &w));\
+        EXPECT_EQ_STRING(expect, sink.buf, sink.len);\
+    } while(0)
+
+//ʽѹַֺԭ
+static void test_minify()
+{
+    test_sink sink;
+    lept_writer w;
+
+    TEST_MINIFY("null", " null ");
+    TEST_MINIFY("1.000000000000000000001e+0010", " 1.000000000000000000001e+0010 ");
+    TEST_MINIFY("\"\\u0041\\/\"", "\"\\u0041\\/\"");
+    TEST_MINIFY("[]", "[ ]");
+    TEST_MINIFY("{}", " { \n } ");
+    TEST_MINIFY("[1,[2,[]],{\"a b\":{\"c\":[true,false]}}]", " [ 1 , [ 2, [ ] ] ,\n\t{ \"a b\" : { \"c\" : [ true , false ] } } ] ");
+
+    TEST_PRETTIFY("[]", "[]");
+    TEST_PRETTIFY("[\n  1,\n  {\n    \"a\": [],\n    \"b\": [\n      null\n    ]\n  }\n]", "[1,{\"a\":[],\"b\":[null]}]");
+
+    //ʱlept_parseͬĴ
+    sink.len = 0;
+    sink.calls = 0;
+    w.write = test_sink_write;
+    w.user = &sink;
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, lept_minify("[1 2]", 5, &w));
+    EXPECT_EQ_INT(LEPT_PARSE_ROOT_NOT_SINGULAR, lept_prettify("{} x", 4, "\t", &w));
+}
+
+//Խͳƣδ LEPT_ENABLE_STATS ʱͳȫ0
+static void test_parse_stats()
+{
+    static const char json[] = " {\"a\" : [1, \"x\\n\", true, null], \"b\":\"y\"} ";
+    lept_value v;
+    lept_stats s, total;
+    lept_stats_reset();
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));
+    lept_free(&v);
+    lept_stats_snapshot(&s);
+    memset(&total, 0, sizeof(total));
+    lept_stats_merge(&total, &s);
+    lept_stats_merge(&total, &s);
+#ifdef LEPT_ENABLE_STATS
+    EXPECT_EQ_SIZE_T(sizeof(json) - 1, (size_t)s.bytes_parsed);
+    EXPECT_EQ_SIZE_T(1, (size_t)s.nodes[LEPT_OBJECT]);
+    EXPECT_EQ_SIZE_T(1, (size_t)s.nodes[LEPT_ARRAY]);
+    EXPECT_EQ_SIZE_T(2, (size_t)s.nodes[LEPT_STRING]);
+    EXPECT_EQ_SIZE_T(1, (size_t)s.nodes[LEPT_NUMBER]);
+    EXPECT_EQ_SIZE_T(1, (size_t)s.nodes[LEPT_TRUE]);
+    EXPECT_EQ_SIZE_T(1, (size_t)s.nodes[LEPT_NULL]);
+    EXPECT_EQ_SIZE_T(1, (size_t)s.strings_escaped);
+    EXPECT_EQ_SIZE_T(3, (size_t)s.strings_plain);
+    EXPECT_TRUE(s.malloc_calls >= 6);
+    EXPECT_TRUE(s.stack_high_water > 0);
+    EXPECT_EQ_SIZE_T(0, (size_t)s.stack_regrows);
+    EXPECT_EQ_SIZE_T(2 * (size_t)s.malloc_bytes, (size_t)total.malloc_bytes);
+    EXPECT_EQ_SIZE_T((size_t)s.stack_high_water, (size_t)total.stack_high_water);
+    //ջˮλʵѹֽջ
+    lept_stats_reset();
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "[1,2,3]"));
+    lept_free(&v);
+    lept_stats_snapshot(&s);
+    EXPECT_EQ_SIZE_T(3 * sizeof(lept_value), (size_t)s.stack_high_water);
+    lept_stats_reset();
+    lept_stats_snapshot(&s);
+#endif
+    EXPECT_EQ_SIZE_T(0, (size_t)s.bytes_parsed);
+    EXPECT_EQ_SIZE_T(0, (size_t)s.malloc_calls);
+}
+
+//Դֱַӽ뵽ڵ㣺ʹͨͬջ
+static void test_parse_large_string()
+{
+    static const char* bad[] = { "\\x", "\\u12G4", "\\uD800\\uE000", "\x01", "\xC0\x80" };
+    const size_t n = 100000;   //Ĭϵ LEPT_LARGE_STRING_SIZE
+    lept_value v, expect;
+    lept_stats s;
+    char* json = (char*)malloc(n + 64);
+    size_t i;
+    json[0] = '[';
+    json[1] = '"';
+    for (i = 2; i < n; i += 8)
+        memcpy(json + i, i % 64 == 2 ? "\\u00e9\\n" : "abcdefgh", 8);
+    strcpy(json + i, "\\uD834\\uDD1E\",\"short\"]");
+    lept_init(&v);
+    lept_init(&expect);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&expect, json));
+    lept_stats_reset();
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_ex(&v, json, LEPT_FLAG_LARGE_STRINGS | LEPT_FLAG_VALIDATE_UTF8));
+    lept_stats_snapshot(&s);
+    EXPECT_TRUE(lept_is_equal(&v, &expect));
+    EXPECT_EQ_SIZE_T(lept_get_string_length(lept_get_array_element(&expect, 0)), lept_get_string_length(lept_get_array_element(&v, 0)));
+#ifdef LEPT_ENABLE_STATS
+    EXPECT_EQ_SIZE_T(0, (size_t)s.stack_regrows);
+    EXPECT_TRUE(s.stack_high_water < 1024);
+#endif
+    lept_free(&v);
+    lept_free(&expect);
+    (void)s;
+
+    //ڴַĩβȱٽβ
+    for (i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+    {
+        strcpy(json + n, bad[i]);
+        strcat(json + n, "\"]");
+        EXPECT_EQ_INT(lept_parse_ex(&v, json, LEPT_FLAG_VALIDATE_UTF8), lept_parse_ex(&v, json, LEPT_FLAG_LARGE_STRINGS | LEPT_FLAG_VALIDATE_UTF8));
+        EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+    }
+    json[n] = '\0';
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_QUOTATION_MARK, lept_parse_ex(&v, json, LEPT_FLAG_LARGE_STRINGS));
+    free(json);
+}
+
+//Խ飺ֻӿڲչȡԪָʱչͨͬ
+static void test_parse_packed()
+{
+    static const char src[] = "{\"a\":[1,2.5,-3E2,0],\"b\":[1,\"x\"],\"c\":[],\"d\":[[1,2],[3]],\"e\":[true]}";
+    lept_value v, plain, copy, patch;
+    const double* d;
+    size_t n = 0, length;
+    char* json, * expect;
+    lept_init(&v);
+    lept_init(&plain);
+    lept_init(&copy);
+    lept_init(&patch);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&plain, src));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_ex(&v, src, LEPT_FLAG_PACK_NUMBERS));
+    d = lept_get_array_doubles(lept_find_object_value(&v, "a", 1), &n);
+    EXPECT_TRUE(d != NULL);
+    EXPECT_EQ_SIZE_T(4, n);
+    EXPECT_EQ_DOUBLE(-300.0, d[2]);
+    EXPECT_EQ_DOUBLE(2.5, lept_get_array_number(lept_find_object_value(&v, "a", 1), 1));
+    EXPECT_EQ_DOUBLE(1.0, lept_get_array_number(lept_find_object_value(&v, "b", 1), 0));
+    EXPECT_TRUE(lept_get_array_doubles(lept_find_object_value(&v, "b", 1), &n) == NULL);
+    EXPECT_TRUE(lept_get_array_doubles(lept_find_object_value(&v, "c", 1), &n) == NULL);
+    EXPECT_TRUE(lept_get_array_doubles(lept_find_object_value(&v, "d", 1), &n) == NULL);
+    EXPECT_TRUE(lept_get_array_doubles(lept_find_pointer(&v, "/d/1", 4), &n) != NULL);
+
+    //ֻӿڵĽͨͬҲչ
+    json = lept_stringify(&v, &length);
+    expect = lept_stringify(&plain, NULL);
+    EXPECT_TRUE(strlen(expect) == length && memcmp(expect, json, length) == 0);
+    free(json);
+    free(expect);
+    EXPECT_TRUE(lept_is_equal(&v, &plain));
+    EXPECT_TRUE(lept_hash(&v) == lept_hash(&plain));
+    json = lept_encode_binary(&v, &length);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_decode_binary(&copy, json, length));
+    EXPECT_TRUE(lept_is_equal(&copy, &plain));
+    free(json);
+    lept_copy(&copy, &v);
+    EXPECT_TRUE(lept_get_array_doubles(lept_find_object_value(&copy, "a", 1), &n) != NULL);
+    EXPECT_TRUE(lept_is_equal(&copy, &plain));
+    EXPECT_TRUE(lept_get_array_doubles(lept_find_object_value(&v, "a", 1), &n) != NULL);
+
+    //죺޸ġɾ
+    d = lept_get_array_doubles(lept_find_object_value(&copy, "a", 1), &n);
+    ((double*)d)[1] = 7.0;
+    lept_popback_array_element(lept_find_object_value(&copy, "a", 1));
+    EXPECT_TRUE(lept_get_array_doubles(lept_find_object_value(&copy, "a", 1), &n) != NULL);
+    EXPECT_EQ_SIZE_T(3, n);
+    lept_erase_array_element(lept_find_pointer(&copy, "/d/0", 4), 0, 1);
+    EXPECT_EQ_DOUBLE(2.0, lept_get_array_number(lept_find_pointer(&copy, "/d/0", 4), 0));
+    lept_diff(&plain, &copy, &patch);
+    EXPECT_EQ_INT(LEPT_PATCH_OK, lept_apply_patch(&plain, &patch));
+    EXPECT_TRUE(lept_is_equal(&plain, &copy));
+    lept_diff(&copy, &v, &patch);
+    EXPECT_EQ_INT(LEPT_PATCH_OK, lept_apply_patch(&copy, &patch));
+    EXPECT_TRUE(lept_is_equal(&copy, &v));
+
+    //ʱչеֲ
+    lept_set_string(lept_pushback_array_element(lept_find_object_value(&copy, "a", 1)), "x", 1);
+    EXPECT_TRUE(lept_get_array_doubles(lept_find_object_value(&copy, "a", 1), &n) == NULL);
+    EXPECT_EQ_SIZE_T(5, lept_get_array_size(lept_find_object_value(&copy, "a", 1)));
+    EXPECT_EQ_DOUBLE(-300.0, lept_get_array_number(lept_find_object_value(&copy, "a", 1), 2));
+    lept_set_boolean(lept_get_array_element(lept_find_pointer(&copy, "/d/0", 4), 1), 1);
+    EXPECT_EQ_INT(LEPT_TRUE, lept_get_type(lept_find_pointer(&copy, "/d/0/1", 6)));
+
+    //ѹǽ飬չʱͷڴе double[]
+    lept_compact(&v, LEPT_ORDER_DEPTH_FIRST);
+    EXPECT_EQ_DOUBLE(-300.0, lept_get_array_number(lept_find_object_value(&v, "a", 1), 2));
+    EXPECT_TRUE(lept_get_array_doubles(lept_find_pointer(&v, "/d/1", 4), &n) != NULL);
+    lept_reserve_array(lept_find_pointer(&v, "/d/1", 4), 8);
+    EXPECT_TRUE(lept_get_array_doubles(lept_find_pointer(&v, "/d/1", 4), &n) != NULL);
+    EXPECT_EQ_SIZE_T(8, lept_get_array_capacity(lept_find_pointer(&v, "/d/1", 4)));
+    EXPECT_EQ_DOUBLE(1.0, lept_get_number(lept_get_array_element(lept_find_pointer(&v, "/d/0", 4), 0)));
+    lept_free(&v);
+
+    //Դıֲѹǰչ
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_ex(&v, src, LEPT_FLAG_PACK_NUMBERS | LEPT_FLAG_LAZY));
+    EXPECT_TRUE(lept_get_array_doubles(lept_find_object_value(&v, "a", 1), &n) == NULL);
+    lept_free(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_ex(&v, src, LEPT_FLAG_PACK_NUMBERS));
+    lept_materialize(&v);
+    EXPECT_TRUE(lept_get_array_doubles(lept_find_object_value(&v, "a", 1), &n) == NULL);
+    lept_free(&v);
+    lept_free(&plain);
+    lept_free(&copy);
+    lept_free(&patch);
+}
+
+//ӳٽ룺/ַԭȡʱŽ룬lept_parseͬ
+static void test_parse_lazy()
+{
+    static const char src[] = "{\"n\":[1.00000000000000000001,-0,1E+2,12345678901234567890123],\"s\":\"a\\u00e9\\n\\/\",\"k\":\"plain\",\"b\":[true,null]}";
+    static const char* bad[] = { "[1,]", "-", "01", "1.", "1e", "1e309", "[-1e400]", "\"\\v\"", "\"\\u12G4\"", "\"\\uD800\"", "\"\\uD800\\uE000\"",
+        "\"abc", "\"\x01\"", "{\"a\":\"\\x\"}", "[\"a\" \"b\"]", "[1e2 3]", "\"\x80\"" };
+    lept_value v, plain, copy;
+    char* json, * out, * expect;
+    size_t i, len;
+
+    json = (char*)malloc(sizeof(src));
+    memcpy(json, src, sizeof(src));
+    lept_init(&v);
+    lept_init(&plain);
+    lept_init(&copy);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_ex(&v, json, LEPT_FLAG_LAZY));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&plain, json));
+    EXPECT_EQ_INT(LEPT_LAZY_PENDING, lept_find_object_value(&v, "s", 1)->lazy);
+
+    /* ԭstrtodת */
+    out = lept_stringify(&v, &len);
+    EXPECT_EQ_STRING(src, out, len);
+    free(out);
+
+    /* ȡʱ룬֮Ȼԭ */
+    EXPECT_EQ_DOUBLE(1.0, lept_get_number(lept_get_array_element(lept_find_object_value(&v, "n", 1), 0)));
+    EXPECT_EQ_STRING("a\xC3\xA9\n/", lept_get_string(lept_find_object_value(&v, "s", 1)), lept_get_string_length(lept_find_object_value(&v, "s", 1)));
+    EXPECT_EQ_INT(LEPT_LAZY_DECODED, lept_find_object_value(&v, "s", 1)->lazy);
+    out = lept_stringify(&v, &len);
+    EXPECT_EQ_STRING(src, out, len);
+    free(out);
+
+    /* Ƚϡϣ͹淶ʹýֵ */
+    EXPECT_TRUE(lept_is_equal(&v, &plain));
+    EXPECT_TRUE(lept_hash(&v) == lept_hash(&plain));
+    out = lept_stringify_canonical(&v, &len);
+    expect = lept_stringify_canonical(&plain, &i);
+    EXPECT_TRUE(len == i && memcmp(out, expect, len) == 0);
+    free(expect);
+    free(out);
+
+    /* ޸ĺֵ lept_materialize ֮Դı */
+    lept_set_number(lept_get_array_element(lept_find_object_value(&v, "n", 1), 2), 5.0);
+    lept_copy(&copy, &v);
+    lept_materialize(&v);
+    free(json);
+    EXPECT_TRUE(lept_is_equal(&v, &copy));
+    EXPECT_EQ_DOUBLE(5.0, lept_get_number(lept_get_array_element(lept_find_object_value(&copy, "n", 1), 2)));
+    EXPECT_EQ_STRING("plain", lept_get_string(lept_find_object_value(&copy, "k", 1)), lept_get_string_length(lept_find_object_value(&copy, "k", 1)));
+    out = lept_stringify(&v, &len);
+    EXPECT_EQ_STRING("{\"n\":[1,-0,5,1.2345678901234568e+22],\"s\":\"a\xC3\xA9\\n/\",\"k\":\"plain\",\"b\":[true,null]}", out, len);
+    free(out);
+    lept_free(&v);
+    lept_free(&plain);
+    lept_free(&copy);
+
+    for (i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+    {
+        int flags = i + 1 == sizeof(bad) / sizeof(bad[0]) ? LEPT_FLAG_VALIDATE_UTF8 : 0;
+        EXPECT_EQ_INT(lept_parse_ex(&v, bad[i], flags), lept_parse_ex(&v, bad[i], flags | LEPT_FLAG_LAZY));
+        EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+    }
+}
+
+#ifdef LEPT_ENABLE_INGEST
+typedef struct
+{
+    double sum[64];             //̷ֱ߳ۼӣҪ
+    size_t long_len[64];
+    size_t bad_offset[64];
+    int abort_after;
+} test_ingest_result;
+
+static int test_ingest_callback(void* user, const lept_ingest_record* rec)
+{
+    test_ingest_result* r = (test_ingest_result*)user;
+    lept_value* n, * s;
+    if (rec->result != LEPT_PARSE_OK)
+        r->bad_offset[rec->worker] = rec->offset + 1;
+    else if ((n = lept_find_object_value(rec->v, "n", 1)) != NULL)
+        r->sum[rec->worker] += lept_get_number(n);
+    else if ((s = lept_find_object_value(rec->v, "s", 1)) != NULL)
+        r->long_len[rec->worker] = lept_get_string_length(s);
+    return r->abort_after > 0 && --r->abort_after == 0;
+}
+
+//NDJSONȡпԽ߽硢ĳСļûнβеļ
+static void test_ingest()
+{
+    static const char* paths[] = { "lept_ingest_0.ndjson", "lept_ingest_1.ndjson", "lept_ingest_2.ndjson" };
+    static const char* select[] = { "/n" };
+    lept_ingest_options opt;
+    lept_ingest_stats stats;
+    test_ingest_result r;
+    double sum;
+    size_t long_len, bad_offset, size = 0, expect_bad = 0;
+    int i, j, pass;
+    FILE* fp;
+
+    fp = fopen(paths[0], "wb");
+    for (i = 0; i < 3000; i++)
+    {
+        size += fprintf(fp, "{\"n\":%d}\n", i);
+        if (i == 1000)
+        {
+            size += fprintf(fp, "\r\n  \n{\"s\":\"");
+            for (j = 0; j < 10000; j++)
+                fputc('a' + j % 26, fp);
+            size += 10000 + fprintf(fp, "\"}\n");
+        }
+        if (i == 2000)
+        {
+            expect_bad = size;
+            size += fprintf(fp, "[1,?]\n");
+        }
+    }
+    fclose(fp);
+    fclose(fopen(paths[1], "wb"));
+    fp = fopen(paths[2], "wb");
+    fprintf(fp, "{\"n\":0.5}");
+    fclose(fp);
+
+    memset(&opt, 0, sizeof(opt));
+    opt.buffer_size = 4096;
+    opt.buffers = 3;
+    opt.workers = 4;
+    //O_DIRECTļȲLEPT_INGEST_ALIGNһҲҪĳȶ
+    for (pass = 0; pass < 4; pass++)
+    {
+        opt.flags = (pass & 1 ? LEPT_INGEST_NO_URING : 0) | (pass & 2 ? LEPT_INGEST_DIRECT : 0);
+        memset(&r, 0, sizeof(r));
+        EXPECT_EQ_INT(LEPT_INGEST_OK, lept_ingest_files(paths, 3, &opt, test_ingest_callback, &r, &stats));
+        for (i = 0, sum = 0, long_len = 0, bad_offset = 0; i < 64; i++)
+        {
+            sum += r.sum[i];
+            long_len += r.long_len[i];
+            bad_offset += r.bad_offset[i];
+        }
+        EXPECT_EQ_DOUBLE(3000.0 * 2999 / 2 + 0.5, sum);
+        EXPECT_EQ_SIZE_T(10000, long_len);
+        EXPECT_EQ_SIZE_T(expect_bad + 1, bad_offset);
+        EXPECT_EQ_SIZE_T(3003, stats.lines);
+        EXPECT_EQ_SIZE_T(1, stats.errors);
+        EXPECT_EQ_SIZE_T(size + 9, stats.bytes);
+        EXPECT_EQ_SIZE_T((size + 4095) / 4096 + 1, stats.reads);
+        if (pass & 1)
+            EXPECT_FALSE(stats.io_uring);
+    }
+
+    //ֻΪ /n ڵ㣬ַڵнɿն
+    opt.select = select;
+    opt.select_count = 1;
+    memset(&r, 0, sizeof(r));
+    EXPECT_EQ_INT(LEPT_INGEST_OK, lept_ingest_files(paths, 3, &opt, test_ingest_callback, &r, &stats));
+    for (i = 0, sum = 0, long_len = 0; i < 64; i++)
+    {
+        sum += r.sum[i];
+        long_len += r.long_len[i];
+    }
+    EXPECT_EQ_DOUBLE(3000.0 * 2999 / 2 + 0.5, sum);
+    EXPECT_EQ_SIZE_T(0, long_len);
+    EXPECT_EQ_SIZE_T(1, stats.errors);
+    opt.select = NULL;
+
+    memset(&r, 0, sizeof(r));
+    r.abort_after = 1;
+    EXPECT_EQ_INT(LEPT_INGEST_ABORTED, lept_ingest_files(paths, 3, &opt, test_ingest_callback, &r, NULL));
+    remove(paths[1]);
+    EXPECT_EQ_INT(LEPT_INGEST_IO_ERROR, lept_ingest_files(paths, 3, &opt, test_ingest_callback, &r, NULL));
+    remove(paths[0]);
+    remove(paths[2]);
+}
+#endif
+
 static void test_parse()
 {
     test_parse_null();
@@ -399,10 +1012,22 @@ static void test_parse()
     test_parse_invalid_string_char();
     test_parse_invalid_unicode_hex();
     test_parse_invalid_unicode_surrogate();
+    test_parse_invalid_utf8();
     test_parse_miss_comma_or_square_bracket();
     test_parse_miss_key();
     test_parse_miss_colon();
     test_parse_miss_comma_or_curly_bracket();
+    test_validate();
+    test_parse_select();
+    test_skip_value();
+    test_minify();
+    test_parse_stats();
+    test_parse_large_string();
+    test_parse_packed();
+    test_parse_lazy();
+#ifdef LEPT_ENABLE_INGEST
+    test_ingest();
+#endif
 }
 
 //ԣJSONıJSONı
@@ -413,6 +1038,7 @@ static void test_parse()
         size_t length;\
         lept_init(&v);\
         EXPECT_EQ_INT(LEPT_PARSE_OK,lept_parse(&v, json));\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_validate(json, strlen(json), NULL));\
         json2 = lept_stringify(&v, &length);\
         EXPECT_EQ_STRING(json, json2, length);\
         lept_free(&v);\
@@ -468,7 +1094,158 @@ static void test_stringify_object()
     TEST_ROUNDTRIP("{\"n\":null,\"f\":false,\"t\":true,\"i\":123,\"s\":\"abc\",\"a\":[1,2,3],\"o\":{\"1\":1,\"2\":2,\"3\":3}}");
 }
 
+#define TEST_CANONICAL(expect, json)\
+    do{\
+        lept_value v;\
+        char* json2;\
+        size_t length;\
+        lept_init(&v);\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));\
+        json2 = lept_stringify_canonical(&v, &length);\
+        EXPECT_EQ_STRING(expect, json2, length);\
+        lept_free(&v);\
+        free(json2);\
+    }while(0)
+
+//Թ淶
+static void test_stringify_canonical()
+{
+    TEST_CANONICAL("null", " null ");
+    TEST_CANONICAL("0", "-0");
+    TEST_CANONICAL("0", "0.0e10");
+    TEST_CANONICAL("1", "1.000");
+    TEST_CANONICAL("-123", "-1.23e2");
+    TEST_CANONICAL("1.5", "1.5");
+    TEST_CANONICAL("0.1", "1e-1");
+    TEST_CANONICAL("0.000001", "1e-6");
+    TEST_CANONICAL("1e-7", "1e-7");
+    TEST_CANONICAL("1.5e-7", "0.00000015");
+    TEST_CANONICAL("100000000000000000000", "1e20");
+    TEST_CANONICAL("1e+21", "1e21");
+    TEST_CANONICAL("-1.5e+300", "-15e299");
+    TEST_CANONICAL("9007199254740992", "9007199254740993");
+    TEST_CANONICAL("333333333.3333333", "333333333.33333329");
+    TEST_CANONICAL("5e-324", "4.9406564584124654e-324");
+    TEST_CANONICAL("1.7976931348623157e+308", "1.7976931348623157e+308");
+
+    TEST_CANONICAL("\"\\u001f\\n/\x7F\xE2\x82\xAC\"", "\"\\u001F\\n\\/\\u007f\\u20ac\"");
+
+    TEST_CANONICAL("{\"a\":{\"x\":[],\"y\":{}},\"b\":[{\"c\":1,\"d\":2}],\"bb\":true}",
+        "{ \"bb\":true, \"b\":[{\"d\":2,\"c\":1}], \"a\":{\"y\":{},\"x\":[]} }");
+    //RFC 8785 3.2.3 ʾ
+    TEST_CANONICAL("{\"\\r\":0,\"1\":1,\"\xC2\x80\":2,\"\xC3\xB6\":3,\"\xE2\x82\xAC\":4,\"\xF0\x9F\x98\x80\":5,\"\xEF\xAC\xB3\":6}",
+        "{\"\\u20ac\":4,\"\\r\":0,\"\\ufb33\":6,\"1\":1,\"\\ud83d\\ude00\":5,\"\\u0080\":2,\"\\u00f6\":3}");
+    TEST_CANONICAL("{\"a\":1,\"b\":2,\"c\":3,\"d\":4,\"e\":5,\"f\":6,\"g\":7,\"h\":8,\"i\":9,\"j\":10,\"k\":11,\"l\":12,\"m\":13,\"n\":14,\"o\":15,\"p\":16,\"q\":17}",
+        "{\"q\":17,\"p\":16,\"o\":15,\"n\":14,\"m\":13,\"l\":12,\"k\":11,\"j\":10,\"i\":9,\"h\":8,\"g\":7,\"f\":6,\"e\":5,\"d\":4,\"c\":3,\"b\":2,\"a\":1}");
+}
+
 //ַ
+//Ӧ벻ĸͬ
+#define EXPECT_CACHED_STRINGIFY(v)\
+    do{\
+        lept_value fresh;\
+        char* json1, * json2;\
+        size_t length1, length2;\
+        lept_init(&fresh);\
+        lept_copy(&fresh, &(v));\
+        json1 = lept_stringify(&fresh, &length1);\
+        json2 = lept_stringify_cached(&(v), &length2);\
+        EXPECT_EQ_SIZE_T(length1, length2);\
+        EXPECT_TRUE(length1 == length2 && memcmp(json1, json2, length1) == 0);\
+        free(json1);\
+        free(json2);\
+        lept_free(&fresh);\
+    }while(0)
+
+//Դַֻб·
+static void test_stringify_cached()
+{
+    lept_value v, p, * e;
+    char* json;
+    size_t i, length;
+    lept_init(&v);
+    lept_set_object(&v, 0);
+    e = lept_set_object_value(&v, "big", 3);
+    lept_set_array(e, 0);
+    for (i = 0; i < 64; i++)
+        lept_set_number(lept_pushback_array_element(e), 1234567.0 + i);
+    lept_set_string(lept_set_object_value(&v, "s", 1), "abc", 3);
+    EXPECT_CACHED_STRINGIFY(v);
+    EXPECT_CACHED_STRINGIFY(v);
+
+    /* ƹ޸ĽӿֱӸڵʱ治ԶʧЧlept_stringifyȡ */
+    lept_set_number(lept_get_array_element(lept_find_object_value(&v, "big", 3), 0), 0.0);
+    json = lept_stringify(&v, &length);
+    EXPECT_TRUE(strstr(json, "[0,") != NULL);
+    free(json);
+    json = lept_stringify_cached(&v, &length);
+    EXPECT_TRUE(strstr(json, "[1234567,") != NULL);
+    free(json);
+    lept_invalidate(lept_find_object_value(&v, "big", 3));
+    lept_invalidate(&v);
+    json = lept_stringify_cached(&v, &length);
+    EXPECT_TRUE(strstr(json, "[0,") != NULL);
+    free(json);
+    EXPECT_CACHED_STRINGIFY(v);
+
+    /* Ƕ׽Ҷӱ޸ģÿȶл */
+    e = lept_set_object_value(&v, "deep", 4);
+    lept_set_array(e, 1);
+    e = lept_pushback_array_element(e);
+    lept_set_object(e, 1);
+    e = lept_set_object_value(e, "leaf", 4);
+    lept_set_array(e, 0);
+    for (i = 0; i < 64; i++)
+        lept_set_number(lept_pushback_array_element(e), 7654321.0 + i);
+    EXPECT_CACHED_STRINGIFY(v);
+    e = lept_find_object_value(lept_get_array_element(lept_find_object_value(&v, "deep", 4), 0), "leaf", 4);
+    lept_set_string(lept_get_array_element(e, 5), "edited", 6);
+    json = lept_stringify(&v, &length);
+    EXPECT_TRUE(strstr(json, "7654325,\"edited\",7654327") != NULL);
+    free(json);
+    lept_touch_pointer(&v, "/deep/0/leaf/5", 14);
+    EXPECT_CACHED_STRINGIFY(v);
+    json = lept_stringify_cached(&v, &length);
+    EXPECT_TRUE(strstr(json, "7654325,\"edited\",7654327") != NULL);
+    free(json);
+
+    /* lept_touch_pointer/޸ĽӿںͲᶪ·ϵĻ */
+    lept_set_number(lept_touch_pointer(&v, "/big/1", 6), 1.0);
+    EXPECT_CACHED_STRINGIFY(v);
+    lept_popback_array_element(lept_touch_pointer(&v, "/big", 4));
+    EXPECT_CACHED_STRINGIFY(v);
+    lept_set_null(lept_set_object_value(&v, "s", 1));
+    EXPECT_CACHED_STRINGIFY(v);
+    lept_init(&p);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&p, "[{\"op\":\"replace\",\"path\":\"/big/2\",\"value\":2},{\"op\":\"move\",\"from\":\"/big/3\",\"path\":\"/s\"}]"));
+    EXPECT_EQ_INT(LEPT_PATCH_OK, lept_apply_patch(&v, &p));
+    EXPECT_CACHED_STRINGIFY(v);
+    lept_free(&p);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&p, "{\"big\":{\"x\":1}}"));
+    lept_apply_merge_patch(&v, &p);
+    EXPECT_CACHED_STRINGIFY(v);
+    lept_free(&p);
+
+    /* Ԫ/ԱͷѹչĽ顢յ */
+    lept_compact(&v, LEPT_ORDER_DEPTH_FIRST);
+    EXPECT_CACHED_STRINGIFY(v);
+    EXPECT_CACHED_STRINGIFY(v);
+    lept_free(&v);
+    json = (char*)malloc(64 * 12 + 3);
+    for (i = 0, length = 1, json[0] = '['; i < 64; i++)
+        length += sprintf(json + length, "%s%d", i > 0 ? "," : "", (int)(1234567 + i));
+    memcpy(json + length, "]", 2);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_ex(&v, json, LEPT_FLAG_PACK_NUMBERS));
+    free(json);
+    EXPECT_CACHED_STRINGIFY(v);
+    lept_unpack_array(&v);
+    EXPECT_CACHED_STRINGIFY(v);
+    lept_clear_array(&v);
+    lept_shrink_array(&v);
+    EXPECT_CACHED_STRINGIFY(v);
+    lept_free(&v);
+}
+
 static void test_stringify()
 {
     TEST_ROUNDTRIP("null");
@@ -478,6 +1255,8 @@ static void test_stringify()
     test_stringify_string();
     test_stringify_array();
     test_stringify_object();
+    test_stringify_canonical();
+    test_stringify_cached();
 }
 
 //ԸڵNULL
@@ -523,11 +1302,782 @@ static void test_access_string() {
     lept_free(&v);
 }
 
+//ԣJSONı -> ڵ -> MessagePack -> ڵ -> JSONı
+#define TEST_BINARY_ROUNDTRIP(json)\
+    do{\
+        lept_value v, v2;\
+        char *bin, *json2;\
+        size_t blength, length;\
+        lept_init(&v);\
+        lept_init(&v2);\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));\
+        bin = lept_encode_binary(&v, &blength);\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_decode_binary(&v2, bin, blength));\
+        json2 = lept_stringify(&v2, &length);\
+        EXPECT_EQ_STRING(json, json2, length);\
+        lept_free(&v);\
+        lept_free(&v2);\
+        free(bin);\
+        free(json2);\
+    }while(0)
+
+#define TEST_BINARY_ERROR(error, bin)\
+    do {\
+        lept_value v;\
+        lept_init(&v);\
+        EXPECT_EQ_INT(error, lept_decode_binary(&v, bin, sizeof(bin) - 1));\
+        EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));\
+    } while(0)
+
+static void test_binary() {
+    lept_value v;
+    char* bin;
+    size_t length;
+
+    TEST_BINARY_ROUNDTRIP("null");
+    TEST_BINARY_ROUNDTRIP("false");
+    TEST_BINARY_ROUNDTRIP("true");
+    TEST_BINARY_ROUNDTRIP("0");
+    TEST_BINARY_ROUNDTRIP("-0");
+    TEST_BINARY_ROUNDTRIP("127");
+    TEST_BINARY_ROUNDTRIP("128");
+    TEST_BINARY_ROUNDTRIP("-32");
+    TEST_BINARY_ROUNDTRIP("-33");
+    TEST_BINARY_ROUNDTRIP("65536");
+    TEST_BINARY_ROUNDTRIP("-2147483649");
+    TEST_BINARY_ROUNDTRIP("1e+20");
+    TEST_BINARY_ROUNDTRIP("-1.5");
+    TEST_BINARY_ROUNDTRIP("4.9406564584124654e-324");
+    TEST_BINARY_ROUNDTRIP("1.7976931348623157e+308");
+    TEST_BINARY_ROUNDTRIP("\"\"");
+    TEST_BINARY_ROUNDTRIP("\"Hello\\u0000World\"");
+    TEST_BINARY_ROUNDTRIP("\"0123456789abcdef0123456789abcdef\"");
+    TEST_BINARY_ROUNDTRIP("[]");
+    TEST_BINARY_ROUNDTRIP("[null,false,true,123,\"abc\",[1,2,3]]");
+    TEST_BINARY_ROUNDTRIP("[1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16]");
+    TEST_BINARY_ROUNDTRIP("{}");
+    TEST_BINARY_ROUNDTRIP("{\"n\":null,\"f\":false,\"t\":true,\"i\":123,\"s\":\"abc\",\"a\":[1,2,3],\"o\":{\"1\":1,\"2\":2,\"3\":3}}");
+
+    //ʹ̵ı
+    lept_init(&v);
+    lept_parse(&v, "{\"a\":[1,-1,300]}");
+    bin = lept_encode_binary(&v, &length);
+    EXPECT_EQ_SIZE_T(9, length);
+    EXPECT_TRUE(memcmp(bin, "\x81\xA1" "a" "\x93\x01\xFF\xCD\x01\x2C", 9) == 0);
+    free(bin);
+    lept_free(&v);
+
+    TEST_BINARY_ERROR(LEPT_PARSE_INVALID_BINARY, "");
+    TEST_BINARY_ERROR(LEPT_PARSE_INVALID_BINARY, "\xC1");              //ֽ
+    TEST_BINARY_ERROR(LEPT_PARSE_INVALID_BINARY, "\xCB\x00\x00");      //float64ض
+    TEST_BINARY_ERROR(LEPT_PARSE_INVALID_BINARY, "\xA3" "ab");          //ַض
+    TEST_BINARY_ERROR(LEPT_PARSE_INVALID_BINARY, "\x92\x01");          //鱻ض
+    TEST_BINARY_ERROR(LEPT_PARSE_INVALID_BINARY, "\xDD\xFF\xFF\xFF\xFF\x01"); //鳤ȳ
+    TEST_BINARY_ERROR(LEPT_PARSE_INVALID_BINARY, "\x81\x01\x01");      //keyַ
+    TEST_BINARY_ERROR(LEPT_PARSE_INVALID_BINARY, "\x82\xA1" "a" "\x01\xA1" "b"); //󱻽ض
+    TEST_BINARY_ERROR(LEPT_PARSE_ROOT_NOT_SINGULAR, "\xC0\xC0");
+
+    //Ƕײlept_validateͬʱǺľջ
+    bin = (char*)malloc(100000);
+    memset(bin, 0x91, 100000);
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_NESTING_TOO_DEEP, lept_decode_binary(&v, bin, 100000));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+    bin[1023] = (char)0xC0;
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_decode_binary(&v, bin, 1024));
+    lept_free(&v);
+    memset(bin, 0x81, 100000);
+    for (length = 1; length < 4096; length += 2)
+        bin[length] = (char)0xA0;
+    EXPECT_EQ_INT(LEPT_PARSE_NESTING_TOO_DEEP, lept_decode_binary(&v, bin, 4096));
+    free(bin);
+
+    //ȳ32λַ޷룺һôĽڵ㣬дʱʧܣȡ
+    if (sizeof(size_t) > 4)
+    {
+        lept_value big, * e;
+        lept_init(&big);
+        lept_set_array(&big, 0);
+        e = lept_pushback_array_element(&big);
+        lept_set_string(e, "x", 1);
+        length = e->u.s.len;
+        e->u.s.len = (size_t)((((uint64_t)1) << 32) | 1);
+        EXPECT_TRUE(lept_encode_binary(&big, NULL) == NULL);
+        e->u.s.len = length;
+        lept_free(&big);
+    }
+}
+
+//ڵǷȣȵĽڵϣֵҲ
+#define TEST_EQUAL(json1, json2, equality) \
+    do {\
+        lept_value v1, v2;\
+        lept_init(&v1);\
+        lept_init(&v2);\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v1, json1));\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v2, json2));\
+        EXPECT_EQ_INT(equality, lept_is_equal(&v1, &v2));\
+        EXPECT_EQ_INT(equality, lept_is_equal(&v2, &v1));\
+        if (equality)\
+            EXPECT_TRUE(lept_hash(&v1) == lept_hash(&v2));\
+        lept_free(&v1);\
+        lept_free(&v2);\
+    } while(0)
+
+static void test_equal() {
+    TEST_EQUAL("true", "true", 1);
+    TEST_EQUAL("true", "false", 0);
+    TEST_EQUAL("false", "false", 1);
+    TEST_EQUAL("null", "null", 1);
+    TEST_EQUAL("null", "0", 0);
+    TEST_EQUAL("123", "123", 1);
+    TEST_EQUAL("123", "456", 0);
+    TEST_EQUAL("0", "-0", 1);
+    TEST_EQUAL("\"abc\"", "\"abc\"", 1);
+    TEST_EQUAL("\"abc\"", "\"abcd\"", 0);
+    TEST_EQUAL("[]", "[]", 1);
+    TEST_EQUAL("[]", "null", 0);
+    TEST_EQUAL("[1,2,3]", "[1,2,3]", 1);
+    TEST_EQUAL("[1,2,3]", "[1,2,3,4]", 0);
+    TEST_EQUAL("[1,2,3]", "[3,2,1]", 0);
+    TEST_EQUAL("[[]]", "[[]]", 1);
+    TEST_EQUAL("{}", "{}", 1);
+    TEST_EQUAL("{}", "null", 0);
+    TEST_EQUAL("{}", "[]", 0);
+    TEST_EQUAL("{\"a\":1,\"b\":2}", "{\"a\":1,\"b\":2}", 1);
+    TEST_EQUAL("{\"a\":1,\"b\":2}", "{\"b\":2,\"a\":1}", 1);
+    TEST_EQUAL("{\"a\":1,\"b\":2}", "{\"a\":1,\"b\":3}", 0);
+    TEST_EQUAL("{\"a\":1,\"b\":2}", "{\"a\":1,\"b\":2,\"c\":3}", 0);
+    TEST_EQUAL("{\"a\":{\"b\":{\"c\":{}}}}", "{\"a\":{\"b\":{\"c\":{}}}}", 1);
+    TEST_EQUAL("{\"a\":{\"b\":{\"c\":{}}}}", "{\"a\":{\"b\":{\"c\":[]}}}", 0);
+    //ظkeyÿԱƥһͬĳԱͬ
+    TEST_EQUAL("{\"a\":1,\"a\":1}", "{\"a\":1,\"b\":2}", 0);
+    TEST_EQUAL("{\"a\":1,\"a\":2}", "{\"a\":2,\"a\":1}", 1);
+    TEST_EQUAL("{\"a\":1,\"a\":2}", "{\"a\":1,\"a\":1}", 0);
+    TEST_EQUAL(
+        "{\"a\":1,\"a\":1,\"c\":3,\"d\":4,\"e\":5,\"f\":6,\"g\":7,\"h\":8,\"i\":9,\"j\":10,\"k\":11,\"l\":12,\"m\":13,\"n\":14,\"o\":15,\"p\":16,\"q\":17,\"r\":18}",
+        "{\"r\":18,\"q\":17,\"p\":16,\"o\":15,\"n\":14,\"m\":13,\"l\":12,\"k\":11,\"j\":10,\"i\":9,\"h\":8,\"g\":7,\"f\":6,\"e\":5,\"d\":4,\"c\":3,\"b\":2,\"a\":1}", 0);
+    TEST_EQUAL(
+        "{\"a\":1,\"a\":2,\"c\":3,\"d\":4,\"e\":5,\"f\":6,\"g\":7,\"h\":8,\"i\":9,\"j\":10,\"k\":11,\"l\":12,\"m\":13,\"n\":14,\"o\":15,\"p\":16,\"q\":17,\"r\":18}",
+        "{\"r\":18,\"q\":17,\"p\":16,\"o\":15,\"n\":14,\"m\":13,\"l\":12,\"k\":11,\"j\":10,\"i\":9,\"h\":8,\"g\":7,\"f\":6,\"e\":5,\"d\":4,\"c\":3,\"a\":2,\"a\":1}", 1);
+    //Ա϶Ķ߹ϣ
+    TEST_EQUAL(
+        "{\"a\":1,\"b\":2,\"c\":3,\"d\":4,\"e\":5,\"f\":6,\"g\":7,\"h\":8,\"i\":9,\"j\":10,\"k\":11,\"l\":12,\"m\":13,\"n\":14,\"o\":15,\"p\":16,\"q\":17,\"r\":18}",
+        "{\"r\":18,\"q\":17,\"p\":16,\"o\":15,\"n\":14,\"m\":13,\"l\":12,\"k\":11,\"j\":10,\"i\":9,\"h\":8,\"g\":7,\"f\":6,\"e\":5,\"d\":4,\"c\":3,\"b\":2,\"a\":1}", 1);
+    TEST_EQUAL(
+        "{\"a\":1,\"b\":2,\"c\":3,\"d\":4,\"e\":5,\"f\":6,\"g\":7,\"h\":8,\"i\":9,\"j\":10,\"k\":11,\"l\":12,\"m\":13,\"n\":14,\"o\":15,\"p\":16,\"q\":17,\"r\":18}",
+        "{\"r\":18,\"q\":17,\"p\":16,\"o\":15,\"n\":14,\"m\":13,\"l\":12,\"k\":11,\"j\":10,\"i\":9,\"h\":8,\"g\":7,\"f\":6,\"e\":5,\"d\":4,\"c\":3,\"b\":2,\"z\":1}", 0);
+}
+
+//ȸơƶͽ
+static void test_copy() {
+    lept_value v1, v2;
+    char* json;
+    size_t length;
+    lept_init(&v1);
+    lept_parse(&v1, "{\"t\":true,\"f\":false,\"n\":null,\"d\":1.5,\"a\":[1,2,3],\"o\":{\"s\":\"abc\"}}");
+    lept_init(&v2);
+    lept_copy(&v2, &v1);
+    json = lept_stringify(&v2, &length);
+    EXPECT_EQ_STRING("{\"t\":true,\"f\":false,\"n\":null,\"d\":1.5,\"a\":[1,2,3],\"o\":{\"s\":\"abc\"}}", json, length);
+    free(json);
+    //ԭڵ㻥Ӱ
+    lept_set_number(lept_get_array_element(lept_find_object_value(&v1, "a", 1), 0), 9.0);
+    EXPECT_EQ_DOUBLE(1.0, lept_get_number(lept_get_array_element(lept_find_object_value(&v2, "a", 1), 0)));
+    EXPECT_EQ_SIZE_T(3, lept_get_array_capacity(lept_find_object_value(&v2, "a", 1)));
+    //srcdstӽڵ
+    lept_copy(&v2, lept_find_object_value(&v2, "o", 1));
+    json = lept_stringify(&v2, &length);
+    EXPECT_EQ_STRING("{\"s\":\"abc\"}", json, length);
+    free(json);
+    lept_free(&v1);
+    lept_free(&v2);
+}
+
+static void test_move() {
+    lept_value v1, v2, v3;
+    lept_init(&v1);
+    lept_parse(&v1, "[1,\"abc\",{\"a\":[]}]");
+    lept_init(&v2);
+    lept_copy(&v2, &v1);
+    lept_init(&v3);
+    lept_move(&v3, &v2);
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v2));
+    EXPECT_EQ_INT(LEPT_ARRAY, lept_get_type(&v3));
+    EXPECT_EQ_SIZE_T(3, lept_get_array_size(&v3));
+    EXPECT_EQ_STRING("abc", lept_get_string(lept_get_array_element(&v3, 1)), lept_get_string_length(lept_get_array_element(&v3, 1)));
+    //srcdstӽڵ
+    lept_move(&v3, lept_find_object_value(lept_get_array_element(&v3, 2), "a", 1));
+    EXPECT_EQ_INT(LEPT_ARRAY, lept_get_type(&v3));
+    EXPECT_EQ_SIZE_T(0, lept_get_array_size(&v3));
+    lept_free(&v1);
+    lept_free(&v2);
+    lept_free(&v3);
+}
+
+static void test_swap() {
+    lept_value v1, v2;
+    lept_init(&v1);
+    lept_init(&v2);
+    lept_set_string(&v1, "Hello",  5);
+    lept_set_string(&v2, "World!", 6);
+    lept_swap(&v1, &v2);
+    EXPECT_EQ_STRING("World!", lept_get_string(&v1), lept_get_string_length(&v1));
+    EXPECT_EQ_STRING("Hello",  lept_get_string(&v2), lept_get_string_length(&v2));
+    lept_free(&v1);
+    lept_free(&v2);
+}
+
+//ѹڴ棺˳ͬѹԿ޸ġƶͷţڴsanitizer/CRT⣩
+static void test_compact() {
+    static const char json[] = "{\"name\":\"lept\",\"tags\":[\"a\",\"bc\",[]],\"o\":{\"n\":1.5,\"t\":true,\"s\":\"\\u00e9\"},\"e\":{}}";
+    lept_value v, expect, out;
+    const char* base;
+    size_t size, length;
+    char* s;
+    int order;
+    for (order = LEPT_ORDER_DEPTH_FIRST; order <= LEPT_ORDER_BREADTH_FIRST; order++) {
+        lept_init(&v);
+        lept_init(&expect);
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_ex(&v, json, LEPT_FLAG_LAZY));
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&expect, json));
+        free(lept_stringify_cached(&v, &length));
+        size = lept_compact(&v, order);
+        EXPECT_TRUE(size > 0);
+        EXPECT_EQ_INT(LEPT_COMPACT_ROOT, v.compact);
+        EXPECT_TRUE(lept_is_equal(&v, &expect));
+        s = lept_stringify(&v, &length);
+        EXPECT_EQ_STRING("{\"name\":\"lept\",\"tags\":[\"a\",\"bc\",[]],\"o\":{\"n\":1.5,\"t\":true,\"s\":\"\xC3\xA9\"},\"e\":{}}", s, length);
+        free(s);
+        //ַkeyԪضڴ
+        base = (const char*)v.u.o.m;
+        EXPECT_TRUE(lept_get_object_key(&v, 3) > base && lept_get_object_key(&v, 3) < base + size);
+        EXPECT_TRUE(lept_get_string(lept_find_pointer(&v, "/tags/1", 7)) < base + size);
+        EXPECT_TRUE((const char*)lept_find_pointer(&v, "/o/s", 4) < base + size);
+        EXPECT_EQ_INT(LEPT_COMPACT_INNER, lept_find_pointer(&v, "/o", 2)->compact);
+        EXPECT_EQ_SIZE_T(4, lept_get_object_capacity(&v));
+        //ѹһΣɵڴ汻ͷ
+        EXPECT_EQ_SIZE_T(size, lept_compact(&v, !order));
+        EXPECT_TRUE(lept_is_equal(&v, &expect));
+
+        //޸ģ/󱻸ƻͨڴ棬ಿֲ
+        lept_set_number(lept_pushback_array_element(lept_find_object_value(&v, "tags", 4)), 2.0);
+        lept_set_number(lept_pushback_array_element(lept_find_pointer(&expect, "/tags", 5)), 2.0);
+        EXPECT_EQ_INT(LEPT_COMPACT_NONE, lept_find_object_value(&v, "tags", 4)->compact);
+        lept_set_string(lept_set_object_value(lept_find_object_value(&v, "o", 1), "k", 1), "new", 3);
+        lept_set_string(lept_set_object_value(lept_find_object_value(&expect, "o", 1), "k", 1), "new", 3);
+        lept_set_string(lept_find_object_value(&v, "name", 4), "json", 4);
+        lept_set_string(lept_find_object_value(&expect, "name", 4), "json", 4);
+        lept_remove_object_value(&v, lept_find_object_index(&v, "e", 1));
+        lept_remove_object_value(&expect, lept_find_object_index(&expect, "e", 1));
+        lept_shrink_object(&v);
+        EXPECT_EQ_SIZE_T(4, lept_get_object_capacity(&v));
+        EXPECT_TRUE(lept_is_equal(&v, &expect));
+
+        //ڵ㣺ڴɸУƻͨڴ
+        lept_compact(&v, order);
+        lept_set_boolean(lept_set_object_value(&v, "z", 1), 1);
+        lept_set_boolean(lept_set_object_value(&expect, "z", 1), 1);
+        EXPECT_EQ_INT(LEPT_COMPACT_NONE, v.compact);
+        EXPECT_EQ_INT(LEPT_COMPACT_NONE, lept_find_pointer(&v, "/o", 2)->compact);
+        EXPECT_EQ_INT(LEPT_COMPACT_NONE, lept_find_pointer(&v, "/tags/1", 7)->compact);
+        EXPECT_TRUE(lept_is_equal(&v, &expect));
+        lept_set_string(lept_set_object_value(lept_find_object_value(&v, "o", 1), "k", 1), "again", 5);
+        lept_set_string(lept_set_object_value(lept_find_object_value(&expect, "o", 1), "k", 1), "again", 5);
+        EXPECT_TRUE(lept_is_equal(&v, &expect));
+
+        //Ƴڲڵʱƣ֮ͷӰƳĽڵ
+        lept_init(&out);
+        lept_compact(&v, order);
+        lept_move(&out, lept_find_object_value(&v, "o", 1));
+        EXPECT_EQ_INT(LEPT_COMPACT_NONE, out.compact);
+        EXPECT_EQ_INT(LEPT_NULL, lept_get_type(lept_find_object_value(&v, "o", 1)));
+        lept_swap(&out, lept_find_pointer(&v, "/tags/0", 7));
+        EXPECT_EQ_STRING("a", lept_get_string(&out), lept_get_string_length(&out));
+        lept_free(&v);
+        EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+        lept_free(&out);
+        lept_free(&expect);
+    }
+    //ƶȨŸߣǿ/ֵѹ
+    lept_init(&v);
+    lept_init(&out);
+    lept_parse(&v, "[[1,2],\"x\"]");
+    lept_compact(&v, LEPT_ORDER_DEPTH_FIRST);
+    lept_set_array(&out, 0);
+    lept_move(lept_pushback_array_element(&out), &v);
+    EXPECT_EQ_INT(LEPT_COMPACT_ROOT, lept_get_array_element(&out, 0)->compact);
+    lept_free(&out);
+    lept_parse(&v, "[[1,2],\"x\"]");
+    lept_compact(&v, LEPT_ORDER_BREADTH_FIRST);
+    lept_set_number(lept_pushback_array_element(&v), 3.0);
+    lept_set_number(lept_pushback_array_element(lept_get_array_element(&v, 0)), 4.0);
+    s = lept_stringify(&v, &length);
+    EXPECT_EQ_STRING("[[1,2,4],\"x\",3]", s, length);
+    free(s);
+    lept_free(&v);
+    lept_parse(&v, "\"abc\"");
+    EXPECT_EQ_SIZE_T(0, lept_compact(&v, LEPT_ORDER_DEPTH_FIRST));
+    lept_free(&v);
+    lept_parse(&v, "[]");
+    EXPECT_EQ_SIZE_T(0, lept_compact(&v, LEPT_ORDER_BREADTH_FIRST));
+    lept_free(&v);
+}
+
+//ɾ
+static void test_access_array() {
+    lept_value a, e;
+    size_t i, j;
+
+    lept_init(&a);
+
+    for (j = 0; j <= 5; j += 5) {
+        lept_set_array(&a, j);
+        EXPECT_EQ_SIZE_T(0, lept_get_array_size(&a));
+        EXPECT_EQ_SIZE_T(j, lept_get_array_capacity(&a));
+        for (i = 0; i < 10; i++) {
+            lept_init(&e);
+            lept_set_number(lept_pushback_array_element(&a), (double)i);
+        }
+
+        EXPECT_EQ_SIZE_T(10, lept_get_array_size(&a));
+        for (i = 0; i < 10; i++)
+            EXPECT_EQ_DOUBLE((double)i, lept_get_number(lept_get_array_element(&a, i)));
+    }
+
+    lept_popback_array_element(&a);
+    EXPECT_EQ_SIZE_T(9, lept_get_array_size(&a));
+    for (i = 0; i < 9; i++)
+        EXPECT_EQ_DOUBLE((double)i, lept_get_number(lept_get_array_element(&a, i)));
+
+    lept_erase_array_element(&a, 4, 0);
+    EXPECT_EQ_SIZE_T(9, lept_get_array_size(&a));
+    for (i = 0; i < 9; i++)
+        EXPECT_EQ_DOUBLE((double)i, lept_get_number(lept_get_array_element(&a, i)));
+
+    lept_erase_array_element(&a, 8, 1);
+    EXPECT_EQ_SIZE_T(8, lept_get_array_size(&a));
+    for (i = 0; i < 8; i++)
+        EXPECT_EQ_DOUBLE((double)i, lept_get_number(lept_get_array_element(&a, i)));
+
+    lept_erase_array_element(&a, 0, 2);
+    EXPECT_EQ_SIZE_T(6, lept_get_array_size(&a));
+    for (i = 0; i < 6; i++)
+        EXPECT_EQ_DOUBLE((double)i + 2, lept_get_number(lept_get_array_element(&a, i)));
+
+    for (i = 0; i < 2; i++)
+        lept_set_number(lept_insert_array_element(&a, i), (double)i);
+
+    EXPECT_EQ_SIZE_T(8, lept_get_array_size(&a));
+    for (i = 0; i < 8; i++)
+        EXPECT_EQ_DOUBLE((double)i, lept_get_number(lept_get_array_element(&a, i)));
+
+    EXPECT_TRUE(lept_get_array_capacity(&a) > 8);
+    lept_shrink_array(&a);
+    EXPECT_EQ_SIZE_T(8, lept_get_array_capacity(&a));
+    EXPECT_EQ_SIZE_T(8, lept_get_array_size(&a));
+    for (i = 0; i < 8; i++)
+        EXPECT_EQ_DOUBLE((double)i, lept_get_number(lept_get_array_element(&a, i)));
+
+    lept_set_string(&e, "Hello", 5);
+    lept_set_string(lept_pushback_array_element(&a), lept_get_string(&e), lept_get_string_length(&e));
+    lept_free(&e);
+
+    i = lept_get_array_capacity(&a);
+    lept_clear_array(&a);
+    EXPECT_EQ_SIZE_T(0, lept_get_array_size(&a));
+    EXPECT_EQ_SIZE_T(i, lept_get_array_capacity(&a));
+    lept_shrink_array(&a);
+    EXPECT_EQ_SIZE_T(0, lept_get_array_capacity(&a));
+
+    lept_free(&a);
+}
+
+//Զɾ
+static void test_access_object() {
+    lept_value o, v, *pv;
+    size_t i, j, index;
+
+    lept_init(&o);
+
+    for (j = 0; j <= 5; j += 5) {
+        lept_set_object(&o, j);
+        EXPECT_EQ_SIZE_T(0, lept_get_object_size(&o));
+        EXPECT_EQ_SIZE_T(j, lept_get_object_capacity(&o));
+        for (i = 0; i < 10; i++) {
+            char key[2] = "a";
+            key[0] += (char)i;
+            lept_set_number(lept_set_object_value(&o, key, 1), (double)i);
+        }
+        EXPECT_EQ_SIZE_T(10, lept_get_object_size(&o));
+        for (i = 0; i < 10; i++) {
+            char key[] = "a";
+            key[0] += (char)i;
+            index = lept_find_object_index(&o, key, 1);
+            EXPECT_TRUE(index != LEPT_KEY_NOT_EXIST);
+            pv = lept_get_object_value(&o, index);
+            EXPECT_EQ_DOUBLE((double)i, lept_get_number(pv));
+        }
+    }
+
+    //ѴڵkeyԱ
+    lept_set_boolean(lept_set_object_value(&o, "a", 1), 1);
+    EXPECT_EQ_SIZE_T(10, lept_get_object_size(&o));
+    EXPECT_TRUE(lept_get_boolean(lept_find_object_value(&o, "a", 1)));
+
+    index = lept_find_object_index(&o, "j", 1);
+    EXPECT_TRUE(index != LEPT_KEY_NOT_EXIST);
+    lept_remove_object_value(&o, index);
+    index = lept_find_object_index(&o, "j", 1);
+    EXPECT_TRUE(index == LEPT_KEY_NOT_EXIST);
+    EXPECT_TRUE(lept_find_object_value(&o, "j", 1) == NULL);
+    EXPECT_EQ_SIZE_T(9, lept_get_object_size(&o));
+
+    index = lept_find_object_index(&o, "b", 1);
+    EXPECT_TRUE(index != LEPT_KEY_NOT_EXIST);
+    lept_remove_object_value(&o, index);
+    EXPECT_EQ_SIZE_T(8, lept_get_object_size(&o));
+    EXPECT_EQ_STRING("c", lept_get_object_key(&o, 1), lept_get_object_key_length(&o, 1));
+    EXPECT_EQ_DOUBLE(2.0, lept_get_number(lept_get_object_value(&o, 1)));
+
+    EXPECT_TRUE(lept_get_object_capacity(&o) > 8);
+    lept_shrink_object(&o);
+    EXPECT_EQ_SIZE_T(8, lept_get_object_capacity(&o));
+    EXPECT_EQ_SIZE_T(8, lept_get_object_size(&o));
+
+    lept_init(&v);
+    lept_set_string(&v, "Hello", 5);
+    lept_set_string(lept_set_object_value(&o, "World", 5), lept_get_string(&v), lept_get_string_length(&v));
+    lept_free(&v);
+
+    pv = lept_find_object_value(&o, "World", 5);
+    EXPECT_TRUE(pv != NULL);
+    EXPECT_EQ_STRING("Hello", lept_get_string(pv), lept_get_string_length(pv));
+
+    i = lept_get_object_capacity(&o);
+    lept_clear_object(&o);
+    EXPECT_EQ_SIZE_T(0, lept_get_object_size(&o));
+    EXPECT_EQ_SIZE_T(i, lept_get_object_capacity(&o));
+    lept_shrink_object(&o);
+    EXPECT_EQ_SIZE_T(0, lept_get_object_capacity(&o));
+
+    lept_free(&o);
+}
+
+#define TEST_PATCH(error, expect, target, patch)\
+    do{\
+        lept_value v, p;\
+        char* json;\
+        size_t length;\
+        lept_init(&v);\
+        lept_init(&p);\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, target));\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&p, patch));\
+        EXPECT_EQ_INT(error, lept_apply_patch(&v, &p));\
+        json = lept_stringify(&v, &length);\
+        EXPECT_EQ_STRING(expect, json, length);\
+        free(json);\
+        lept_free(&v);\
+        lept_free(&p);\
+    }while(0)
+
+#define TEST_MERGE_PATCH(expect, target, patch)\
+    do{\
+        lept_value v, p;\
+        char* json;\
+        size_t length;\
+        lept_init(&v);\
+        lept_init(&p);\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, target));\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&p, patch));\
+        lept_apply_merge_patch(&v, &p);\
+        json = lept_stringify(&v, &length);\
+        EXPECT_EQ_STRING(expect, json, length);\
+        free(json);\
+        lept_free(&v);\
+        lept_free(&p);\
+    }while(0)
+
+//JSON PointerңԼJSON PatchRFC 6902ͺϲRFC 7386
+static void test_patch()
+{
+    lept_value v, p;
+    const lept_value* untouched;
+
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "{\"a/b\":[1,{\"m~n\":true}],\"\":0}"));
+    EXPECT_TRUE(lept_find_pointer(&v, "", 0) == &v);
+    EXPECT_EQ_DOUBLE(0.0, lept_get_number(lept_find_pointer(&v, "/", 1)));
+    EXPECT_EQ_INT(LEPT_TRUE, lept_get_type(lept_find_pointer(&v, "/a~1b/1/m~0n", 12)));
+    EXPECT_TRUE(lept_find_pointer(&v, "/a~1b/01", 8) == NULL);
+    EXPECT_TRUE(lept_find_pointer(&v, "/a~1b/2", 7) == NULL);
+    EXPECT_TRUE(lept_find_pointer(&v, "/a~2b", 5) == NULL);
+    EXPECT_TRUE(lept_find_pointer(&v, "a", 1) == NULL);
+    lept_free(&v);
+
+    /* RFC 6902 ¼Aе */
+    TEST_PATCH(LEPT_PATCH_OK, "{\"foo\":\"bar\",\"baz\":\"qux\"}", "{\"foo\":\"bar\"}", "[{\"op\":\"add\",\"path\":\"/baz\",\"value\":\"qux\"}]");
+    TEST_PATCH(LEPT_PATCH_OK, "{\"foo\":[\"bar\",\"qux\",\"baz\"]}", "{\"foo\":[\"bar\",\"baz\"]}", "[{\"op\":\"add\",\"path\":\"/foo/1\",\"value\":\"qux\"}]");
+    TEST_PATCH(LEPT_PATCH_OK, "{\"foo\":\"bar\"}", "{\"baz\":\"qux\",\"foo\":\"bar\"}", "[{\"op\":\"remove\",\"path\":\"/baz\"}]");
+    TEST_PATCH(LEPT_PATCH_OK, "{\"foo\":[\"bar\",\"baz\"]}", "{\"foo\":[\"bar\",\"qux\",\"baz\"]}", "[{\"op\":\"remove\",\"path\":\"/foo/1\"}]");
+    TEST_PATCH(LEPT_PATCH_OK, "{\"baz\":\"boo\",\"foo\":\"bar\"}", "{\"baz\":\"qux\",\"foo\":\"bar\"}", "[{\"op\":\"replace\",\"path\":\"/baz\",\"value\":\"boo\"}]");
+    TEST_PATCH(LEPT_PATCH_OK, "{\"foo\":{\"bar\":\"baz\"},\"qux\":{\"corge\":\"grault\",\"thud\":\"fred\"}}",
+        "{\"foo\":{\"bar\":\"baz\",\"waldo\":\"fred\"},\"qux\":{\"corge\":\"grault\"}}", "[{\"op\":\"move\",\"from\":\"/foo/waldo\",\"path\":\"/qux/thud\"}]");
+    TEST_PATCH(LEPT_PATCH_OK, "{\"foo\":[\"all\",\"cows\",\"eat\",\"grass\"]}", "{\"foo\":[\"all\",\"grass\",\"cows\",\"eat\"]}", "[{\"op\":\"move\",\"from\":\"/foo/1\",\"path\":\"/foo/3\"}]");
+    TEST_PATCH(LEPT_PATCH_OK, "{\"baz\":\"qux\",\"foo\":[\"a\",2,\"c\"]}", "{\"baz\":\"qux\",\"foo\":[\"a\",2,\"c\"]}",
+        "[{\"op\":\"test\",\"path\":\"/baz\",\"value\":\"qux\"},{\"op\":\"test\",\"path\":\"/foo/1\",\"value\":2}]");
+    TEST_PATCH(LEPT_PATCH_TEST_FAILED, "{\"baz\":\"qux\"}", "{\"baz\":\"qux\"}", "[{\"op\":\"test\",\"path\":\"/baz\",\"value\":\"bar\"}]");
+    TEST_PATCH(LEPT_PATCH_OK, "{\"foo\":\"bar\",\"child\":{\"grandchild\":{}}}", "{\"foo\":\"bar\"}", "[{\"op\":\"add\",\"path\":\"/child\",\"value\":{\"grandchild\":{}}}]");
+    TEST_PATCH(LEPT_PATCH_OK, "{\"foo\":[\"bar\",[\"abc\",\"def\"]]}", "{\"foo\":[\"bar\"]}", "[{\"op\":\"add\",\"path\":\"/foo/-\",\"value\":[\"abc\",\"def\"]}]");
+    TEST_PATCH(LEPT_PATCH_OK, "{\"foo\":null}", "{\"foo\":null}", "[{\"op\":\"test\",\"path\":\"/foo\",\"value\":null}]");
+    TEST_PATCH(LEPT_PATCH_OK, "[1,2,[1,2]]", "[1,2]", "[{\"op\":\"copy\",\"from\":\"\",\"path\":\"/-\"}]");
+    TEST_PATCH(LEPT_PATCH_OK, "{\"a\":[1,2],\"b\":[1,2]}", "{\"a\":[1,2]}", "[{\"op\":\"copy\",\"from\":\"/a\",\"path\":\"/b\"}]");
+    TEST_PATCH(LEPT_PATCH_OK, "[1]", "{}", "[{\"op\":\"replace\",\"path\":\"\",\"value\":[1]}]");
+
+    /* ʱֹ֮ͣǰĲ */
+    TEST_PATCH(LEPT_PATCH_PATH_NOT_FOUND, "{\"foo\":\"bar\",\"a\":1}", "{\"foo\":\"bar\"}", "[{\"op\":\"add\",\"path\":\"/a\",\"value\":1},{\"op\":\"add\",\"path\":\"/baz/bat\",\"value\":\"qux\"}]");
+    TEST_PATCH(LEPT_PATCH_PATH_NOT_FOUND, "[1]", "[1]", "[{\"op\":\"add\",\"path\":\"/2\",\"value\":0}]");
+    TEST_PATCH(LEPT_PATCH_PATH_NOT_FOUND, "[1]", "[1]", "[{\"op\":\"remove\",\"path\":\"/-\"}]");
+    TEST_PATCH(LEPT_PATCH_PATH_NOT_FOUND, "{}", "{}", "[{\"op\":\"replace\",\"path\":\"/a\",\"value\":0}]");
+    TEST_PATCH(LEPT_PATCH_PATH_NOT_FOUND, "{}", "{}", "[{\"op\":\"move\",\"from\":\"/a\",\"path\":\"/b\"}]");
+    TEST_PATCH(LEPT_PATCH_INVALID_OPERATION, "{\"a\":{}}", "{\"a\":{}}", "[{\"op\":\"move\",\"from\":\"/a\",\"path\":\"/a/b\"}]");
+    TEST_PATCH(LEPT_PATCH_INVALID_OPERATION, "{}", "{}", "[{\"op\":\"remove\",\"path\":\"\"}]");
+    TEST_PATCH(LEPT_PATCH_INVALID_OPERATION, "{}", "{}", "[{\"op\":\"add\",\"path\":\"/a\"}]");
+    TEST_PATCH(LEPT_PATCH_INVALID_OPERATION, "{}", "{}", "[{\"op\":\"add\",\"path\":\"a\",\"value\":0}]");
+    TEST_PATCH(LEPT_PATCH_INVALID_OPERATION, "{}", "{}", "[{\"op\":\"update\",\"path\":\"/a\",\"value\":0}]");
+    TEST_PATCH(LEPT_PATCH_INVALID_OPERATION, "{}", "{}", "[{\"path\":\"/a\"}]");
+    TEST_PATCH(LEPT_PATCH_INVALID_OPERATION, "{}", "{}", "{}");
+
+    /* RFC 7386 ¼Aе */
+    TEST_MERGE_PATCH("{\"a\":\"c\"}", "{\"a\":\"b\"}", "{\"a\":\"c\"}");
+    TEST_MERGE_PATCH("{\"a\":\"b\",\"b\":\"c\"}", "{\"a\":\"b\"}", "{\"b\":\"c\"}");
+    TEST_MERGE_PATCH("{}", "{\"a\":\"b\"}", "{\"a\":null}");
+    TEST_MERGE_PATCH("{\"b\":\"c\"}", "{\"a\":\"b\",\"b\":\"c\"}", "{\"a\":null}");
+    TEST_MERGE_PATCH("{\"a\":\"c\"}", "{\"a\":[\"b\"]}", "{\"a\":\"c\"}");
+    TEST_MERGE_PATCH("{\"a\":[\"b\"]}", "{\"a\":\"c\"}", "{\"a\":[\"b\"]}");
+    TEST_MERGE_PATCH("{\"a\":{\"b\":\"d\"}}", "{\"a\":{\"b\":\"c\"}}", "{\"a\":{\"b\":\"d\",\"c\":null}}");
+    TEST_MERGE_PATCH("{\"a\":[1]}", "{\"a\":[{\"b\":\"c\"}]}", "{\"a\":[1]}");
+    TEST_MERGE_PATCH("[\"c\",\"d\"]", "[\"a\",\"b\"]", "[\"c\",\"d\"]");
+    TEST_MERGE_PATCH("{\"a\":\"foo\"}", "{\"a\":\"b\"}", "{\"a\":\"foo\"}");
+    TEST_MERGE_PATCH("null", "{\"e\":null}", "null");
+    TEST_MERGE_PATCH("\"bar\"", "{\"a\":\"foo\"}", "\"bar\"");
+    TEST_MERGE_PATCH("{\"e\":null,\"a\":1}", "{\"e\":null}", "{\"a\":1}");
+    TEST_MERGE_PATCH("{\"a\":{\"bb\":{}}}", "[1,2]", "{\"a\":{\"bb\":{\"ccc\":null}}}");
+    TEST_MERGE_PATCH("{}", "{}", "{\"a\":{\"bb\":{\"ccc\":null}},\"a\":null}");
+
+    /* δ޸ĵԭر */
+    lept_init(&v);
+    lept_init(&p);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "{\"keep\":[1,2,3],\"change\":{\"x\":1}}"));
+    untouched = lept_get_array_element(lept_find_object_value(&v, "keep", 4), 0);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&p, "[{\"op\":\"replace\",\"path\":\"/change/x\",\"value\":2},{\"op\":\"remove\",\"path\":\"/keep/2\"}]"));
+    EXPECT_EQ_INT(LEPT_PATCH_OK, lept_apply_patch(&v, &p));
+    EXPECT_TRUE(lept_get_array_element(lept_find_object_value(&v, "keep", 4), 0) == untouched);
+    lept_free(&p);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&p, "{\"change\":{\"y\":3}}"));
+    lept_apply_merge_patch(&v, &p);
+    EXPECT_TRUE(lept_get_array_element(lept_find_object_value(&v, "keep", 4), 0) == untouched);
+    EXPECT_EQ_DOUBLE(3.0, lept_get_number(lept_find_pointer(&v, "/change/y", 9)));
+    lept_free(&v);
+    lept_free(&p);
+}
+
+//ȽabɵĲѲӦõa֮b
+#define TEST_DIFF(expect, a, b)\
+    do{\
+        lept_value va, vb, p;\
+        char* json;\
+        size_t length;\
+        lept_init(&va);\
+        lept_init(&vb);\
+        lept_init(&p);\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&va, a));\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&vb, b));\
+        lept_diff(&va, &vb, &p);\
+        json = lept_stringify(&p, &length);\
+        EXPECT_EQ_STRING(expect, json, length);\
+        free(json);\
+        EXPECT_EQ_INT(LEPT_PATCH_OK, lept_apply_patch(&va, &p));\
+        EXPECT_TRUE(lept_is_equal(&va, &vb));\
+        lept_free(&va);\
+        lept_free(&vb);\
+        lept_free(&p);\
+    }while(0)
+
+//JSON Patchͬkeyƥ䣬ֻ֮ͬĲ
+static void test_diff()
+{
+    lept_value a, b, p;
+    char key[8];
+    int i;
+
+    TEST_DIFF("[]", "{\"a\":[1,{\"b\":null}],\"c\":\"x\"}", "{\"c\":\"x\",\"a\":[1,{\"b\":null}]}");
+    TEST_DIFF("[]", "-0", "0");
+    TEST_DIFF("[{\"op\":\"replace\",\"path\":\"\",\"value\":{}}]", "[]", "{}");
+    TEST_DIFF("[{\"op\":\"replace\",\"path\":\"/a/1/b\",\"value\":false}]", "{\"a\":[1,{\"b\":true}],\"c\":\"x\"}", "{\"a\":[1,{\"b\":false}],\"c\":\"x\"}");
+    TEST_DIFF("[{\"op\":\"remove\",\"path\":\"/a\"},{\"op\":\"add\",\"path\":\"/d\",\"value\":[1]}]", "{\"a\":1,\"c\":2}", "{\"c\":2,\"d\":[1]}");
+    TEST_DIFF("[{\"op\":\"replace\",\"path\":\"/a~1b/m~0n\",\"value\":2}]", "{\"a/b\":{\"m~n\":1}}", "{\"a/b\":{\"m~n\":2}}");
+    TEST_DIFF("[{\"op\":\"add\",\"path\":\"/2\",\"value\":{\"x\":1}}]", "[1,2,3,4]", "[1,2,{\"x\":1},3,4]");
+    TEST_DIFF("[{\"op\":\"remove\",\"path\":\"/2\"},{\"op\":\"remove\",\"path\":\"/1\"}]", "[1,2,3,4]", "[1,4]");
+    TEST_DIFF("[{\"op\":\"replace\",\"path\":\"/1/0\",\"value\":9},{\"op\":\"add\",\"path\":\"/2\",\"value\":5}]", "[0,[1,2],3]", "[0,[9,2],5,3]");
+    TEST_DIFF("[{\"op\":\"replace\",\"path\":\"/0\",\"value\":\"a\"},{\"op\":\"remove\",\"path\":\"/2\"}]", "[1,2,3]", "[\"a\",2]");
+
+    /* Ա϶Ķùϣkeyƥ */
+    lept_init(&a);
+    lept_init(&b);
+    lept_init(&p);
+    lept_set_object(&a, 0);
+    for (i = 0; i < 100; i++)
+    {
+        sprintf(key, "k%d", i);
+        lept_set_number(lept_set_object_value(&a, key, strlen(key)), i);
+    }
+    lept_copy(&b, &a);
+    lept_set_string(lept_find_object_value(&b, "k50", 3), "x", 1);
+    lept_remove_object_value(&b, lept_find_object_index(&b, "k7", 2));
+    lept_set_null(lept_set_object_value(&b, "new", 3));
+    lept_diff(&a, &b, &p);
+    EXPECT_EQ_SIZE_T(3, lept_get_array_size(&p));
+    EXPECT_EQ_INT(LEPT_PATCH_OK, lept_apply_patch(&a, &p));
+    EXPECT_TRUE(lept_is_equal(&a, &b));
+    lept_free(&a);
+    lept_free(&b);
+    lept_free(&p);
+}
+
+//ֻĵüдʱƺĵ
+static void test_doc()
+{
+    lept_doc* doc, * shared;
+    lept_doc_slot slot = LEPT_DOC_SLOT_INIT;
+    const lept_value* root;
+    lept_value* edit;
+
+    EXPECT_EQ_INT(LEPT_PARSE_INVALID_VALUE, lept_doc_parse(&doc, "[1,?]"));
+    EXPECT_TRUE(doc == NULL);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_doc_parse(&doc, "{\"route\":[1,2,3]}"));
+    root = lept_doc_root(doc);
+    EXPECT_EQ_SIZE_T(3, lept_get_array_size(lept_find_pointer(root, "/route", 6)));
+
+    /* ռʱԭ޸ģ */
+    edit = lept_doc_edit(&doc);
+    EXPECT_TRUE(edit == lept_doc_root(doc));
+    lept_set_number(lept_pushback_array_element(lept_touch_pointer(edit, "/route", 6)), 4.0);
+
+    /* ʱдʱƣ߿ */
+    shared = lept_doc_ref(doc);
+    edit = lept_doc_edit(&doc);
+    EXPECT_TRUE(doc != shared);
+    EXPECT_TRUE(edit != lept_doc_root(shared));
+    lept_popback_array_element(lept_find_object_value(edit, "route", 5));
+    EXPECT_EQ_SIZE_T(3, lept_get_array_size(lept_find_pointer(lept_doc_root(doc), "/route", 6)));
+    EXPECT_EQ_SIZE_T(4, lept_get_array_size(lept_find_pointer(lept_doc_root(shared), "/route", 6)));
+
+    /* ȸ£߳еľĵ滻ȻЧ */
+    EXPECT_TRUE(lept_doc_slot_load(&slot) == NULL);
+    lept_doc_slot_store(&slot, shared);
+    root = lept_doc_root(shared = lept_doc_slot_load(&slot));
+    lept_doc_slot_store(&slot, doc);
+    EXPECT_EQ_SIZE_T(4, lept_get_array_size(lept_find_pointer(root, "/route", 6)));
+    lept_doc_unref(shared);
+    doc = lept_doc_slot_load(&slot);
+    EXPECT_EQ_SIZE_T(3, lept_get_array_size(lept_find_pointer(lept_doc_root(doc), "/route", 6)));
+    lept_doc_unref(doc);
+    lept_doc_slot_store(&slot, NULL);
+}
+
+//ԿգдӳֱӶȡĽԭͬ±
+static void test_snapshot()
+{
+    static const char src[] = "{\"s\":\"a\\u0000b\\u00e9\",\"n\":[1.5,-0,1E300],\"m\":[null,true,false,\"x\",[],{},[[\"deep\"]]],\"e\":{}}";
+    static const char* path = "lept_snapshot_test.bin";
+    lept_value v, copy;
+    lept_snapshot* snap;
+    const lept_snap_node* root, * n;
+    char key[8];
+    FILE* fp;
+    int i;
+
+    lept_init(&v);
+    lept_init(&copy);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_ex(&v, src, LEPT_FLAG_PACK_NUMBERS));
+    lept_set_object(lept_set_object_value(&v, "big", 3), 0);
+    for (i = 99; i >= 0; i--)   // LEPT_SNAPSHOT_INDEX_MINkey
+    {
+        sprintf(key, "k%d", i);
+        lept_set_number(lept_set_object_value(lept_find_object_value(&v, "big", 3), key, strlen(key)), i);
+    }
+    EXPECT_EQ_INT(LEPT_SNAPSHOT_OK, lept_snapshot_write(&v, path));
+    EXPECT_EQ_INT(LEPT_SNAPSHOT_OK, lept_snapshot_open(&snap, path));
+    root = lept_snapshot_root(snap);
+    EXPECT_EQ_INT(LEPT_OBJECT, lept_snap_get_type(root));
+    EXPECT_EQ_SIZE_T(5, lept_snap_get_object_size(root));
+    EXPECT_EQ_STRING("s", lept_snap_get_object_key(root, 0), lept_snap_get_object_key_length(root, 0));
+    n = lept_snap_find_object_value(root, "s", 1);
+    EXPECT_EQ_STRING("a\0b\xC3\xA9", lept_snap_get_string(n), lept_snap_get_string_length(n));
+    n = lept_snap_find_object_value(root, "n", 1);
+    EXPECT_EQ_SIZE_T(3, lept_snap_get_array_size(n));
+    EXPECT_EQ_DOUBLE(1E300, lept_snap_get_number(lept_snap_get_array_element(n, 2)));
+    n = lept_snap_find_object_value(root, "m", 1);
+    EXPECT_TRUE(lept_snap_get_boolean(lept_snap_get_array_element(n, 1)));
+    EXPECT_EQ_SIZE_T(0, lept_snap_get_object_size(lept_snap_get_array_element(n, 5)));
+    n = lept_snap_get_array_element(lept_snap_get_array_element(lept_snap_get_array_element(n, 6), 0), 0);
+    EXPECT_EQ_STRING("deep", lept_snap_get_string(n), lept_snap_get_string_length(n));
+    n = lept_snap_find_object_value(root, "big", 3);
+    EXPECT_EQ_STRING("k99", lept_snap_get_object_key(n, 0), lept_snap_get_object_key_length(n, 0));
+    for (i = 0; i < 100; i++)
+    {
+        sprintf(key, "k%d", i);
+        EXPECT_EQ_DOUBLE((double)i, lept_snap_get_number(lept_snap_find_object_value(n, key, strlen(key))));
+    }
+    EXPECT_TRUE(lept_snap_find_object_value(n, "k", 1) == NULL);
+    EXPECT_TRUE(lept_snap_find_object_value(n, "k100", 4) == NULL);
+    EXPECT_TRUE(lept_snap_find_object_value(root, "x", 1) == NULL);
+    lept_snap_copy(&copy, root);
+    EXPECT_TRUE(lept_is_equal(&copy, &v));
+    lept_snapshot_close(snap);
+    lept_free(&copy);
+
+    //ǱеĿ
+    lept_set_string(&v, "root", 4);
+    EXPECT_EQ_INT(LEPT_SNAPSHOT_OK, lept_snapshot_write(&v, path));
+    EXPECT_EQ_INT(LEPT_SNAPSHOT_OK, lept_snapshot_open(&snap, path));
+    EXPECT_EQ_STRING("root", lept_snap_get_string(lept_snapshot_root(snap)), lept_snap_get_string_length(lept_snapshot_root(snap)));
+    lept_snapshot_close(snap);
+
+    //ضϵļͲǿյļ
+    fp = fopen(path, "wb");
+    fputs("{\"a\":1}", fp);
+    fclose(fp);
+    EXPECT_EQ_INT(LEPT_SNAPSHOT_INVALID, lept_snapshot_open(&snap, path));
+    EXPECT_TRUE(snap == NULL);
+    lept_set_array(&v, 0);
+    EXPECT_EQ_INT(LEPT_SNAPSHOT_OK, lept_snapshot_write(&v, path));
+    fp = fopen(path, "ab");
+    fputs("garbage!", fp);
+    fclose(fp);
+    EXPECT_EQ_INT(LEPT_SNAPSHOT_INVALID, lept_snapshot_open(&snap, path));
+    remove(path);
+    EXPECT_EQ_INT(LEPT_SNAPSHOT_IO_ERROR, lept_snapshot_open(&snap, path));
+    lept_free(&v);
+}
+
 static void test_access() {
     test_access_null();
     test_access_boolean();
     test_access_number();
     test_access_string();
+    test_access_array();
+    test_access_object();
+    test_equal();
+    test_copy();
+    test_move();
+    test_swap();
+    test_compact();
+    test_patch();
+    test_diff();
+    test_doc();
+    test_snapshot();
 }
 
 int main() {
@@ -537,6 +2087,7 @@ int main() {
 #endif
     test_parse();
     test_stringify();
+    test_binary();
     test_access();
     printf("%d/%d (%3.2f%%) passed\n", test_pass, test_count, test_pass * 100.0 / test_count);
     return main_ret;
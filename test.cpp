@@ -0,0 +1,198 @@
+//C++封装 leptjson.hpp 的测试
+#include "leptjson.hpp"
+#if __cplusplus >= 202002L
+#include "leptjson_literal.hpp"
+#endif
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static int main_ret = 0;
+static int test_count = 0;
+static int test_pass = 0;
+
+#define EXPECT_TRUE(expr)\
+    do {\
+        test_count++;\
+        if (expr)\
+            test_pass++;\
+        else {\
+            std::fprintf(stderr, "%s:%d: expect: %s\n", __FILE__, __LINE__, #expr);\
+            main_ret = 1;\
+        }\
+    } while(0)
+
+//测试移动语义：移动只转移所有权，不复制子树
+static void test_move()
+{
+    lept::value a;
+    EXPECT_TRUE(a.parse("{\"k\":[1,2,3]}") == LEPT_PARSE_OK);
+    const lept_member* tree = a.c_ptr()->u.o.m;
+    lept::value b(std::move(a));
+    EXPECT_TRUE(a.is_null());
+    EXPECT_TRUE(b.c_ptr()->u.o.m == tree);
+    lept::value c;
+    c = std::move(b);
+    EXPECT_TRUE(b.is_null() && c.c_ptr()->u.o.m == tree);
+
+    std::vector<lept::value> values;
+    values.push_back(std::move(c));
+    values.emplace_back();
+    values.emplace_back();
+    EXPECT_TRUE(values[0].c_ptr()->u.o.m == tree);
+
+    lept::value d = values[0].clone();
+    EXPECT_TRUE(d == values[0] && d.c_ptr()->u.o.m != tree);
+}
+
+//测试访问：string_view、下标、key以及range-for
+static void test_access()
+{
+    lept::value v;
+    EXPECT_TRUE(v.parse("{\"name\":\"a\\u0000b\",\"list\":[1,2,3],\"flag\":true}") == LEPT_PARSE_OK);
+    EXPECT_TRUE(v.size() == 3);
+    EXPECT_TRUE(v["name"].get_string() == std::string_view("a\0b", 3));
+    EXPECT_TRUE(v["flag"].get_bool());
+    EXPECT_TRUE(v.find("missing") == nullptr);
+
+    double sum = 0;
+    for (const lept::value& e : v["list"])
+        sum += e.get_number();
+    EXPECT_TRUE(sum == 6.0);
+    EXPECT_TRUE(v["list"][1].get_number() == 2.0);
+
+    std::string keys;
+    for (const lept::member& m : v.members())
+        keys += m.key();
+    EXPECT_TRUE(keys == "namelistflag");
+
+    const lept::value& cv = v;
+    EXPECT_TRUE(cv["list"].size() == 3);
+    EXPECT_TRUE(cv.find("name") == &cv["name"]);
+
+    v["new"].set_string("x");
+    v["list"].push_back().set_number(4.0);
+    v["list"][0].set_null();
+    EXPECT_TRUE(v.size() == 4);
+    EXPECT_TRUE(v["list"].size() == 4 && v["list"][0].is_null());
+    EXPECT_TRUE(v["new"].get_string() == "x");
+
+    lept::value empty;
+    empty.set_array();
+    for (lept::value& e : empty)
+        e.set_null();
+    EXPECT_TRUE(empty.begin() == empty.end());
+
+    EXPECT_TRUE(v.parse("{\"s\":\"a\\tb\",\"n\":0.50}", LEPT_FLAG_LAZY) == LEPT_PARSE_OK);
+    EXPECT_TRUE(v["s"].get_string() == "a\tb" && v["n"].get_number() == 0.5);
+
+    std::size_t n = 0;
+    EXPECT_TRUE(v.parse("[1.5,2,3]", LEPT_FLAG_PACK_NUMBERS) == LEPT_PARSE_OK);
+    EXPECT_TRUE(v.doubles(n) != nullptr && n == 3);
+    //只读访问不展开，非const访问才展开
+    EXPECT_TRUE(cv.number_at(0) == 1.5 && cv.number_at(2) == 3.0 && v.doubles(n) != nullptr);
+    //紧凑数组没有元素节点，只读下标和遍历在任何构建模式下都拒绝
+    bool threw = false;
+    try { (void)cv[0]; } catch (const std::logic_error&) { threw = true; }
+    EXPECT_TRUE(threw && v.doubles(n) != nullptr);
+    threw = false;
+    try { (void)cv.begin(); } catch (const std::logic_error&) { threw = true; }
+    EXPECT_TRUE(threw && v.doubles(n) != nullptr);
+    EXPECT_TRUE(v[2].get_number() == 3.0 && v.doubles(n) == nullptr);
+    EXPECT_TRUE(cv[1].get_number() == 2.0 && cv.number_at(1) == 2.0);
+
+    EXPECT_TRUE(v.parse("[1,?]") == LEPT_PARSE_INVALID_VALUE);
+    EXPECT_TRUE(v.is_null());
+}
+
+#if __cplusplus >= 202002L
+using namespace lept::literals;
+
+struct endpoint
+{
+    std::string_view host;
+    int port = 0;
+};
+
+struct config
+{
+    endpoint server;
+    double timeout = 0;
+    bool verbose = false;
+    std::string name;
+};
+
+template <>
+struct lept::schema<endpoint>
+{
+    static constexpr auto fields = std::make_tuple(lept::bind("host", &endpoint::host), lept::bind("port", &endpoint::port));
+};
+
+template <>
+struct lept::schema<config>
+{
+    static constexpr auto fields = std::make_tuple(
+        lept::bind("server", &config::server),
+        lept::bind("timeout", &config::timeout),
+        lept::bind("verbose", &config::verbose),
+        lept::bind("name", &config::name));
+};
+
+//测试编译期字面量：断言都在编译期求值，不合法的字面量（如 "[1,]"_json）无法通过编译
+static void test_literal()
+{
+    constexpr lept::static_value v = R"( {"n":[0, -1.5, 1e3, 1E-2, 0.1, 1.7976931348623157e308], "s":"a\u0000\n\uD834\uDD1E", "t":true, "f":false, "z":null, "e":{}, "a":[]} )"_json;
+    static_assert(v.is_object() && v.size() == 7);
+    static_assert(v["n"].size() == 6);
+    static_assert(v["n"][0].get_number() == 0.0 && v["n"][1].get_number() == -1.5 && v["n"][2].get_number() == 1000.0);
+    static_assert(v["n"][3].get_number() == 0.01 && v["n"][4].get_number() == 0.1);
+    static_assert(v["n"][5].get_number() == 1.7976931348623157e308);
+    static_assert(v["s"].get_string() == std::string_view("a\0\n\xF0\x9D\x84\x9E", 7));
+    static_assert(v["t"].get_bool() && !v["f"].get_bool() && v["z"].is_null());
+    static_assert(v["e"].is_object() && v["e"].size() == 0 && v["a"].is_array() && v["a"].size() == 0);
+    static_assert(!v.find("missing"));
+    static_assert(v[2].key() == "t");
+
+    //与运行时解析的结果一致
+    lept::value parsed;
+    EXPECT_TRUE(parsed.parse(R"({"n":[0, -1.5, 1e3, 1E-2, 0.1, 1.7976931348623157e308], "s":"a\u0000\n\uD834\uDD1E", "t":true, "f":false, "z":null, "e":{}, "a":[]})") == LEPT_PARSE_OK);
+    EXPECT_TRUE(v.to_value() == parsed);
+    EXPECT_TRUE(R"("x")"_json.to_value().get_string() == "x");
+
+    double sum = 0;
+    for (lept::static_value e : v["n"])
+        sum += e.get_number() < 1e300 ? e.get_number() : 0;
+    EXPECT_TRUE(sum == -1.5 + 1000.0 + 0.01 + 0.1);
+
+    //运行时查找不存在的key得到null节点
+    std::string missing = "missing";
+    EXPECT_TRUE(v[missing].is_null() && v[missing].size() == 0 && v["e"][missing].is_null());
+    EXPECT_TRUE(v[missing].to_value().is_null());
+
+    //编译期绑定
+    constexpr endpoint ep = lept::decode<endpoint>(R"({"host":"localhost","port":8080,"other":1})"_json);
+    static_assert(ep.host == "localhost" && ep.port == 8080);
+
+    //运行时绑定
+    config c;
+    c.timeout = 30;
+    EXPECT_TRUE(parsed.parse(R"({"server":{"host":"example.com","port":443},"verbose":true,"name":"svc"})") == LEPT_PARSE_OK);
+    EXPECT_TRUE(lept::decode(parsed, c));
+    EXPECT_TRUE(c.server.host == "example.com" && c.server.port == 443);
+    EXPECT_TRUE(c.timeout == 30 && c.verbose && c.name == "svc");
+    EXPECT_TRUE(parsed.parse(R"({"server":{"port":"443"}})") == LEPT_PARSE_OK);
+    EXPECT_TRUE(!lept::decode(parsed, c));
+}
+#endif
+
+int main()
+{
+    test_move();
+    test_access();
+#if __cplusplus >= 202002L
+    test_literal();
+#endif
+    std::printf("%d/%d (%3.2f%%) passed\n", test_pass, test_count, test_pass * 100.0 / test_count);
+    return main_ret;
+}